@@ -1,4 +1,4 @@
-#include "aisDecode.h"
+#include "aisdecode.h"
 #include<stdio.h>
 int binToDec(int* bitVector, int size);
 int twosComplement(int val, int size);
@@ -24,6 +24,62 @@ int getFromMessage(int* inputVector, int start, int end){
 }
 
 
+/*
+Fonction : getUnsignedFromMessage
+Entrées : vecteur de bits d'entrée, position de départ, position de fin
+Sorties : l'entier non signé donné par les bits entre les deux positions
+Utile pour les champs non signés (MMSI, numéro de partie, codes 6 bits...)
+*/
+unsigned int getUnsignedFromMessage(int* inputVector, int start, int end){
+    unsigned int result = 0;
+    for(int i=start;i<end;i++){
+        result = (result<<1) | (*(inputVector+i)&1);
+    }
+    return result;
+}
+
+/*
+Fonction : getStringFromMessage
+Entrées : vecteur de bits d'entrée, position de départ, position de fin, chaîne pour recevoir la sortie
+Sorties : 
+Décode le texte ASCII 6 bits AIS entre les deux positions. Les '@' et espaces de
+remplissage en fin de champ sont retirés. La chaîne doit contenir (end-start)/6+1 caractères.
+*/
+void getStringFromMessage(int* inputVector, int start, int end, char* output){
+    int size = 0;
+    for(int i=start;i+6<=end;i+=6){
+        int code = getUnsignedFromMessage(inputVector,i,i+6);
+        *(output+size) = code<32 ? code+64 : code;
+        size += 1;
+    }
+    while(size>0 && (*(output+size-1)=='@' || *(output+size-1)==' ')){
+        size -= 1;
+    }
+    *(output+size) = '\0';
+}
+
+/*
+Fonction : decodePositionReport
+Entrées : vecteur de bits d'entrée, taille du vecteur, date de réception, message pour recevoir la sortie
+Sorties : 1 si le vecteur contient un rapport de position (types 1, 2 et 3), 0 sinon
+Décode le type, le MMSI, la position (en degrés) et le cap
+*/
+int decodePositionReport(int* inputVector, int size, double timestamp, struct aisMessage* message){
+    if(size < 128){
+        return 0;
+    }
+    message->messageType = getFromMessage(inputVector,0,6);
+    if(message->messageType < 1 || message->messageType > 3){
+        return 0;
+    }
+    message->timestamp = timestamp;
+    message->mmsi = getUnsignedFromMessage(inputVector,8,38);
+    message->latitude = getFromMessage(inputVector,89,116)/10000.0/60.0;
+    message->longitude = getFromMessage(inputVector,61,89)/10000.0/60.0;
+    message->course = getUnsignedFromMessage(inputVector,116,128)/10.0;
+    return 1;
+}
+
 int binToDec(int* bitVector, int size){
     int result = 0;
     for(int i=0;i<size;i++){
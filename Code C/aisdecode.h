@@ -5,7 +5,19 @@
 #include <math.h>
 #include <stdlib.h>
 
+struct aisMessage
+{
+    double timestamp;
+    int messageType;
+    unsigned int mmsi;
+    double latitude, longitude;
+    double course;
+};
+
 int getFromMessage(int* inputVector, int start, int end);
+unsigned int getUnsignedFromMessage(int* inputVector, int start, int end);
+void getStringFromMessage(int* inputVector, int start, int end, char* output);
+int decodePositionReport(int* inputVector, int size, double timestamp, struct aisMessage* message);
 
 
 #endif
\ No newline at end of file
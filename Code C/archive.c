@@ -0,0 +1,404 @@
+#include "archive.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ARCHIVE_MAGIC "AISARCH2"
+#define BLOCK_MAGIC 0x314b4c42
+#define MAX_BYTES_PER_MESSAGE 32
+
+int putVarint(uint8_t* output, uint64_t value);
+int getVarint(const uint8_t* input, const uint8_t* end, uint64_t* value);
+uint64_t zigzag(int64_t value);
+int64_t unzigzag(uint64_t value);
+void bloomAdd(uint8_t* bloom, unsigned int mmsi);
+int bloomContains(const uint8_t* bloom, unsigned int mmsi);
+int decodeBlock(const uint8_t* data, const uint8_t* end, int nbMessages, struct aisMessage* messages);
+int validBlockHeader(struct archiveReader* reader, size_t offset, struct archiveBlockHeader* header);
+size_t findNextBlock(struct archiveReader* reader, size_t offset);
+int endsBlock(struct archiveReader* reader, size_t offset);
+
+/*
+Fonction : openArchiveWriter
+Entrées : chemin de l'archive
+Sorties : l'écrivain, NULL en cas d'erreur (y compris si le fichier existant n'est pas une archive)
+L'archive est ouverte en ajout : les blocs écrits s'ajoutent aux blocs existants. Les
+dates sont en secondes UTC depuis le 1er janvier 1970, si bien que les blocs de
+plusieurs exécutions restent comparables.
+*/
+struct archiveWriter* openArchiveWriter(const char* path){
+    struct archiveWriter* writer = (struct archiveWriter*) calloc(1,sizeof(struct archiveWriter));
+    if(writer == NULL){
+        return NULL;
+    }
+    writer->file = fopen(path,"a+b");
+    writer->messages = (struct aisMessage*) malloc(ARCHIVE_BLOCK_MESSAGES*sizeof(struct aisMessage));
+    writer->data = (uint8_t*) malloc(ARCHIVE_BLOCK_MESSAGES*MAX_BYTES_PER_MESSAGE);
+    if(writer->file == NULL || writer->messages == NULL || writer->data == NULL){
+        closeArchiveWriter(writer);
+        return NULL;
+    }
+    fseek(writer->file,0,SEEK_END);
+    if(ftell(writer->file) == 0){
+        fwrite(ARCHIVE_MAGIC,1,8,writer->file);
+        return writer;
+    }
+    char magic[8];
+    fseek(writer->file,0,SEEK_SET);
+    if(fread(magic,1,8,writer->file) != 8 || memcmp(magic,ARCHIVE_MAGIC,8) != 0){
+        closeArchiveWriter(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+/*
+Fonction : appendToArchive
+Entrées : écrivain, message décodé
+Sorties : 0 en cas de succès, -1 en cas d'erreur d'écriture
+Le message est mis en attente ; le bloc est écrit quand il est plein.
+*/
+int appendToArchive(struct archiveWriter* writer, struct aisMessage* message){
+    *(writer->messages+writer->nbMessages) = *message;
+    writer->nbMessages += 1;
+    if(writer->nbMessages == ARCHIVE_BLOCK_MESSAGES){
+        return flushArchive(writer);
+    }
+    return 0;
+}
+
+/*
+Fonction : flushArchive
+Entrées : écrivain
+Sorties : 0 en cas de succès, -1 en cas d'erreur d'écriture
+Écrit les messages en attente sous forme d'un bloc en colonnes : dates, MMSI,
+latitudes, longitudes, caps puis types. Les dates (en ms) et les positions
+(en 1/10000 de minute) sont codées en différences successives, toutes les
+valeurs en entiers de longueur variable.
+*/
+int flushArchive(struct archiveWriter* writer){
+    if(writer->nbMessages == 0){
+        return 0;
+    }
+    struct archiveBlockHeader header;
+    memset(&header,0,sizeof(header));
+    header.magic = BLOCK_MAGIC;
+    header.nbMessages = writer->nbMessages;
+    header.minTimestamp = writer->messages->timestamp;
+    header.maxTimestamp = writer->messages->timestamp;
+
+    uint8_t* output = writer->data;
+    int64_t previous = 0;
+    for(int i=0; i<writer->nbMessages; i++){
+        struct aisMessage* message = writer->messages+i;
+        int64_t milliseconds = llround(message->timestamp*1000.0);
+        output += putVarint(output,zigzag(milliseconds-previous));
+        previous = milliseconds;
+        header.minTimestamp = fmin(header.minTimestamp,message->timestamp);
+        header.maxTimestamp = fmax(header.maxTimestamp,message->timestamp);
+    }
+    for(int i=0; i<writer->nbMessages; i++){
+        output += putVarint(output,(writer->messages+i)->mmsi);
+        bloomAdd(header.bloom,(writer->messages+i)->mmsi);
+    }
+    previous = 0;
+    for(int i=0; i<writer->nbMessages; i++){
+        int64_t latitude = llround((writer->messages+i)->latitude*600000.0);
+        output += putVarint(output,zigzag(latitude-previous));
+        previous = latitude;
+    }
+    previous = 0;
+    for(int i=0; i<writer->nbMessages; i++){
+        int64_t longitude = llround((writer->messages+i)->longitude*600000.0);
+        output += putVarint(output,zigzag(longitude-previous));
+        previous = longitude;
+    }
+    for(int i=0; i<writer->nbMessages; i++){
+        output += putVarint(output,llround((writer->messages+i)->course*10.0));
+    }
+    for(int i=0; i<writer->nbMessages; i++){
+        *output = (writer->messages+i)->messageType;
+        output += 1;
+    }
+    header.dataSize = output-writer->data;
+
+    writer->nbMessages = 0;
+    if(fwrite(&header,sizeof(header),1,writer->file) != 1
+        || fwrite(writer->data,1,header.dataSize,writer->file) != header.dataSize){
+        return -1;
+    }
+    return fflush(writer->file) == 0 ? 0 : -1;
+}
+
+/*
+Fonction : closeArchiveWriter
+Entrées : écrivain
+Sorties : 0 en cas de succès, -1 en cas d'erreur d'écriture
+Écrit le dernier bloc incomplet puis ferme l'archive.
+*/
+int closeArchiveWriter(struct archiveWriter* writer){
+    int status = 0;
+    if(writer == NULL){
+        return 0;
+    }
+    if(writer->file != NULL){
+        if(writer->messages != NULL && writer->data != NULL){
+            status = flushArchive(writer);
+        }
+        fclose(writer->file);
+    }
+    free(writer->messages);
+    free(writer->data);
+    free(writer);
+    return status;
+}
+
+/*
+Fonction : openArchiveReader
+Entrées : chemin de l'archive
+Sorties : le lecteur, NULL en cas d'erreur
+L'archive est projetée en mémoire : seules les pages des blocs lus sont chargées.
+*/
+struct archiveReader* openArchiveReader(const char* path){
+    int fd = open(path,O_RDONLY);
+    if(fd < 0){
+        return NULL;
+    }
+    struct stat status;
+    if(fstat(fd,&status) < 0 || status.st_size < 8){
+        close(fd);
+        return NULL;
+    }
+    struct archiveReader* reader = (struct archiveReader*) calloc(1,sizeof(struct archiveReader));
+    if(reader == NULL){
+        close(fd);
+        return NULL;
+    }
+    reader->size = status.st_size;
+    reader->map = (uint8_t*) mmap(NULL,reader->size,PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+    if(reader->map == MAP_FAILED || memcmp(reader->map,ARCHIVE_MAGIC,8) != 0){
+        if(reader->map != MAP_FAILED){
+            munmap(reader->map,reader->size);
+        }
+        free(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+/*
+Fonction : queryArchive
+Entrées : lecteur, intervalle de dates, MMSI recherché (0 pour tous), fonction appelée pour chaque message, contexte passé à la fonction
+Sorties : le nombre de messages trouvés, -1 en cas d'erreur d'allocation
+Les blocs dont l'intervalle de dates ne recoupe pas la requête, ou dont le filtre de
+Bloom exclut le MMSI, sont sautés sans lire leurs données. Un bloc incomplet
+(écriture interrompue) ou corrompu est signalé et compté dans corruptedRanges et
+corruptedBytes, puis la lecture reprend au bloc valide suivant : les blocs ajoutés
+après lui restent lisibles.
+*/
+int queryArchive(struct archiveReader* reader, double minTimestamp, double maxTimestamp, unsigned int mmsi, void (*callback)(struct aisMessage*, void*), void* context){
+    struct aisMessage* messages = (struct aisMessage*) malloc(ARCHIVE_BLOCK_MESSAGES*sizeof(struct aisMessage));
+    struct archiveBlockHeader header;
+    size_t offset = 8;
+    int count = 0;
+    if(messages == NULL){
+        return -1;
+    }
+    while(offset < reader->size){
+        if(!validBlockHeader(reader,offset,&header)){
+            size_t next = findNextBlock(reader,offset+1);
+            fprintf(stderr,"Corrupted archive data skipped from byte %zu to %zu\n",offset,next);
+            reader->corruptedRanges += 1;
+            reader->corruptedBytes += next-offset;
+            offset = next;
+            continue;
+        }
+        const uint8_t* data = reader->map+offset+sizeof(header);
+        if(header.maxTimestamp < minTimestamp || header.minTimestamp > maxTimestamp
+            || (mmsi != 0 && !bloomContains(header.bloom,mmsi))){
+            reader->blocksSkipped += 1;
+            offset += sizeof(header)+header.dataSize;
+            continue;
+        }
+        if(decodeBlock(data,data+header.dataSize,header.nbMessages,messages) < 0){
+            // En-tête plausible mais données illisibles : traité comme un bloc corrompu
+            size_t next = findNextBlock(reader,offset+1);
+            fprintf(stderr,"Corrupted archive data skipped from byte %zu to %zu\n",offset,next);
+            reader->corruptedRanges += 1;
+            reader->corruptedBytes += next-offset;
+            offset = next;
+            continue;
+        }
+        reader->blocksRead += 1;
+        reader->bytesRead += header.dataSize;
+        offset += sizeof(header)+header.dataSize;
+        for(unsigned int i=0; i<header.nbMessages; i++){
+            struct aisMessage* message = messages+i;
+            if(message->timestamp >= minTimestamp && message->timestamp <= maxTimestamp
+                && (mmsi == 0 || message->mmsi == mmsi)){
+                callback(message,context);
+                count += 1;
+            }
+        }
+    }
+    free(messages);
+    return count;
+}
+
+/*
+Fonction : validBlockHeader
+Entrées : lecteur, position de l'en-tête, en-tête à remplir
+Sorties : 1 si un bloc complet et plausible commence à cette position, 0 sinon
+Le bloc doit finir à la fin de l'archive ou au début d'un autre bloc : un bloc
+interrompu suivi d'un ajout ne fait pas lire le bloc suivant comme ses données.
+*/
+int validBlockHeader(struct archiveReader* reader, size_t offset, struct archiveBlockHeader* header){
+    if(offset+sizeof(struct archiveBlockHeader) > reader->size){
+        return 0;
+    }
+    memcpy(header,reader->map+offset,sizeof(struct archiveBlockHeader));
+    return header->magic == BLOCK_MAGIC && header->nbMessages > 0 && header->nbMessages <= ARCHIVE_BLOCK_MESSAGES
+        && header->dataSize <= reader->size-offset-sizeof(struct archiveBlockHeader)
+        && header->minTimestamp <= header->maxTimestamp
+        && endsBlock(reader,offset+sizeof(struct archiveBlockHeader)+header->dataSize);
+}
+
+int endsBlock(struct archiveReader* reader, size_t offset){
+    uint32_t magic = BLOCK_MAGIC;
+    return offset == reader->size || (offset+sizeof(magic) <= reader->size && memcmp(reader->map+offset,&magic,sizeof(magic)) == 0);
+}
+
+/*
+Fonction : findNextBlock
+Entrées : lecteur, position à partir de laquelle chercher
+Sorties : la position du prochain en-tête de bloc valide, la taille de l'archive s'il n'y en a plus
+*/
+size_t findNextBlock(struct archiveReader* reader, size_t offset){
+    struct archiveBlockHeader header;
+    uint32_t magic = BLOCK_MAGIC;
+    for(; offset+sizeof(header) <= reader->size; offset++){
+        if(memcmp(reader->map+offset,&magic,sizeof(magic)) == 0 && validBlockHeader(reader,offset,&header)){
+            return offset;
+        }
+    }
+    return reader->size;
+}
+
+void closeArchiveReader(struct archiveReader* reader){
+    if(reader == NULL){
+        return;
+    }
+    munmap(reader->map,reader->size);
+    free(reader);
+}
+
+/*
+Fonction : decodeBlock
+Entrées : début et fin des données du bloc, nombre de messages, tableau pour recevoir les messages
+Sorties : 0 en cas de succès, -1 si les données sont tronquées
+*/
+int decodeBlock(const uint8_t* data, const uint8_t* end, int nbMessages, struct aisMessage* messages){
+    uint64_t value;
+    int64_t previous = 0;
+    int size;
+    for(int i=0; i<nbMessages; i++){
+        if((size = getVarint(data,end,&value)) < 0){
+            return -1;
+        }
+        data += size;
+        previous += unzigzag(value);
+        (messages+i)->timestamp = previous/1000.0;
+    }
+    for(int i=0; i<nbMessages; i++){
+        if((size = getVarint(data,end,&value)) < 0){
+            return -1;
+        }
+        data += size;
+        (messages+i)->mmsi = value;
+    }
+    previous = 0;
+    for(int i=0; i<nbMessages; i++){
+        if((size = getVarint(data,end,&value)) < 0){
+            return -1;
+        }
+        data += size;
+        previous += unzigzag(value);
+        (messages+i)->latitude = previous/600000.0;
+    }
+    previous = 0;
+    for(int i=0; i<nbMessages; i++){
+        if((size = getVarint(data,end,&value)) < 0){
+            return -1;
+        }
+        data += size;
+        previous += unzigzag(value);
+        (messages+i)->longitude = previous/600000.0;
+    }
+    for(int i=0; i<nbMessages; i++){
+        if((size = getVarint(data,end,&value)) < 0){
+            return -1;
+        }
+        data += size;
+        (messages+i)->course = value/10.0;
+    }
+    if(end-data < nbMessages){
+        return -1;
+    }
+    for(int i=0; i<nbMessages; i++){
+        (messages+i)->messageType = *(data+i);
+    }
+    return 0;
+}
+
+int putVarint(uint8_t* output, uint64_t value){
+    int size = 0;
+    while(value >= 0x80){
+        *(output+size) = (value & 0x7f) | 0x80;
+        value >>= 7;
+        size += 1;
+    }
+    *(output+size) = value;
+    return size+1;
+}
+
+int getVarint(const uint8_t* input, const uint8_t* end, uint64_t* value){
+    *value = 0;
+    for(int size=0; size<10 && input+size<end; size++){
+        *value |= (uint64_t)(*(input+size) & 0x7f) << (7*size);
+        if(!(*(input+size) & 0x80)){
+            return size+1;
+        }
+    }
+    return -1;
+}
+
+uint64_t zigzag(int64_t value){
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value){
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+void bloomAdd(uint8_t* bloom, unsigned int mmsi){
+    uint32_t h1 = mmsi*2654435761u;
+    uint32_t h2 = (mmsi ^ (mmsi >> 16))*0x45d9f3bu | 1;
+    for(int i=0; i<ARCHIVE_BLOOM_HASHES; i++){
+        uint32_t bit = (h1+i*h2) % (ARCHIVE_BLOOM_BYTES*8);
+        *(bloom+bit/8) |= 1 << (bit%8);
+    }
+}
+
+int bloomContains(const uint8_t* bloom, unsigned int mmsi){
+    uint32_t h1 = mmsi*2654435761u;
+    uint32_t h2 = (mmsi ^ (mmsi >> 16))*0x45d9f3bu | 1;
+    for(int i=0; i<ARCHIVE_BLOOM_HASHES; i++){
+        uint32_t bit = (h1+i*h2) % (ARCHIVE_BLOOM_BYTES*8);
+        if(!(*(bloom+bit/8) & (1 << (bit%8)))){
+            return 0;
+        }
+    }
+    return 1;
+}
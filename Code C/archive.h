@@ -0,0 +1,51 @@
+#ifndef HEADER_ARCHIVE
+#define HEADER_ARCHIVE
+
+#include "aisdecode.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARCHIVE_BLOCK_MESSAGES 4096
+#define ARCHIVE_BLOOM_BYTES 512
+#define ARCHIVE_BLOOM_HASHES 3
+
+struct archiveBlockHeader
+{
+    uint32_t magic;
+    uint32_t nbMessages;
+    uint32_t dataSize;
+    uint32_t reserved;
+    double minTimestamp, maxTimestamp;
+    uint8_t bloom[ARCHIVE_BLOOM_BYTES];
+};
+
+struct archiveWriter
+{
+    FILE* file;
+    int nbMessages;
+    struct aisMessage* messages;
+    uint8_t* data;
+};
+
+struct archiveReader
+{
+    uint8_t* map;
+    size_t size;
+    size_t bytesRead;
+    int blocksRead;
+    int blocksSkipped;
+    int corruptedRanges;
+    size_t corruptedBytes;
+};
+
+struct archiveWriter* openArchiveWriter(const char* path);
+int appendToArchive(struct archiveWriter* writer, struct aisMessage* message);
+int flushArchive(struct archiveWriter* writer);
+int closeArchiveWriter(struct archiveWriter* writer);
+struct archiveReader* openArchiveReader(const char* path);
+int queryArchive(struct archiveReader* reader, double minTimestamp, double maxTimestamp, unsigned int mmsi, void (*callback)(struct aisMessage*, void*), void* context);
+void closeArchiveReader(struct archiveReader* reader);
+
+#endif
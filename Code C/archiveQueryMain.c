@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include "archive.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+
+double parseDate(const char* value);
+void printMessage(struct aisMessage* message, void* context);
+
+/*
+Interrogation d'une archive écrite par main -a : affiche en CSV (date UTC, MMSI, type,
+latitude, longitude, cap) les rapports de position reçus entre deux dates, pour un
+navire avec -m ou pour tous. Les dates se donnent en ISO 8601 UTC
+(2024-05-01T12:00:00) ou en secondes depuis 1970. Le nombre de blocs lus et sautés
+grâce à leur intervalle de dates et à leur filtre de Bloom est écrit sur la sortie
+d'erreur.
+*/
+int main(int argc, char** argv)
+{
+   int option;
+   double minTimestamp = 0;
+   double maxTimestamp = 1e12;
+   unsigned int mmsi = 0;
+   while((option = getopt(argc, argv, "f:m:t:")) != -1){
+      switch(option){
+      case 'f':
+         minTimestamp = parseDate(optarg);
+         break;
+      case 'm':
+         mmsi = strtoul(optarg, NULL, 10);
+         break;
+      case 't':
+         maxTimestamp = parseDate(optarg);
+         break;
+      default:
+         fprintf(stderr, "Usage : %s [-f from] [-t to] [-m mmsi] archive\n", argv[0]);
+         return(1);
+      }
+   }
+   if(optind >= argc || minTimestamp < 0 || maxTimestamp < 0){
+      fprintf(stderr, "Usage : %s [-f from] [-t to] [-m mmsi] archive\n", argv[0]);
+      return(1);
+   }
+   struct archiveReader *reader = openArchiveReader(argv[optind]);
+   if(reader == NULL){
+      fprintf(stderr, "Cannot open archive %s\n", argv[optind]);
+      return(1);
+   }
+   printf("date,mmsi,type,latitude,longitude,course\n");
+   int count = queryArchive(reader, minTimestamp, maxTimestamp, mmsi, printMessage, NULL);
+   fflush(stdout);
+   if(count < 0){
+      fprintf(stderr, "Cannot query archive %s\n", argv[optind]);
+   } else {
+      fprintf(stderr, "%d messages, %d blocks read (%zu bytes), %d skipped, %d corrupted ranges (%zu bytes)\n", count, reader->blocksRead,
+         reader->bytesRead, reader->blocksSkipped, reader->corruptedRanges, reader->corruptedBytes);
+   }
+   closeArchiveReader(reader);
+   return(count < 0);
+}
+
+/*
+Fonction : parseDate
+Entrées : date ISO 8601 UTC ou nombre de secondes depuis 1970
+Sorties : la date en secondes depuis 1970, -1 si elle n'est pas lisible
+*/
+double parseDate(const char* value)
+{
+   struct tm date;
+   double seconds = 0;
+   char *end;
+   memset(&date, 0, sizeof(date));
+   if(sscanf(value, "%d-%d-%dT%d:%d:%lf", &date.tm_year, &date.tm_mon, &date.tm_mday, &date.tm_hour, &date.tm_min, &seconds) >= 3){
+      date.tm_year -= 1900;
+      date.tm_mon -= 1;
+      return (double)timegm(&date)+seconds;
+   }
+   seconds = strtod(value, &end);
+   return end != value && *end == '\0' ? seconds : -1;
+}
+
+void printMessage(struct aisMessage* message, void* context)
+{
+   char date[32];
+   (void)context;
+   // Les dates sont archivées à la milliseconde
+   long long milliseconds = llround(message->timestamp*1000.0);
+   time_t seconds = milliseconds/1000;
+   strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", gmtime(&seconds));
+   printf("%s.%03dZ,%u,%d,%.6f,%.6f,%.1f\n", date, (int)(milliseconds%1000), message->mmsi,
+      message->messageType, message->latitude, message->longitude, message->course);
+}
@@ -0,0 +1,309 @@
+#include "asyncReader.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+void* readerThread(void* argument);
+int readWithPread(struct asyncReader* reader);
+#ifdef HAVE_LIBURING
+int readWithUring(struct asyncReader* reader);
+#endif
+void pushEndOfFile(struct asyncReader* reader);
+void reportReadError(struct asyncReader* reader, long long offset, int error);
+
+/*
+Fonction : createAsyncReader
+Entrées : descripteur de fichier ouvert en lecture, début des données (octets), taille des données (octets)
+Sorties : le lecteur démarré, NULL en cas d'erreur
+Un fil de lecture remplit à l'avance un petit ensemble de tampons alignés pendant
+que le fil de traitement démodule les précédents : disque et processeur travaillent
+en même temps. Les tampons pleins sont passés dans l'ordre du fichier par une file
+sans verrou, puis rendus au lecteur par une seconde file. Le descripteur appartient
+ensuite au lecteur.
+*/
+struct asyncReader* createAsyncReader(int fd, long long offset, long long length){
+    struct asyncReader* reader = (struct asyncReader*) calloc(1,sizeof(struct asyncReader));
+    if(reader == NULL){
+        return NULL;
+    }
+    reader->fd = fd;
+    reader->start = offset;
+    reader->end = offset+length;
+    reader->freeBuffers = createSpscRing(ASYNC_NB_BUFFERS);
+    reader->fullBuffers = createSpscRing(ASYNC_NB_BUFFERS);
+    if(reader->freeBuffers == NULL || reader->fullBuffers == NULL){
+        freeSpscRing(reader->freeBuffers);
+        freeSpscRing(reader->fullBuffers);
+        free(reader);
+        return NULL;
+    }
+    for(int i=0; i<ASYNC_NB_BUFFERS; i++){
+        void* data = NULL;
+        if(posix_memalign(&data,ASYNC_ALIGNMENT,ASYNC_BUFFER_SIZE) != 0){
+            data = NULL;
+        }
+        reader->buffers[i].data = (uint8_t*) data;
+        if(data == NULL || spscPush(reader->freeBuffers,reader->buffers+i) < 0){
+            reader->fd = -1;
+            freeAsyncReader(reader);
+            return NULL;
+        }
+    }
+    atomic_init(&reader->stop,0);
+    posix_fadvise(fd,offset,length,POSIX_FADV_SEQUENTIAL);
+    if(pthread_create(&reader->thread,NULL,readerThread,reader) != 0){
+        reader->fd = -1;
+        freeAsyncReader(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+/*
+Fonction : freeAsyncReader
+Entrées : lecteur
+Sorties : 
+Arrête le fil de lecture, même s'il reste des données non lues, puis libère tout.
+*/
+void freeAsyncReader(struct asyncReader* reader){
+    if(reader == NULL){
+        return;
+    }
+    if(reader->fd >= 0){
+        atomic_store(&reader->stop,1);
+        pthread_join(reader->thread,NULL);
+        close(reader->fd);
+    }
+    for(int i=0; i<ASYNC_NB_BUFFERS; i++){
+        free(reader->buffers[i].data);
+    }
+    freeSpscRing(reader->freeBuffers);
+    freeSpscRing(reader->fullBuffers);
+    free(reader);
+}
+
+/*
+Fonction : nextAsyncBuffer
+Entrées : lecteur
+Sorties : le tampon suivant dans l'ordre du fichier, de taille nulle en fin de fichier
+Attend que le fil de lecture ait rempli le tampon. Le tampon doit être rendu par
+releaseAsyncBuffer ; après le tampon de fin de fichier, plus rien n'est à demander.
+Une erreur de lecture termine le fichier au dernier octet lu sans trou, et son code
+errno est alors dans error.
+*/
+struct asyncBuffer* nextAsyncBuffer(struct asyncReader* reader){
+    return (struct asyncBuffer*) spscPopWait(reader->fullBuffers,NULL);
+}
+
+void releaseAsyncBuffer(struct asyncReader* reader, struct asyncBuffer* buffer){
+    spscPushWait(reader->freeBuffers,buffer,NULL);
+}
+
+void* readerThread(void* argument){
+    struct asyncReader* reader = (struct asyncReader*) argument;
+#ifdef HAVE_LIBURING
+    if(readWithUring(reader) == 0){
+        return NULL;
+    }
+#endif
+    readWithPread(reader);
+    return NULL;
+}
+
+/*
+Fonction : readWithPread
+Entrées : lecteur
+Sorties : 0 en cas de succès, -1 en cas d'arrêt ou d'erreur
+Lecture par pread() d'un tampon à la fois. Avant chaque lecture, le noyau est
+prévenu que les tampons suivants seront lus (POSIX_FADV_WILLNEED) pour qu'il les
+charge pendant le traitement.
+*/
+int readWithPread(struct asyncReader* reader){
+    long long position = reader->start;
+    while(position < reader->end){
+        struct asyncBuffer* buffer = (struct asyncBuffer*) spscPopWait(reader->freeBuffers,&reader->stop);
+        if(buffer == NULL){
+            return -1;
+        }
+        size_t size = reader->end-position < ASYNC_BUFFER_SIZE ? reader->end-position : ASYNC_BUFFER_SIZE;
+        posix_fadvise(reader->fd,position+size,(long long)ASYNC_NB_BUFFERS*ASYNC_BUFFER_SIZE,POSIX_FADV_WILLNEED);
+        size_t done = 0;
+        while(done < size){
+            ssize_t result = pread(reader->fd,buffer->data+done,size-done,position+done);
+            if(result < 0 && errno == EINTR){
+                continue;
+            }
+            if(result < 0){
+                reportReadError(reader,position+done,errno);
+            }
+            if(result <= 0){
+                break;
+            }
+            done += result;
+        }
+        buffer->size = done;
+        buffer->offset = position;
+        position += done;
+        if(done > 0 && spscPushWait(reader->fullBuffers,buffer,&reader->stop) < 0){
+            return -1;
+        }
+        if(done < size){
+            if(done == 0){
+                spscPush(reader->freeBuffers,buffer);
+            }
+            break;
+        }
+    }
+    pushEndOfFile(reader);
+    return 0;
+}
+
+#ifdef HAVE_LIBURING
+/*
+Fonction : readWithUring
+Entrées : lecteur
+Sorties : 0 si le fichier a été lu, s'il y a eu une erreur ou si l'arrêt a été demandé, -1 si io_uring n'est pas disponible
+Toutes les lectures possibles sont en cours en même temps ; les tampons terminés
+sont passés au traitement dans l'ordre du fichier. Comme avec pread(), la lecture
+s'arrête à la première erreur : les tampons suivants, déjà lancés, sont rendus sans
+être passés au traitement.
+*/
+int readWithUring(struct asyncReader* reader){
+    struct io_uring ring;
+    if(io_uring_queue_init(ASYNC_NB_BUFFERS,&ring,0) < 0){
+        return -1;
+    }
+    reader->usesUring = 1;
+    struct asyncBuffer* pending[ASYNC_NB_BUFFERS];
+    int done[ASYNC_NB_BUFFERS];
+    int first = 0, nbPending = 0;
+    long long position = reader->start;
+    // Fin des données utilisables : avancée à la première lecture en erreur ou courte
+    long long limit = reader->end;
+    int status = 0;
+    while(status == 0 && (position < limit || nbPending > 0)){
+        // Lance une lecture dans chaque tampon libre
+        struct asyncBuffer* buffer;
+        while(position < limit && nbPending < ASYNC_NB_BUFFERS && (buffer = (struct asyncBuffer*) spscPop(reader->freeBuffers)) != NULL){
+            struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            buffer->offset = position;
+            buffer->size = limit-position < ASYNC_BUFFER_SIZE ? limit-position : ASYNC_BUFFER_SIZE;
+            io_uring_prep_read(sqe,reader->fd,buffer->data,buffer->size,position);
+            io_uring_sqe_set_data(sqe,(void*)(long)((first+nbPending)%ASYNC_NB_BUFFERS));
+            pending[(first+nbPending)%ASYNC_NB_BUFFERS] = buffer;
+            done[(first+nbPending)%ASYNC_NB_BUFFERS] = 0;
+            nbPending += 1;
+            position += buffer->size;
+        }
+        io_uring_submit(&ring);
+        if(nbPending == 0){
+            if(atomic_load_explicit(&reader->stop,memory_order_relaxed)){
+                status = -1;
+            } else {
+                sched_yield();
+            }
+            continue;
+        }
+        struct io_uring_cqe* cqe;
+        int result = io_uring_wait_cqe(&ring,&cqe);
+        if(result == -EINTR){
+            continue;
+        }
+        if(result < 0){
+            // Les lectures en cours sont abandonnées avec leurs tampons : le fichier
+            // s'arrête avant la plus ancienne
+            reportReadError(reader,pending[first]->offset,-result);
+            status = 1;
+            break;
+        }
+        int slot = (int)(long)io_uring_cqe_get_data(cqe);
+        struct asyncBuffer* completed = pending[slot];
+        size_t requested = completed->size;
+        if(cqe->res < 0){
+            reportReadError(reader,completed->offset,-cqe->res);
+            completed->size = 0;
+        } else if((size_t)cqe->res < completed->size){
+            // Lecture courte : le reste est lu de façon synchrone
+            size_t size = cqe->res;
+            ssize_t read = 1;
+            while(size < completed->size && read > 0){
+                read = pread(reader->fd,completed->data+size,completed->size-size,completed->offset+size);
+                if(read < 0 && errno == EINTR){
+                    read = 1;
+                    continue;
+                }
+                if(read < 0){
+                    reportReadError(reader,completed->offset+size,errno);
+                }
+                size += read > 0 ? read : 0;
+            }
+            completed->size = size;
+        }
+        // Erreur ou fin de fichier avant la fin prévue : rien au-delà n'est passé au traitement
+        if(completed->size < requested && completed->offset+(long long)completed->size < limit){
+            limit = completed->offset+completed->size;
+        }
+        done[slot] = 1;
+        io_uring_cqe_seen(&ring,cqe);
+        while(nbPending > 0 && done[first]){
+            struct asyncBuffer* next = pending[first];
+            first = (first+1)%ASYNC_NB_BUFFERS;
+            nbPending -= 1;
+            if(next->size == 0 || next->offset >= limit){
+                spscPush(reader->freeBuffers,next);
+                continue;
+            }
+            if(spscPushWait(reader->fullBuffers,next,&reader->stop) < 0){
+                status = -1;
+                break;
+            }
+        }
+    }
+    while(status < 0 && nbPending > 0){
+        struct io_uring_cqe* cqe;
+        if(io_uring_wait_cqe(&ring,&cqe) < 0){
+            break;
+        }
+        io_uring_cqe_seen(&ring,cqe);
+        nbPending -= 1;
+    }
+    io_uring_queue_exit(&ring);
+    if(status >= 0){
+        pushEndOfFile(reader);
+    }
+    return 0;
+}
+#endif
+
+/*
+Fonction : pushEndOfFile
+Entrées : lecteur
+Sorties : 
+Passe au traitement le tampon vide propre au lecteur pour signaler la fin du
+fichier : il n'attend pas qu'un tampon de données soit libre.
+*/
+void pushEndOfFile(struct asyncReader* reader){
+    reader->endOfFile.size = 0;
+    reader->endOfFile.offset = reader->end;
+    spscPushWait(reader->fullBuffers,&reader->endOfFile,&reader->stop);
+}
+
+/*
+Fonction : reportReadError
+Entrées : lecteur, position de l'erreur dans le fichier, code errno
+Sorties : 
+Seule la première erreur est gardée et signalée.
+*/
+void reportReadError(struct asyncReader* reader, long long offset, int error){
+    if(reader->error != 0){
+        return;
+    }
+    reader->error = error;
+    fprintf(stderr,"Cannot read input at byte %lld : %s\n",offset,strerror(error));
+}
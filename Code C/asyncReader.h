@@ -0,0 +1,40 @@
+#ifndef HEADER_ASYNCREADER
+#define HEADER_ASYNCREADER
+
+#include "spscRing.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define ASYNC_NB_BUFFERS 4
+#define ASYNC_BUFFER_SIZE (1024*1024)
+#define ASYNC_ALIGNMENT 4096
+
+struct asyncBuffer
+{
+    uint8_t* data;
+    size_t size;
+    long long offset;
+};
+
+struct asyncReader
+{
+    int fd;
+    long long start, end;
+    struct asyncBuffer buffers[ASYNC_NB_BUFFERS];
+    struct spscRing* freeBuffers;
+    struct spscRing* fullBuffers;
+    atomic_int stop;
+    pthread_t thread;
+    int usesUring;
+    struct asyncBuffer endOfFile;
+    int error;
+};
+
+struct asyncReader* createAsyncReader(int fd, long long offset, long long length);
+void freeAsyncReader(struct asyncReader* reader);
+struct asyncBuffer* nextAsyncBuffer(struct asyncReader* reader);
+void releaseAsyncBuffer(struct asyncReader* reader, struct asyncBuffer* buffer);
+
+#endif
@@ -0,0 +1,369 @@
+#include "batch.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+
+int addBatchFile(struct batchRun* batch, const char* path, int format, double sampleRate, double centerFrequency, double channelFrequency);
+int isRecordingName(const char* name);
+int comparePaths(const void* first, const void* second);
+int planBatchTasks(struct batchRun* batch);
+void* batchWorker(void* argument);
+int takeOwnTask(struct batchQueue* queue);
+int stealTasks(struct batchRun* batch, int worker);
+void runBatchTask(struct batchRun* batch, int task, struct receiver** rx, struct iqInput** input, int* openFile);
+
+struct batchWorker
+{
+    struct batchRun* batch;
+    int index;
+};
+
+/*
+Fonction : createBatch
+Entrées : dossier d'enregistrements ou fichier listant un enregistrement par ligne, format, fréquence
+d'échantillonnage et fréquence centrale imposés (négatif ou 0 pour lire les métadonnées), fréquence du canal
+Sorties : le lot de fichiers, NULL en cas d'erreur
+Les fichiers d'un dossier sont pris dans l'ordre alphabétique, ceux d'une liste dans
+l'ordre de la liste. Un fichier illisible est signalé puis ignoré.
+*/
+struct batchRun* createBatch(const char* list, int format, double sampleRate, double centerFrequency, double channelFrequency){
+    struct batchRun* batch = (struct batchRun*) calloc(1,sizeof(struct batchRun));
+    if(batch == NULL){
+        return NULL;
+    }
+    char path[RECORDING_PATH_SIZE];
+    struct stat status;
+    if(stat(list,&status) < 0){
+        free(batch);
+        return NULL;
+    }
+    if(S_ISDIR(status.st_mode)){
+        DIR* directory = opendir(list);
+        if(directory == NULL){
+            free(batch);
+            return NULL;
+        }
+        struct dirent* entry;
+        while((entry = readdir(directory)) != NULL){
+            if(!isRecordingName(entry->d_name)){
+                continue;
+            }
+            if(snprintf(path,RECORDING_PATH_SIZE,"%s/%s",list,entry->d_name) < RECORDING_PATH_SIZE){
+                addBatchFile(batch,path,format,sampleRate,centerFrequency,channelFrequency);
+            }
+        }
+        closedir(directory);
+        qsort(batch->files,batch->nbFiles,sizeof(struct batchFile),comparePaths);
+    } else {
+        FILE* file = fopen(list,"r");
+        if(file == NULL){
+            free(batch);
+            return NULL;
+        }
+        while(fgets(path,RECORDING_PATH_SIZE,file) != NULL){
+            path[strcspn(path,"\r\n")] = '\0';
+            if(*path != '\0' && *path != '#'){
+                addBatchFile(batch,path,format,sampleRate,centerFrequency,channelFrequency);
+            }
+        }
+        fclose(file);
+    }
+    if(planBatchTasks(batch) < 0){
+        freeBatch(batch);
+        return NULL;
+    }
+    return batch;
+}
+
+void freeBatch(struct batchRun* batch){
+    if(batch == NULL){
+        return;
+    }
+    for(int i = 0; i < batch->nbTasks; i++){
+        free((batch->tasks+i)->result.frames);
+    }
+    free(batch->files);
+    free(batch->tasks);
+    free(batch->queues);
+    free(batch);
+}
+
+/*
+Fonction : runBatch
+Entrées : lot, nombre de fils, fonction appelée au début de chaque fichier avec sa description (peut être NULL),
+fonction des trames, contexte passé aux deux fonctions
+Sorties : le nombre de trames trouvées, -1 en cas d'erreur
+Chaque fil part d'une suite de tâches de coût à peu près égal et, quand la sienne
+est vide, vole la moitié de la suite d'un autre fil : les gros fichiers ne laissent
+pas les autres fils inactifs. Chaque fil a son propre récepteur, recréé quand les
+paramètres du fichier changent. Le fil appelant rend les trames dans l'ordre des
+fichiers et des morceaux dès que la tâche suivante est terminée, sans attendre la
+fin du lot. Les tâches qui échouent sont signalées et comptées dans nbFailed.
+*/
+int runBatch(struct batchRun* batch, int nbWorkers, void (*startFile)(struct batchFile*, void*), void (*callback)(int*, int, long long, void*), void* context){
+    if(nbWorkers < 1 || nbWorkers > BATCH_MAX_WORKERS){
+        return -1;
+    }
+    batch->nbWorkers = nbWorkers;
+    batch->queues = (struct batchQueue*) aligned_alloc(CACHE_LINE_SIZE,nbWorkers*sizeof(struct batchQueue));
+    if(batch->queues == NULL){
+        return -1;
+    }
+    // Partage initial en suites contiguës de bits à peu près égaux
+    long long total = 0, cost = 0;
+    for(int i = 0; i < batch->nbTasks; i++){
+        total += (batch->tasks+i)->result.lastBit < 0 ? BATCH_CHUNK_BITS : (batch->tasks+i)->result.lastBit-(batch->tasks+i)->result.firstBit;
+    }
+    int task = 0;
+    for(int i = 0; i < nbWorkers; i++){
+        int begin = task;
+        while(task < batch->nbTasks && (cost < total*(i+1)/nbWorkers || i == nbWorkers-1)){
+            struct chunkResult* result = &(batch->tasks+task)->result;
+            cost += result->lastBit < 0 ? BATCH_CHUNK_BITS : result->lastBit-result->firstBit;
+            task += 1;
+        }
+        atomic_init(&(batch->queues+i)->range,(unsigned long long)begin | (unsigned long long)task << 32);
+    }
+    atomic_init(&batch->nbSteals,0);
+
+    pthread_t threads[BATCH_MAX_WORKERS];
+    struct batchWorker workers[BATCH_MAX_WORKERS];
+    int nbStarted = 0;
+    for(int i = 0; i < nbWorkers; i++){
+        (workers+i)->batch = batch;
+        (workers+i)->index = i;
+        if(pthread_create(threads+nbStarted,NULL,batchWorker,workers+i) == 0){
+            nbStarted += 1;
+        }
+    }
+    if(nbStarted == 0){
+        return -1;
+    }
+
+    int nbFrames = 0;
+    for(int i = 0; i < batch->nbTasks; i++){
+        struct batchTask* current = batch->tasks+i;
+        while(!atomic_load_explicit(&current->finished,memory_order_acquire)){
+            struct timespec wait = {0, 1000000};
+            nanosleep(&wait,NULL);
+        }
+        struct batchFile* file = batch->files+current->file;
+        if(i == file->firstTask && startFile != NULL){
+            startFile(file,context);
+        }
+        if(!current->result.done){
+            fprintf(stderr,"Cannot process %s\n",file->path);
+            batch->nbFailed += 1;
+        }
+        for(int j = 0; j < current->result.nbFrames; j++){
+            struct pipelineFrame* frame = current->result.frames+j;
+            callback(frame->bits,frame->size,frame->bitIndex,context);
+            nbFrames += 1;
+        }
+        free(current->result.frames);
+        current->result.frames = NULL;
+    }
+    for(int i = 0; i < nbStarted; i++){
+        pthread_join(*(threads+i),NULL);
+    }
+    return nbFrames;
+}
+
+/*
+Fonction : batchWorker
+Entrées : fil du lot
+Sorties : 
+Les tâches ne sont créées qu'au départ : un fil qui ne trouve plus rien à voler peut
+s'arrêter, les tâches restantes étant déjà prises par les autres.
+*/
+void* batchWorker(void* argument){
+    struct batchWorker* worker = (struct batchWorker*) argument;
+    struct batchRun* batch = worker->batch;
+    struct receiver* rx = NULL;
+    struct iqInput* input = NULL;
+    int openFile = -1;
+    while(1){
+        int task = takeOwnTask(batch->queues+worker->index);
+        if(task < 0){
+            if(stealTasks(batch,worker->index) < 0){
+                break;
+            }
+            continue;
+        }
+        runBatchTask(batch,task,&rx,&input,&openFile);
+    }
+    if(rx != NULL){
+        freeChannelizer(rx->channelizer);
+    }
+    freeReceiver(rx);
+    closeIqInput(input);
+    return NULL;
+}
+
+/*
+Fonction : runBatchTask
+Entrées : lot, tâche, récepteur, entrée et fichier ouverts du fil (mis à jour)
+Sorties : 
+L'entrée reste ouverte tant que le fil traite des morceaux du même fichier.
+*/
+void runBatchTask(struct batchRun* batch, int task, struct receiver** rx, struct iqInput** input, int* openFile){
+    struct batchTask* current = batch->tasks+task;
+    struct batchFile* file = batch->files+current->file;
+    if(*openFile != current->file){
+        closeIqInput(*input);
+        *input = openRecording(&file->info);
+        *openFile = current->file;
+        double sampleRate = *rx != NULL && (*rx)->channelizer != NULL ? (*rx)->channelizer->inputRate : 0;
+        double offset = *rx != NULL && (*rx)->channelizer != NULL ? (*rx)->channelizer->offset : 0;
+        if(*rx == NULL || sampleRate != file->sampleRate || offset != file->offset){
+            if(*rx != NULL){
+                freeChannelizer((*rx)->channelizer);
+            }
+            freeReceiver(*rx);
+            *rx = createChannelReceiver(file->sampleRate,file->offset,collectChunkFrame,NULL);
+        }
+    }
+    if(*input != NULL && *rx != NULL){
+        processChunk(&current->result,*rx,*input,chunkOverlapBits(*rx));
+    }
+    atomic_store_explicit(&current->finished,1,memory_order_release);
+}
+
+/*
+Fonction : takeOwnTask
+Entrées : suite de tâches d'un fil
+Sorties : la première tâche de la suite, -1 si elle est vide
+La suite [début, fin[ tient dans un seul mot atomique : le fil propriétaire prend
+au début, les voleurs à la fin, et chacun ne modifie la suite que par
+comparaison-échange.
+*/
+int takeOwnTask(struct batchQueue* queue){
+    unsigned long long range = atomic_load(&queue->range);
+    while(1){
+        unsigned int begin = range & 0xFFFFFFFF;
+        unsigned int end = range >> 32;
+        if(begin >= end){
+            return -1;
+        }
+        if(atomic_compare_exchange_weak(&queue->range,&range,(unsigned long long)(begin+1) | (unsigned long long)end << 32)){
+            return (int)begin;
+        }
+    }
+}
+
+/*
+Fonction : stealTasks
+Entrées : lot, fil voleur (sa suite est vide)
+Sorties : 0 si des tâches ont été volées, -1 s'il n'y a plus rien à voler
+La seconde moitié de la suite d'un autre fil devient la suite du voleur.
+*/
+int stealTasks(struct batchRun* batch, int worker){
+    for(int i = 1; i < batch->nbWorkers; i++){
+        struct batchQueue* victim = batch->queues+(worker+i)%batch->nbWorkers;
+        unsigned long long range = atomic_load(&victim->range);
+        while(1){
+            unsigned int begin = range & 0xFFFFFFFF;
+            unsigned int end = range >> 32;
+            if(begin >= end){
+                break;
+            }
+            unsigned int middle = end-(end-begin+1)/2;
+            if(atomic_compare_exchange_weak(&victim->range,&range,(unsigned long long)begin | (unsigned long long)middle << 32)){
+                atomic_store(&(batch->queues+worker)->range,(unsigned long long)middle | (unsigned long long)end << 32);
+                atomic_fetch_add(&batch->nbSteals,1);
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+/*
+Fonction : planBatchTasks
+Entrées : lot
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+Les fichiers de plus de BATCH_CHUNK_BITS bits sont découpés en morceaux qui se
+recouvrent, comme pour processRecordingParallel.
+*/
+int planBatchTasks(struct batchRun* batch){
+    int nbTasks = 0;
+    for(int i = 0; i < batch->nbFiles; i++){
+        struct batchFile* file = batch->files+i;
+        struct iqInput* input = openRecording(&file->info);
+        double step = file->sampleRate > 0 ? file->sampleRate/(CHANNEL_SAMPLES_PER_BIT*bitRate) : 1.0;
+        int delay = file->sampleRate > 0 ? CHANNEL_SAMPLES_PER_BIT : timeDelay;
+        long long nbBits = input != NULL && input->nbSamples > 0 ? (long long)(input->nbSamples/step)/delay : 0;
+        closeIqInput(input);
+        file->firstTask = nbTasks;
+        file->nbTasks = (int)((nbBits+BATCH_CHUNK_BITS-1)/BATCH_CHUNK_BITS);
+        if(file->nbTasks < 1){
+            file->nbTasks = 1;
+        }
+        nbTasks += file->nbTasks;
+    }
+    batch->tasks = (struct batchTask*) calloc(nbTasks > 0 ? nbTasks : 1,sizeof(struct batchTask));
+    if(batch->tasks == NULL){
+        return -1;
+    }
+    batch->nbTasks = nbTasks;
+    for(int i = 0; i < batch->nbFiles; i++){
+        struct batchFile* file = batch->files+i;
+        for(int j = 0; j < file->nbTasks; j++){
+            struct batchTask* task = batch->tasks+file->firstTask+j;
+            task->file = i;
+            task->result.firstBit = (long long)j*BATCH_CHUNK_BITS;
+            task->result.lastBit = j == file->nbTasks-1 ? -1 : (long long)(j+1)*BATCH_CHUNK_BITS;
+            atomic_init(&task->finished,0);
+        }
+    }
+    return 0;
+}
+
+int addBatchFile(struct batchRun* batch, const char* path, int format, double sampleRate, double centerFrequency, double channelFrequency){
+    struct recordingInfo info;
+    if(readRecordingInfo(path,&info) < 0){
+        fprintf(stderr,"Cannot read recording metadata of %s\n",path);
+        return -1;
+    }
+    if(batch->nbFiles == batch->maxFiles){
+        int maxFiles = batch->maxFiles > 0 ? 2*batch->maxFiles : 64;
+        struct batchFile* files = (struct batchFile*) realloc(batch->files,maxFiles*sizeof(struct batchFile));
+        if(files == NULL){
+            return -1;
+        }
+        batch->files = files;
+        batch->maxFiles = maxFiles;
+    }
+    struct batchFile* file = batch->files+batch->nbFiles;
+    // Les options de la ligne de commande priment sur les métadonnées
+    if(format >= 0){
+        info.format = format;
+    }
+    strcpy(file->path,path);
+    file->info = info;
+    file->sampleRate = sampleRate > 0 ? sampleRate : info.sampleRate;
+    centerFrequency = centerFrequency > 0 ? centerFrequency : info.centerFrequency;
+    file->offset = centerFrequency > 0 ? channelFrequency-centerFrequency : 0;
+    batch->nbFiles += 1;
+    return 0;
+}
+
+/*
+Fonction : isRecordingName
+Entrées : nom de fichier
+Sorties : 1 si l'extension est celle d'un enregistrement, 0 sinon
+Les données SigMF sont prises par leur fichier .sigmf-meta.
+*/
+int isRecordingName(const char* name){
+    const char* extension = strrchr(name,'.');
+    if(*name == '.' || extension == NULL){
+        return 0;
+    }
+    extension += 1;
+    return parseIqFormat(extension) >= 0 || strcmp(extension,"sigmf-meta") == 0 || strcmp(extension,"wav") == 0
+        || strcmp(extension,"WAV") == 0 || strcmp(extension,"aisiq") == 0;
+}
+
+int comparePaths(const void* first, const void* second){
+    return strcmp(((const struct batchFile*)first)->path,((const struct batchFile*)second)->path);
+}
@@ -0,0 +1,56 @@
+#ifndef HEADER_BATCH
+#define HEADER_BATCH
+
+#include "receiver.h"
+#include "recording.h"
+#include "parallel.h"
+#include "spscRing.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef BATCH_CHUNK_BITS
+#define BATCH_CHUNK_BITS (1024*1024)
+#endif
+#define BATCH_MAX_WORKERS PARALLEL_MAX_WORKERS
+
+struct batchFile
+{
+    char path[RECORDING_PATH_SIZE];
+    struct recordingInfo info;
+    double sampleRate;
+    double offset;
+    int firstTask, nbTasks;
+};
+
+struct batchTask
+{
+    int file;
+    struct chunkResult result;
+    atomic_int finished;
+};
+
+struct batchQueue
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_ullong range;
+};
+
+struct batchRun
+{
+    struct batchFile* files;
+    int nbFiles, maxFiles;
+    struct batchTask* tasks;
+    int nbTasks;
+    struct batchQueue* queues;
+    int nbWorkers;
+    atomic_int nbSteals;
+    int nbFailed;
+};
+
+struct batchRun* createBatch(const char* list, int format, double sampleRate, double centerFrequency, double channelFrequency);
+void freeBatch(struct batchRun* batch);
+int runBatch(struct batchRun* batch, int nbWorkers, void (*startFile)(struct batchFile*, void*), void (*callback)(int*, int, long long, void*), void* context);
+
+#endif
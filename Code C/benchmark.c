@@ -0,0 +1,99 @@
+#include "benchmark.h"
+#include <math.h>
+#include <time.h>
+
+int compareDoubles(const void* a, const void* b);
+
+double benchmarkTime(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec+now.tv_nsec*1e-9;
+}
+
+/*
+Fonction : percentile
+Entrées : valeurs (triées en place), nombre de valeurs, fraction entre 0 et 1
+Sorties : la valeur sous laquelle se trouve la fraction donnée des valeurs, 0 sans valeur
+*/
+double percentile(double* values, int nbValues, double fraction){
+    if(nbValues < 1){
+        return 0;
+    }
+    qsort(values,nbValues,sizeof(double),compareDoubles);
+    int index = (int)ceil(fraction*nbValues)-1;
+    return *(values+(index < 0 ? 0 : index >= nbValues ? nbValues-1 : index));
+}
+
+int compareDoubles(const void* a, const void* b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+/*
+Fonction : summarizeBenchmark
+Entrées : résultat à remplir (nom et unité déjà donnés), durées de chaque répétition (s), nombre de
+répétitions, nombre d'unités traitées par répétition
+Sorties :
+Le débit est calculé sur la durée médiane, moins sensible aux interruptions que la
+moyenne ; l'écart type relatif donne la stabilité de la mesure.
+*/
+void summarizeBenchmark(struct benchmarkResult* result, double* times, int nbRuns, double nbUnits){
+    double sum = 0, squares = 0;
+    for(int i=0; i<nbRuns; i++){
+        sum += *(times+i);
+        squares += *(times+i)**(times+i);
+    }
+    result->nbRuns = nbRuns;
+    result->mean = nbRuns > 0 ? sum/nbRuns : 0;
+    result->deviation = nbRuns > 1 ? sqrt(fmax(squares/nbRuns-result->mean*result->mean,0)*nbRuns/(nbRuns-1)) : 0;
+    result->median = percentile(times,nbRuns,0.5);
+    result->throughput = result->median > 0 ? nbUnits/result->median : 0;
+    result->baseline = 0;
+}
+
+/*
+Fonction : readBaseline
+Entrées : chemin du fichier de référence, résultats, nombre de résultats
+Sorties : le nombre de résultats ayant une référence, -1 si le fichier ne peut être lu
+Une ligne par mesure : nom, débit et unité séparés par des espaces ; les lignes
+commençant par # sont ignorées.
+*/
+int readBaseline(const char* path, struct benchmarkResult* results, int nbResults){
+    FILE* file = fopen(path,"r");
+    if(file == NULL){
+        return -1;
+    }
+    char line[256], name[BENCHMARK_NAME_SIZE];
+    double throughput;
+    int nbFound = 0;
+    while(fgets(line,sizeof(line),file) != NULL){
+        if(*line == '#' || sscanf(line,"%31s %lf",name,&throughput) != 2){
+            continue;
+        }
+        for(int i=0; i<nbResults; i++){
+            if(strcmp((results+i)->name,name) == 0){
+                nbFound += (results+i)->baseline == 0;
+                (results+i)->baseline = throughput;
+            }
+        }
+    }
+    fclose(file);
+    return nbFound;
+}
+
+/*
+Fonction : writeBaseline
+Entrées : chemin du fichier de référence, résultats, nombre de résultats
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+*/
+int writeBaseline(const char* path, struct benchmarkResult* results, int nbResults){
+    FILE* file = fopen(path,"w");
+    if(file == NULL){
+        return -1;
+    }
+    fprintf(file,"# name throughput unit\n");
+    for(int i=0; i<nbResults; i++){
+        fprintf(file,"%s %.6g %s\n",(results+i)->name,(results+i)->throughput,(results+i)->unit);
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
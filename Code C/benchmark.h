@@ -0,0 +1,27 @@
+#ifndef HEADER_BENCHMARK
+#define HEADER_BENCHMARK
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCHMARK_NAME_SIZE 32
+#define BENCHMARK_UNIT_SIZE 16
+
+struct benchmarkResult
+{
+    char name[BENCHMARK_NAME_SIZE];
+    char unit[BENCHMARK_UNIT_SIZE];
+    int nbRuns;
+    double median, mean, deviation;
+    double throughput;
+    double baseline;
+};
+
+double benchmarkTime();
+double percentile(double* values, int nbValues, double fraction);
+void summarizeBenchmark(struct benchmarkResult* result, double* times, int nbRuns, double nbUnits);
+int readBaseline(const char* path, struct benchmarkResult* results, int nbResults);
+int writeBaseline(const char* path, struct benchmarkResult* results, int nbResults);
+
+#endif
@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include "benchmark.h"
+#include "demod.h"
+#include "bitTreatment.h"
+#include "aisdecode.h"
+#include "modulator.h"
+#include "channelModel.h"
+#include "receiver.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCHMARK_SAMPLES 262144
+#define BENCHMARK_SAMPLES_PER_BIT 10
+#define BENCHMARK_FRAMES 1024
+#define MAX_STAGES 16
+#define MAX_RUNS 10000
+
+struct benchmarkStage
+{
+   const char *name;
+   const char *unit;
+   double nbUnits;
+   void (*prepare)(void);
+   void (*run)(void);
+};
+
+struct complex *inputSignal, *work, *delayed, *products;
+int *bits, *workBits, *stuffedFrames, *payloads, *frameOutput;
+int nbBits;
+volatile int sink;
+
+int createInputs(uint64_t seed);
+void copySignal(void);
+void copyBits(void);
+void runDelayVector(void);
+void runComputeMultSignals(void);
+void runComputeOutput(void);
+void runNrziInv(void);
+void runBitStuffingInv(void);
+void runGetFromMessage(void);
+
+/*
+Mesure du coût de chaque étage de la chaîne de réception, isolé et sur des entrées
+synthétiques fixes (signal GMSK bruité, trames AIS aléatoires mais toujours les
+mêmes pour une graine donnée). Chaque étage est exécuté quelques fois pour chauffer
+les caches, puis mesuré sur plusieurs répétitions : le débit est donné pour la durée
+médiane, avec l'écart type relatif des durées. Les débits sont comparés à ceux d'un
+fichier de référence (benchmarkBaseline.txt par défaut) ; le programme rend 1 si un
+étage est plus lent que la référence au-delà de la tolérance.
+*/
+int main(int argc, char** argv)
+{
+   int option;
+   int nbRuns = 30;
+   int nbWarmups = 5;
+   double tolerance = 10;
+   const char *baselinePath = "benchmarkBaseline.txt";
+   const char *writePath = NULL;
+   const char *filter = NULL;
+   while((option = getopt(argc, argv, "b:n:s:T:W:w:")) != -1){
+      switch(option){
+      case 'b':
+         baselinePath = optarg;
+         break;
+      case 'n':
+         nbRuns = atoi(optarg);
+         break;
+      case 's':
+         filter = optarg;
+         break;
+      case 'T':
+         // ralentissement toléré en pourcentage
+         tolerance = atof(optarg);
+         break;
+      case 'W':
+         nbWarmups = atoi(optarg);
+         break;
+      case 'w':
+         writePath = optarg;
+         break;
+      default:
+         fprintf(stderr, "Usage : %s [-n runs] [-W warmup runs] [-s stage] [-b baseline] [-w new baseline] [-T tolerance %%]\n", argv[0]);
+         return(1);
+      }
+   }
+   if(nbRuns < 1 || nbRuns > MAX_RUNS){
+      fprintf(stderr, "The number of runs must be between 1 and %d\n", MAX_RUNS);
+      return(1);
+   }
+   if(createInputs(1) < 0){
+      fprintf(stderr, "Cannot create the inputs\n");
+      return(1);
+   }
+   struct benchmarkStage stages[] = {
+      {"delayVector", "samples/s", BENCHMARK_SAMPLES, NULL, runDelayVector},
+      {"computeMultSignals", "samples/s", BENCHMARK_SAMPLES, copySignal, runComputeMultSignals},
+      {"computeOutput", "samples/s", BENCHMARK_SAMPLES, NULL, runComputeOutput},
+      {"nrziInv", "bits/s", 0, copyBits, runNrziInv},
+      {"bitStuffingInv", "frames/s", BENCHMARK_FRAMES, NULL, runBitStuffingInv},
+      {"getFromMessage", "frames/s", BENCHMARK_FRAMES, NULL, runGetFromMessage},
+   };
+   stages[3].nbUnits = nbBits;
+   int nbStages = sizeof(stages)/sizeof(stages[0]);
+
+   struct benchmarkResult results[MAX_STAGES];
+   double *times = (double*) malloc(nbRuns*sizeof(double));
+   int nbResults = 0;
+   for(int s = 0; s < nbStages; s++){
+      if(filter != NULL && strstr(stages[s].name, filter) == NULL){
+         continue;
+      }
+      for(int i = 0; i < nbWarmups+nbRuns; i++){
+         if(stages[s].prepare != NULL){
+            stages[s].prepare();
+         }
+         double start = benchmarkTime();
+         stages[s].run();
+         if(i >= nbWarmups){
+            times[i-nbWarmups] = benchmarkTime()-start;
+         }
+      }
+      struct benchmarkResult *result = results+nbResults++;
+      snprintf(result->name, BENCHMARK_NAME_SIZE, "%s", stages[s].name);
+      snprintf(result->unit, BENCHMARK_UNIT_SIZE, "%s", stages[s].unit);
+      summarizeBenchmark(result, times, nbRuns, stages[s].nbUnits);
+   }
+   free(times);
+
+   int nbCompared = readBaseline(baselinePath, results, nbResults);
+   if(nbCompared < 0 && strcmp(baselinePath, "benchmarkBaseline.txt") != 0){
+      fprintf(stderr, "Cannot read baseline %s\n", baselinePath);
+   }
+   int nbRegressions = 0;
+   printf("%-20s %14s %-10s %12s %8s %14s %8s\n", "stage", "throughput", "unit", "median (us)", "stddev", "baseline", "change");
+   for(int r = 0; r < nbResults; r++){
+      struct benchmarkResult *result = results+r;
+      printf("%-20s %14.4g %-10s %12.1f %7.1f%%", result->name, result->throughput, result->unit,
+         result->median*1e6, result->mean > 0 ? 100*result->deviation/result->mean : 0);
+      if(result->baseline > 0){
+         double change = 100*(result->throughput/result->baseline-1);
+         int regression = change < -tolerance;
+         nbRegressions += regression;
+         printf(" %14.4g %+7.1f%%%s", result->baseline, change, regression ? " SLOWER" : "");
+      }
+      printf("\n");
+   }
+   printf("%d runs after %d warm-up runs per stage, %d stages compared, %d slower than baseline by more than %g%%\n",
+      nbRuns, nbWarmups, nbCompared > 0 ? nbCompared : 0, nbRegressions, tolerance);
+   if(writePath != NULL && writeBaseline(writePath, results, nbResults) < 0){
+      fprintf(stderr, "Cannot write baseline %s\n", writePath);
+      return(1);
+   }
+   return(nbRegressions > 0);
+}
+
+/*
+Fonction : createInputs
+Entrées : graine
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+Signal : bits aléatoires modulés en GMSK à 10 échantillons par bit, avec un rapport
+signal sur bruit de 10 dB. Trames : rapports de position aléatoires, en NRZI inversé
+comme dans processWindow.
+*/
+int createInputs(uint64_t seed)
+{
+   struct randomState random;
+   seedRandom(&random, seed, 0);
+   struct gmskModulator *modulator = createGmskModulator(BENCHMARK_SAMPLES_PER_BIT, 0.4);
+   int nbSymbols = BENCHMARK_SAMPLES/BENCHMARK_SAMPLES_PER_BIT;
+   int *symbols = (int*) malloc(nbSymbols*sizeof(int));
+   struct complex *modulated = modulator != NULL ? (struct complex*) malloc(gmskLength(modulator, nbSymbols)*sizeof(struct complex)) : NULL;
+   inputSignal = (struct complex*) malloc(BENCHMARK_SAMPLES*sizeof(struct complex));
+   work = (struct complex*) malloc(BENCHMARK_SAMPLES*sizeof(struct complex));
+   delayed = (struct complex*) malloc(BENCHMARK_SAMPLES*sizeof(struct complex));
+   products = (struct complex*) malloc(BENCHMARK_SAMPLES*sizeof(struct complex));
+   bits = (int*) malloc(nbSymbols*sizeof(int));
+   workBits = (int*) malloc(nbSymbols*sizeof(int));
+   stuffedFrames = (int*) malloc(BENCHMARK_FRAMES*FRAME_WINDOW*sizeof(int));
+   payloads = (int*) malloc(BENCHMARK_FRAMES*POSITION_REPORT_BITS*sizeof(int));
+   frameOutput = (int*) malloc(FRAME_WINDOW*sizeof(int));
+   if(symbols == NULL || modulated == NULL || inputSignal == NULL || work == NULL || delayed == NULL || products == NULL
+         || bits == NULL || workBits == NULL || stuffedFrames == NULL || payloads == NULL || frameOutput == NULL){
+      return -1;
+   }
+   for(int i = 0; i < nbSymbols; i++){
+      symbols[i] = randomNext(&random) >> 63;
+   }
+   modulateGmsk(modulator, symbols, nbSymbols, modulated);
+   memcpy(inputSignal, modulated, BENCHMARK_SAMPLES*sizeof(struct complex));
+   addNoise(&random, inputSignal, BENCHMARK_SAMPLES, 0.1);
+   delayVector(inputSignal, delayed, BENCHMARK_SAMPLES, BENCHMARK_SAMPLES_PER_BIT);
+   memcpy(products, inputSignal, BENCHMARK_SAMPLES*sizeof(struct complex));
+   computeMultSignals(products, delayed, BENCHMARK_SAMPLES);
+   computeOutput(bits, products, BENCHMARK_SAMPLES, BENCHMARK_SAMPLES_PER_BIT);
+   nbBits = BENCHMARK_SAMPLES/BENCHMARK_SAMPLES_PER_BIT-2;
+
+   int packet[MAX_PACKET_BITS];
+   for(int f = 0; f < BENCHMARK_FRAMES; f++){
+      int *payload = payloads+f*POSITION_REPORT_BITS;
+      for(int i = 0; i < POSITION_REPORT_BITS; i++){
+         payload[i] = randomNext(&random) >> 63;
+      }
+      setMessageField(payload, 0, 6, 1);
+      int length = buildAisPacket(payload, POSITION_REPORT_BITS, packet);
+      nrziInv(packet, length);
+      memcpy(stuffedFrames+f*FRAME_WINDOW, packet+PACKET_RAMP_BITS-8, FRAME_WINDOW*sizeof(int));
+   }
+   freeGmskModulator(modulator);
+   free(modulated);
+   free(symbols);
+   return 0;
+}
+
+void copySignal(void)
+{
+   memcpy(work, inputSignal, BENCHMARK_SAMPLES*sizeof(struct complex));
+}
+
+void copyBits(void)
+{
+   memcpy(workBits, bits, nbBits*sizeof(int));
+}
+
+void runDelayVector(void)
+{
+   delayVector(inputSignal, delayed, BENCHMARK_SAMPLES, BENCHMARK_SAMPLES_PER_BIT);
+}
+
+void runComputeMultSignals(void)
+{
+   computeMultSignals(work, delayed, BENCHMARK_SAMPLES);
+}
+
+void runComputeOutput(void)
+{
+   computeOutput(workBits, products, BENCHMARK_SAMPLES, BENCHMARK_SAMPLES_PER_BIT);
+}
+
+void runNrziInv(void)
+{
+   nrziInv(workBits, nbBits);
+}
+
+void runBitStuffingInv(void)
+{
+   int total = 0;
+   for(int f = 0; f < BENCHMARK_FRAMES; f++){
+      // Même découpe que processWindow : fenêtre sans préambule ni fanion de fin
+      total += bitStuffingInv(stuffedFrames+f*FRAME_WINDOW+sizePreambleFlag, frameOutput, FRAME_WINDOW-sizePreambleFlag-sizeEndFlag);
+   }
+   sink = total;
+}
+
+void runGetFromMessage(void)
+{
+   int total = 0;
+   for(int f = 0; f < BENCHMARK_FRAMES; f++){
+      // Les champs lus par decodePositionReport
+      int *payload = payloads+f*POSITION_REPORT_BITS;
+      total += getFromMessage(payload, 0, 6);
+      total += getFromMessage(payload, 8, 38);
+      total += getFromMessage(payload, 61, 89);
+      total += getFromMessage(payload, 89, 116);
+      total += getFromMessage(payload, 116, 128);
+   }
+   sink = total;
+}
@@ -103,3 +103,46 @@ void removeCheckSum(int* inputVector, int* output, int size){
         *(output+i)=*(inputVector+i);
     }
 }
+
+/*
+Fonction : findEndFlag
+Entrées : vecteur de bits après le fanion de début (NRZI inversé), taille du vecteur
+Sorties : la position du fanion de fin 01111110, -1 s'il n'est pas dans le vecteur
+Grâce au bourrage, six 1 consécutifs ne peuvent apparaître que dans un fanion.
+*/
+int findEndFlag(int* inputVector, int size){
+    int nbOnes = 0;
+    for(int i=0; i<size; i++){
+        if(*(inputVector+i) == 1){
+            nbOnes += 1;
+            if(nbOnes == 6){
+                return i-6 >= 0 && i+1 < size && *(inputVector+i+1) == 0 ? i-6 : -1;
+            }
+        } else {
+            nbOnes = 0;
+        }
+    }
+    return -1;
+}
+
+/*
+Fonction : checkCrc
+Entrées : vecteur de bits sans bourrage (données puis somme de contrôle, dans l'ordre d'émission), taille du vecteur
+Sorties : 1 si la somme de contrôle est correcte, 0 sinon
+CRC-16 HDLC (polynôme 0x1021 réfléchi, initialisé à 0xFFFF) : calculé sur les
+données et la somme de contrôle, il laisse le reste constant 0xF0B8.
+*/
+int checkCrc(int* inputVector, int size){
+    unsigned int crc = 0xFFFF;
+    if(size <= sizeCheckSum){
+        return 0;
+    }
+    for(int i=0; i<size; i++){
+        if((crc ^ *(inputVector+i)) & 1){
+            crc = (crc >> 1) ^ 0x8408;
+        } else {
+            crc >>= 1;
+        }
+    }
+    return crc == 0xF0B8;
+}
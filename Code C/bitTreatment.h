@@ -9,5 +9,7 @@ void nrziInv(int* inputVector, int size);
 void removePreambleFlag(int* inputVector, int* output, int size);
 int bitStuffingInv(int* inputVector, int* output, int size);
 void removeCheckSum(int* inputVector,int* output, int size);
+int findEndFlag(int* inputVector, int size);
+int checkCrc(int* inputVector, int size);
 
 #endif
\ No newline at end of file
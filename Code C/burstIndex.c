@@ -0,0 +1,145 @@
+#include "burstIndex.h"
+
+#define BURST_INDEX_MAGIC "AISBIDX1"
+
+int writeBurstEntry(struct burstIndex* index);
+
+/*
+Fonction : createBurstIndex
+Entrées : chemin du fichier d'index, fréquence d'échantillonnage de l'enregistrement, voie AIS ('A' ou 'B')
+Sorties : l'index ouvert en écriture, NULL en cas d'erreur
+Premier passage sur un enregistrement : chaque trame détectée y est notée avec sa
+position en échantillons de l'enregistrement et l'état de son décodage. Les passages
+suivants ne relisent que ces régions.
+*/
+struct burstIndex* createBurstIndex(const char* path, double sampleRate, char channel){
+    struct burstIndex* index = (struct burstIndex*) calloc(1,sizeof(struct burstIndex));
+    if(index == NULL){
+        return NULL;
+    }
+    index->file = fopen(path,"wb");
+    if(index->file == NULL){
+        free(index);
+        return NULL;
+    }
+    struct burstIndexHeader header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,BURST_INDEX_MAGIC,8);
+    header.sampleRate = sampleRate;
+    if(fwrite(&header,sizeof(header),1,index->file) != 1){
+        fclose(index->file);
+        free(index);
+        return NULL;
+    }
+    index->sampleRate = sampleRate;
+    index->channel = channel;
+    return index;
+}
+
+/*
+Fonction : addBurstEntry
+Entrées : index, premier et dernier échantillon de la trame, état du décodage
+Sorties : 
+Deux détections qui se recouvrent ne forment qu'une entrée, avec le meilleur état.
+*/
+void addBurstEntry(struct burstIndex* index, long long start, long long end, int status){
+    struct burstEntry* pending = &index->pending;
+    if(index->hasPending && start <= pending->end){
+        pending->end = end > pending->end ? end : pending->end;
+        pending->status = status > pending->status ? status : pending->status;
+        return;
+    }
+    if(index->hasPending){
+        writeBurstEntry(index);
+    }
+    memset(pending,0,sizeof(struct burstEntry));
+    pending->start = start > 0 ? start : 0;
+    pending->end = end;
+    pending->channel = index->channel;
+    pending->status = status;
+    index->hasPending = 1;
+}
+
+int writeBurstEntry(struct burstIndex* index){
+    index->pending.sequence = index->counts[0]+index->counts[1]+index->counts[2];
+    index->counts[index->pending.status] += 1;
+    index->hasPending = 0;
+    return fwrite(&index->pending,sizeof(struct burstEntry),1,index->file) == 1 ? 0 : -1;
+}
+
+/*
+Fonction : flushBurstIndex
+Entrées : index ouvert en écriture
+Sorties : 0 en cas de succès, -1 en cas d'erreur d'écriture
+Écrit l'entrée en attente ; les compteurs par état sont alors complets.
+*/
+int flushBurstIndex(struct burstIndex* index){
+    if(!index->hasPending){
+        return 0;
+    }
+    if(writeBurstEntry(index) < 0){
+        return -1;
+    }
+    return fflush(index->file) == 0 ? 0 : -1;
+}
+
+/*
+Fonction : openBurstIndex
+Entrées : chemin du fichier d'index
+Sorties : l'index chargé en mémoire, NULL en cas d'erreur
+*/
+struct burstIndex* openBurstIndex(const char* path){
+    FILE* file = fopen(path,"rb");
+    if(file == NULL){
+        return NULL;
+    }
+    struct burstIndexHeader header;
+    fseek(file,0,SEEK_END);
+    long size = ftell(file);
+    fseek(file,0,SEEK_SET);
+    struct burstIndex* index = (struct burstIndex*) calloc(1,sizeof(struct burstIndex));
+    if(index == NULL || size < (long)sizeof(header) || fread(&header,sizeof(header),1,file) != 1
+        || memcmp(header.magic,BURST_INDEX_MAGIC,8) != 0){
+        free(index);
+        fclose(file);
+        return NULL;
+    }
+    index->sampleRate = header.sampleRate;
+    index->nbEntries = (size-sizeof(header))/sizeof(struct burstEntry);
+    index->entries = (struct burstEntry*) malloc((index->nbEntries+1)*sizeof(struct burstEntry));
+    if(index->entries == NULL || fread(index->entries,sizeof(struct burstEntry),index->nbEntries,file) != (size_t)index->nbEntries){
+        free(index->entries);
+        free(index);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    for(int i=0; i<index->nbEntries; i++){
+        if((index->entries+i)->status <= BURST_DECODED){
+            index->counts[(index->entries+i)->status] += 1;
+        }
+    }
+    return index;
+}
+
+/*
+Fonction : closeBurstIndex
+Entrées : index
+Sorties : 0 en cas de succès, -1 en cas d'erreur d'écriture
+Écrit la dernière entrée d'un index ouvert en écriture puis libère l'index.
+*/
+int closeBurstIndex(struct burstIndex* index){
+    int status = 0;
+    if(index == NULL){
+        return 0;
+    }
+    if(index->file != NULL){
+        status = flushBurstIndex(index);
+        if(fclose(index->file) != 0){
+            status = -1;
+        }
+    }
+    free(index->entries);
+    free(index);
+    return status;
+}
@@ -0,0 +1,46 @@
+#ifndef HEADER_BURSTINDEX
+#define HEADER_BURSTINDEX
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BURST_TRUNCATED 0
+#define BURST_CRC_ERROR 1
+#define BURST_DECODED 2
+
+struct burstIndexHeader
+{
+    char magic[8];
+    double sampleRate;
+};
+
+struct burstEntry
+{
+    int64_t start, end;
+    uint8_t channel;
+    uint8_t status;
+    uint16_t reserved;
+    uint32_t sequence;
+};
+
+struct burstIndex
+{
+    FILE* file;
+    double sampleRate;
+    char channel;
+    struct burstEntry pending;
+    int hasPending;
+    struct burstEntry* entries;
+    int nbEntries;
+    int counts[3];
+};
+
+struct burstIndex* createBurstIndex(const char* path, double sampleRate, char channel);
+void addBurstEntry(struct burstIndex* index, long long start, long long end, int status);
+int flushBurstIndex(struct burstIndex* index);
+struct burstIndex* openBurstIndex(const char* path);
+int closeBurstIndex(struct burstIndex* index);
+
+#endif
@@ -0,0 +1,270 @@
+#include "burstRecorder.h"
+#include <sched.h>
+#include <time.h>
+
+void* burstWriterThread(void* argument);
+void publishBurst(struct burstRecorder* recorder);
+int writeBurstFiles(struct burstRecorder* recorder, struct burstRequest* request, long long nbSamples);
+
+/*
+Fonction : createBurstRecorder
+Entrées : préfixe des fichiers de salves, fréquence d'échantillonnage, durées gardées avant et après la salve (ms),
+seuil de puissance du squelch (0 pour ne déclencher que sur le préambule)
+Sorties : l'enregistreur démarré, NULL en cas d'erreur
+Les derniers BURST_RING_MS ms d'échantillons sont gardés dans un tampon circulaire.
+Quand une salve est signalée, un fil d'écriture en copie les échantillons, avec
+les marges avant et après, dans un fichier binaire cf32 accompagné de ses
+métadonnées SigMF : chaque salve se relit directement avec ./main.
+*/
+struct burstRecorder* createBurstRecorder(const char* prefix, double sampleRate, double preRollMs, double postRollMs, float squelchLevel){
+    if(strlen(prefix)+32 >= BURST_PREFIX_SIZE){
+        return NULL;
+    }
+    struct burstRecorder* recorder = (struct burstRecorder*) calloc(1,sizeof(struct burstRecorder));
+    if(recorder == NULL){
+        return NULL;
+    }
+    long long ringSize = 1024;
+    while(ringSize < sampleRate*BURST_RING_MS/1000){
+        ringSize *= 2;
+    }
+    strcpy(recorder->prefix,prefix);
+    recorder->sampleRate = sampleRate;
+    recorder->preRoll = sampleRate*preRollMs/1000;
+    recorder->postRoll = sampleRate*postRollMs/1000;
+    recorder->ringMask = ringSize-1;
+    recorder->maxBurst = ringSize/2;
+    recorder->squelchLevel = squelchLevel;
+    recorder->smoothing = 9600.0/sampleRate;
+    recorder->ring = (struct complex*) malloc(ringSize*sizeof(struct complex));
+    recorder->copy = (struct complex*) malloc(recorder->maxBurst*sizeof(struct complex));
+    recorder->pending = createSpscRing(BURST_MAX_PENDING);
+    recorder->done = createSpscRing(BURST_MAX_PENDING);
+    if(recorder->ring == NULL || recorder->copy == NULL || recorder->pending == NULL || recorder->done == NULL
+        || recorder->preRoll+recorder->postRoll >= recorder->maxBurst){
+        free(recorder->ring);
+        free(recorder->copy);
+        freeSpscRing(recorder->pending);
+        freeSpscRing(recorder->done);
+        free(recorder);
+        return NULL;
+    }
+    for(int i=0; i<BURST_MAX_PENDING; i++){
+        spscPush(recorder->done,recorder->requests+i);
+    }
+    atomic_init(&recorder->written,0);
+    atomic_init(&recorder->finished,0);
+    atomic_init(&recorder->nbBursts,0);
+    atomic_init(&recorder->nbDropped,0);
+    if(pthread_create(&recorder->thread,NULL,burstWriterThread,recorder) != 0){
+        recorder->stopped = 1;
+        closeBurstRecorder(recorder);
+        return NULL;
+    }
+    return recorder;
+}
+
+/*
+Fonction : stopBurstRecorder
+Entrées : enregistreur
+Sorties : 
+Signale la salve en cours et attend que toutes les salves soient écrites ; les
+compteurs sont alors définitifs.
+*/
+void stopBurstRecorder(struct burstRecorder* recorder){
+    if(recorder->stopped){
+        return;
+    }
+    flushBurstRecorder(recorder);
+    atomic_store(&recorder->finished,1);
+    pthread_join(recorder->thread,NULL);
+    recorder->stopped = 1;
+}
+
+void closeBurstRecorder(struct burstRecorder* recorder){
+    if(recorder == NULL){
+        return;
+    }
+    stopBurstRecorder(recorder);
+    free(recorder->ring);
+    free(recorder->copy);
+    freeSpscRing(recorder->pending);
+    freeSpscRing(recorder->done);
+    free(recorder);
+}
+
+/*
+Fonction : recordBurstSamples
+Entrées : enregistreur, échantillons, nombre d'échantillons
+Sorties : 
+Appelée par le fil de traitement pour chaque nouvel échantillon ; ne bloque jamais.
+Le squelch suit la puissance moyenne sur environ un bit et déclenche une salve
+pour chaque passage au-dessus du seuil (avec une hystérésis de 3 dB).
+*/
+void recordBurstSamples(struct burstRecorder* recorder, struct complex* samples, int nbSamples){
+    long long written = atomic_load_explicit(&recorder->written,memory_order_relaxed);
+    for(int i=0; i<nbSamples; i++){
+        *(recorder->ring+((written+i) & recorder->ringMask)) = *(samples+i);
+    }
+    if(recorder->squelchLevel > 0){
+        for(int i=0; i<nbSamples; i++){
+            float power = (samples+i)->real*(samples+i)->real+(samples+i)->imag*(samples+i)->imag;
+            recorder->power += recorder->smoothing*(power-recorder->power);
+            if(!recorder->squelchOpen && recorder->power > recorder->squelchLevel){
+                recorder->squelchOpen = 1;
+                recorder->squelchStart = written+i;
+            } else if(recorder->squelchOpen && (recorder->power < recorder->squelchLevel/2
+                || written+i-recorder->squelchStart >= recorder->maxBurst-recorder->preRoll-recorder->postRoll)){
+                recorder->squelchOpen = 0;
+                triggerBurst(recorder,recorder->squelchStart,written+i,BURST_SQUELCH);
+            }
+        }
+    }
+    atomic_store_explicit(&recorder->written,written+nbSamples,memory_order_release);
+    if(recorder->hasCurrent && written+nbSamples >= recorder->current.end){
+        publishBurst(recorder);
+    }
+}
+
+/*
+Fonction : triggerBurst
+Entrées : enregistreur, premier et dernier échantillon de la salve (indices dans le flux), cause du déclenchement
+Sorties : 
+Une salve qui recouvre la salve en cours la prolonge, dans la limite de la moitié du
+tampon circulaire.
+*/
+void triggerBurst(struct burstRecorder* recorder, long long start, long long end, int cause){
+    long long trigger = start;
+    start = start > recorder->preRoll ? start-recorder->preRoll : 0;
+    end += recorder->postRoll;
+    if(recorder->hasCurrent){
+        struct burstRequest* current = &recorder->current;
+        long long merged = end > current->end ? end : current->end;
+        if(start <= current->end && merged-current->start <= recorder->maxBurst){
+            current->end = merged;
+            return;
+        }
+        publishBurst(recorder);
+    }
+    if(end-start > recorder->maxBurst){
+        end = start+recorder->maxBurst;
+    }
+    recorder->current.start = start;
+    recorder->current.end = end;
+    recorder->current.trigger = trigger;
+    recorder->current.cause = cause;
+    recorder->hasCurrent = 1;
+}
+
+/*
+Fonction : flushBurstRecorder
+Entrées : enregistreur
+Sorties : 
+Fin de flux : la salve en cours est signalée avec les échantillons déjà reçus.
+*/
+void flushBurstRecorder(struct burstRecorder* recorder){
+    if(recorder->squelchOpen){
+        recorder->squelchOpen = 0;
+        triggerBurst(recorder,recorder->squelchStart,atomic_load(&recorder->written),BURST_SQUELCH);
+    }
+    if(recorder->hasCurrent){
+        long long written = atomic_load(&recorder->written);
+        if(recorder->current.end > written){
+            recorder->current.end = written;
+        }
+        publishBurst(recorder);
+    }
+}
+
+/*
+Fonction : publishBurst
+Entrées : enregistreur
+Sorties : 
+Passe la salve en cours au fil d'écriture. Si toutes les demandes sont en attente
+d'écriture, la salve est perdue plutôt que de bloquer le traitement.
+*/
+void publishBurst(struct burstRecorder* recorder){
+    recorder->hasCurrent = 0;
+    struct burstRequest* request = (struct burstRequest*) spscPop(recorder->done);
+    if(request == NULL){
+        atomic_fetch_add(&recorder->nbDropped,1);
+        return;
+    }
+    *request = recorder->current;
+    spscPush(recorder->pending,request);
+}
+
+/*
+Fonction : burstWriterThread
+Entrées : enregistreur
+Sorties : 
+Copie chaque salve hors du tampon circulaire puis l'écrit. La copie est validée
+après coup : si le fil de traitement a réécrit une partie de la salve pendant la
+copie (écriture trop lente), la salve est perdue.
+*/
+void* burstWriterThread(void* argument){
+    struct burstRecorder* recorder = (struct burstRecorder*) argument;
+    struct burstRequest* request;
+    while((request = (struct burstRequest*) spscPopWait(recorder->pending,&recorder->finished)) != NULL){
+        long long nbSamples = request->end-request->start;
+        long long written;
+        // La marge après la salve peut ne pas être encore reçue
+        while((written = atomic_load_explicit(&recorder->written,memory_order_acquire)) < request->end
+            && !atomic_load_explicit(&recorder->finished,memory_order_relaxed)){
+            struct timespec delay = {0, 1000000};
+            nanosleep(&delay,NULL);
+        }
+        if(written < request->end){
+            nbSamples = written-request->start;
+        }
+        for(long long i=0; i<nbSamples; i++){
+            *(recorder->copy+i) = *(recorder->ring+((request->start+i) & recorder->ringMask));
+        }
+        atomic_thread_fence(memory_order_acquire);
+        written = atomic_load_explicit(&recorder->written,memory_order_relaxed);
+        if(nbSamples <= 0 || written-(recorder->ringMask+1) > request->start){
+            atomic_fetch_add(&recorder->nbDropped,1);
+        } else if(writeBurstFiles(recorder,request,nbSamples) == 0){
+            atomic_fetch_add(&recorder->nbBursts,1);
+        }
+        spscPushWait(recorder->done,request,NULL);
+    }
+    return NULL;
+}
+
+/*
+Fonction : writeBurstFiles
+Entrées : enregistreur, salve, nombre d'échantillons copiés
+Sorties : 0 en cas de succès, -1 en cas d'erreur d'écriture
+Fichiers <préfixe>-<premier échantillon>.sigmf-data et .sigmf-meta ; l'annotation
+situe le déclenchement dans la salve.
+*/
+int writeBurstFiles(struct burstRecorder* recorder, struct burstRequest* request, long long nbSamples){
+    char path[BURST_PREFIX_SIZE+48];
+    snprintf(path,sizeof(path),"%s-%lld.sigmf-data",recorder->prefix,request->start);
+    FILE* file = fopen(path,"wb");
+    if(file == NULL){
+        return -1;
+    }
+    int status = fwrite(recorder->copy,sizeof(struct complex),nbSamples,file) == (size_t)nbSamples ? 0 : -1;
+    fclose(file);
+    snprintf(path,sizeof(path),"%s-%lld.sigmf-meta",recorder->prefix,request->start);
+    file = fopen(path,"w");
+    if(file == NULL){
+        return -1;
+    }
+    fprintf(file,"{\n  \"global\": {\n    \"core:datatype\": \"cf32_le\",\n    \"core:sample_rate\": %.1f,\n"
+        "    \"core:version\": \"1.0.0\",\n    \"ais:stream_sample\": %lld\n  },\n",recorder->sampleRate,request->start);
+    fprintf(file,"  \"captures\": [\n    {\n      \"core:sample_start\": 0");
+    if(recorder->frequency > 0){
+        fprintf(file,",\n      \"core:frequency\": %.1f",recorder->frequency);
+    }
+    fprintf(file,"\n    }\n  ],\n  \"annotations\": [\n    {\n      \"core:sample_start\": %lld,\n"
+        "      \"core:sample_count\": %lld,\n      \"core:label\": \"%s\"\n    }\n  ]\n}\n",
+        request->trigger-request->start,nbSamples-(request->trigger-request->start),
+        request->cause == BURST_PREAMBLE ? "preamble" : "squelch");
+    if(fclose(file) != 0){
+        status = -1;
+    }
+    return status;
+}
@@ -0,0 +1,61 @@
+#ifndef HEADER_BURSTRECORDER
+#define HEADER_BURSTRECORDER
+
+#include "complexLib.h"
+#include "spscRing.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BURST_RING_MS 500
+#define BURST_MAX_PENDING 64
+#define BURST_PREFIX_SIZE 512
+
+#define BURST_PREAMBLE 0
+#define BURST_SQUELCH 1
+
+struct burstRequest
+{
+    long long start, end;
+    long long trigger;
+    int cause;
+};
+
+struct burstRecorder
+{
+    char prefix[BURST_PREFIX_SIZE];
+    double sampleRate;
+    double frequency;
+    long long preRoll, postRoll;
+    struct complex* ring;
+    long long ringMask;
+    atomic_llong written;
+    struct burstRequest current;
+    int hasCurrent;
+    float squelchLevel;
+    float power;
+    float smoothing;
+    int squelchOpen;
+    long long squelchStart;
+    struct burstRequest requests[BURST_MAX_PENDING];
+    int nextRequest;
+    struct spscRing* pending;
+    struct spscRing* done;
+    atomic_int finished;
+    pthread_t thread;
+    int stopped;
+    struct complex* copy;
+    long long maxBurst;
+    atomic_int nbBursts, nbDropped;
+};
+
+struct burstRecorder* createBurstRecorder(const char* prefix, double sampleRate, double preRollMs, double postRollMs, float squelchLevel);
+void stopBurstRecorder(struct burstRecorder* recorder);
+void closeBurstRecorder(struct burstRecorder* recorder);
+void recordBurstSamples(struct burstRecorder* recorder, struct complex* samples, int nbSamples);
+void triggerBurst(struct burstRecorder* recorder, long long start, long long end, int cause);
+void flushBurstRecorder(struct burstRecorder* recorder);
+
+#endif
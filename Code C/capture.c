@@ -0,0 +1,586 @@
+#include "capture.h"
+#include <fcntl.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CAPTURE_MAGIC "AISIQCP1"
+#define CHUNK_MAGIC 0x4b4e4843
+#define TRAILER_MAGIC 0x58444943
+#define MAX_BITS_PER_VALUE (CAPTURE_RICE_ESCAPE+8)
+
+struct bitWriter
+{
+    uint8_t* output;
+    uint64_t accumulator;
+    int nbBits;
+};
+
+struct bitReader
+{
+    const uint8_t* input;
+    const uint8_t* end;
+    uint64_t accumulator;
+    int nbBits;
+};
+
+void prepareValues(const uint8_t* samples, int nbValues, int method, uint8_t* values);
+int chooseRiceParameter(const uint8_t* values, int nbValues, long long* cost);
+int encodeValues(const uint8_t* values, int nbValues, uint8_t* output);
+void decodeValues(const uint8_t* input, const uint8_t* end, int nbValues, int method, uint8_t* output);
+void putBits(struct bitWriter* writer, uint32_t value, int nbBits);
+void refillBits(struct bitReader* reader);
+uint32_t takeBits(struct bitReader* reader, int nbBits);
+int rebuildCaptureIndex(struct captureReader* reader);
+
+/*
+Fonction : createCaptureWriter
+Entrées : chemin de l'enregistrement, fréquence d'échantillonnage, date du premier échantillon (s depuis 1970)
+Sorties : l'écrivain, NULL en cas d'erreur
+Enregistrement compressé sans perte d'échantillons cu8 (sortie de rtl_sdr). Le
+fichier est découpé en morceaux de CAPTURE_CHUNK_SAMPLES échantillons, chacun avec
+sa date, sa fréquence centrale et son gain, puis terminé par un index des dates.
+*/
+struct captureWriter* createCaptureWriter(const char* path, double sampleRate, double startTime){
+    struct captureWriter* writer = (struct captureWriter*) calloc(1,sizeof(struct captureWriter));
+    if(writer == NULL){
+        return NULL;
+    }
+    writer->file = fopen(path,"wb");
+    writer->samples = (uint8_t*) malloc(2*CAPTURE_CHUNK_SAMPLES);
+    writer->values = (uint8_t*) malloc(2*CAPTURE_CHUNK_SAMPLES);
+    writer->data = (uint8_t*) malloc(2*CAPTURE_CHUNK_SAMPLES*MAX_BITS_PER_VALUE/8+CAPTURE_CHUNK_SAMPLES/8+8);
+    if(writer->file == NULL || writer->samples == NULL || writer->values == NULL || writer->data == NULL){
+        closeCaptureWriter(writer);
+        return NULL;
+    }
+    struct captureFileHeader header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,CAPTURE_MAGIC,8);
+    header.sampleRate = sampleRate;
+    header.startTime = startTime;
+    header.chunkSamples = CAPTURE_CHUNK_SAMPLES;
+    if(fwrite(&header,sizeof(header),1,writer->file) != 1){
+        closeCaptureWriter(writer);
+        return NULL;
+    }
+    writer->sampleRate = sampleRate;
+    writer->startTime = startTime;
+    return writer;
+}
+
+/*
+Fonction : setCaptureMetadata
+Entrées : écrivain, fréquence centrale (Hz), gain (dB)
+Sorties : 
+Les valeurs s'appliquent au morceau en cours : le morceau est terminé avant le
+changement pour que chaque morceau ait une seule fréquence et un seul gain.
+*/
+void setCaptureMetadata(struct captureWriter* writer, double centerFrequency, float gain){
+    if(writer->nbSamples > 0 && (centerFrequency != writer->centerFrequency || gain != writer->gain)){
+        flushCapture(writer);
+    }
+    writer->centerFrequency = centerFrequency;
+    writer->gain = gain;
+}
+
+/*
+Fonction : appendCaptureSamples
+Entrées : écrivain, échantillons cu8 (I puis Q), nombre d'échantillons
+Sorties : 0 en cas de succès, -1 en cas d'erreur d'écriture
+*/
+int appendCaptureSamples(struct captureWriter* writer, const uint8_t* samples, int nbSamples){
+    while(nbSamples > 0){
+        int size = CAPTURE_CHUNK_SAMPLES-writer->nbSamples;
+        if(size > nbSamples){
+            size = nbSamples;
+        }
+        memcpy(writer->samples+2*writer->nbSamples,samples,2*size);
+        writer->nbSamples += size;
+        samples += 2*size;
+        nbSamples -= size;
+        if(writer->nbSamples == CAPTURE_CHUNK_SAMPLES && flushCapture(writer) < 0){
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+Fonction : flushCapture
+Entrées : écrivain
+Sorties : 0 en cas de succès, -1 en cas d'erreur d'écriture
+Écrit le morceau en attente. Les valeurs sont soit recentrées autour de 128, soit
+remplacées par la différence avec la valeur précédente de la même voie, puis codées
+par un code de Rice dont le paramètre est choisi pour chaque bloc de
+CAPTURE_BLOCK_VALUES valeurs. La variante la plus courte est gardée, et le morceau
+reste brut si le codage ne gagne rien (signal fort et large bande).
+*/
+int flushCapture(struct captureWriter* writer){
+    if(writer->nbSamples == 0){
+        return 0;
+    }
+    struct captureChunkHeader header;
+    memset(&header,0,sizeof(header));
+    header.magic = CHUNK_MAGIC;
+    header.nbSamples = writer->nbSamples;
+    header.firstSample = writer->totalSamples;
+    header.timestamp = writer->startTime+writer->totalSamples/writer->sampleRate;
+    header.centerFrequency = writer->centerFrequency;
+    header.gain = writer->gain;
+    header.method = CAPTURE_RAW;
+    header.dataSize = 2*writer->nbSamples;
+
+    int nbValues = 2*writer->nbSamples;
+    long long bestCost = 8LL*nbValues;
+    for(int method=CAPTURE_CENTERED; method<=CAPTURE_DELTA; method++){
+        long long cost = 0;
+        prepareValues(writer->samples,nbValues,method,writer->values);
+        for(int i=0; i<nbValues; i+=CAPTURE_BLOCK_VALUES){
+            long long blockCost;
+            int size = nbValues-i < CAPTURE_BLOCK_VALUES ? nbValues-i : CAPTURE_BLOCK_VALUES;
+            chooseRiceParameter(writer->values+i,size,&blockCost);
+            cost += blockCost+3;
+        }
+        if(cost < bestCost){
+            bestCost = cost;
+            header.method = method;
+        }
+    }
+    const uint8_t* data = writer->samples;
+    if(header.method != CAPTURE_RAW){
+        prepareValues(writer->samples,nbValues,header.method,writer->values);
+        header.dataSize = encodeValues(writer->values,nbValues,writer->data);
+        data = writer->data;
+    }
+
+    if(writer->nbChunks == writer->indexCapacity){
+        int capacity = writer->indexCapacity == 0 ? 1024 : 2*writer->indexCapacity;
+        struct captureIndexEntry* index = (struct captureIndexEntry*) realloc(writer->index,capacity*sizeof(struct captureIndexEntry));
+        if(index == NULL){
+            return -1;
+        }
+        writer->index = index;
+        writer->indexCapacity = capacity;
+    }
+    struct captureIndexEntry* entry = writer->index+writer->nbChunks;
+    entry->timestamp = header.timestamp;
+    entry->offset = ftell(writer->file);
+    entry->firstSample = header.firstSample;
+    writer->nbChunks += 1;
+    writer->totalSamples += writer->nbSamples;
+    writer->nbSamples = 0;
+
+    if(fwrite(&header,sizeof(header),1,writer->file) != 1
+        || fwrite(data,1,header.dataSize,writer->file) != header.dataSize){
+        return -1;
+    }
+    return fflush(writer->file) == 0 ? 0 : -1;
+}
+
+/*
+Fonction : closeCaptureWriter
+Entrées : écrivain
+Sorties : 0 en cas de succès, -1 en cas d'erreur d'écriture
+Écrit le dernier morceau, l'index des dates puis ferme le fichier. Un fichier
+sans index (arrêt brutal) reste lisible : l'index est alors reconstruit.
+*/
+int closeCaptureWriter(struct captureWriter* writer){
+    int status = 0;
+    if(writer == NULL){
+        return 0;
+    }
+    if(writer->file != NULL){
+        if(writer->samples != NULL && writer->values != NULL && writer->data != NULL){
+            status = flushCapture(writer);
+            struct captureTrailer trailer;
+            trailer.magic = TRAILER_MAGIC;
+            trailer.nbChunks = writer->nbChunks;
+            trailer.indexOffset = ftell(writer->file);
+            if(fwrite(writer->index,sizeof(struct captureIndexEntry),writer->nbChunks,writer->file) != (size_t)writer->nbChunks
+                || fwrite(&trailer,sizeof(trailer),1,writer->file) != 1){
+                status = -1;
+            }
+        }
+        if(fclose(writer->file) != 0){
+            status = -1;
+        }
+    }
+    free(writer->samples);
+    free(writer->values);
+    free(writer->data);
+    free(writer->index);
+    free(writer);
+    return status;
+}
+
+/*
+Fonction : openCaptureReader
+Entrées : chemin de l'enregistrement
+Sorties : le lecteur, NULL en cas d'erreur
+Le fichier est projeté en mémoire ; seul l'index est chargé.
+*/
+struct captureReader* openCaptureReader(const char* path){
+    int fd = open(path,O_RDONLY);
+    if(fd < 0){
+        return NULL;
+    }
+    struct stat status;
+    if(fstat(fd,&status) < 0 || (size_t)status.st_size < sizeof(struct captureFileHeader)){
+        close(fd);
+        return NULL;
+    }
+    struct captureReader* reader = (struct captureReader*) calloc(1,sizeof(struct captureReader));
+    if(reader == NULL){
+        close(fd);
+        return NULL;
+    }
+    reader->size = status.st_size;
+    reader->map = (uint8_t*) mmap(NULL,reader->size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(reader->map == MAP_FAILED){
+        free(reader);
+        return NULL;
+    }
+    struct captureFileHeader header;
+    memcpy(&header,reader->map,sizeof(header));
+    if(memcmp(header.magic,CAPTURE_MAGIC,8) != 0){
+        munmap(reader->map,reader->size);
+        free(reader);
+        return NULL;
+    }
+    reader->sampleRate = header.sampleRate;
+    reader->startTime = header.startTime;
+
+    struct captureTrailer trailer;
+    memset(&trailer,0,sizeof(trailer));
+    if(reader->size >= sizeof(header)+sizeof(trailer)){
+        memcpy(&trailer,reader->map+reader->size-sizeof(trailer),sizeof(trailer));
+    }
+    if(trailer.magic == TRAILER_MAGIC && trailer.indexOffset+(uint64_t)trailer.nbChunks*sizeof(struct captureIndexEntry)+sizeof(trailer) == reader->size){
+        reader->nbChunks = trailer.nbChunks;
+        reader->index = (struct captureIndexEntry*) malloc((reader->nbChunks+1)*sizeof(struct captureIndexEntry));
+        if(reader->index != NULL){
+            memcpy(reader->index,reader->map+trailer.indexOffset,reader->nbChunks*sizeof(struct captureIndexEntry));
+        }
+    } else if(rebuildCaptureIndex(reader) < 0){
+        reader->index = NULL;
+    }
+    if(reader->index == NULL){
+        closeCaptureReader(reader);
+        return NULL;
+    }
+    if(reader->nbChunks > 0){
+        struct captureChunkHeader last;
+        memcpy(&last,reader->map+(reader->index+reader->nbChunks-1)->offset,sizeof(last));
+        reader->nbSamples = last.firstSample+last.nbSamples;
+    }
+    return reader;
+}
+
+void closeCaptureReader(struct captureReader* reader){
+    if(reader == NULL){
+        return;
+    }
+    munmap(reader->map,reader->size);
+    free(reader->index);
+    free(reader);
+}
+
+/*
+Fonction : decodeCaptureChunk
+Entrées : lecteur, numéro du morceau, vecteur pour recevoir les échantillons cu8 (2*CAPTURE_CHUNK_SAMPLES octets),
+en-tête du morceau en sortie (peut être NULL)
+Sorties : le nombre d'échantillons du morceau, -1 si le morceau est invalide
+*/
+int decodeCaptureChunk(struct captureReader* reader, int chunk, uint8_t* output, struct captureChunkHeader* header){
+    if(chunk < 0 || chunk >= reader->nbChunks){
+        return -1;
+    }
+    struct captureChunkHeader current;
+    uint64_t offset = (reader->index+chunk)->offset;
+    memcpy(&current,reader->map+offset,sizeof(current));
+    const uint8_t* data = reader->map+offset+sizeof(current);
+    if(current.magic != CHUNK_MAGIC || current.nbSamples > CAPTURE_CHUNK_SAMPLES
+        || offset+sizeof(current)+current.dataSize > reader->size){
+        return -1;
+    }
+    if(current.method == CAPTURE_RAW){
+        if(current.dataSize != 2*current.nbSamples){
+            return -1;
+        }
+        memcpy(output,data,current.dataSize);
+    } else {
+        decodeValues(data,data+current.dataSize,2*current.nbSamples,current.method,output);
+    }
+    if(header != NULL){
+        *header = current;
+    }
+    return current.nbSamples;
+}
+
+/*
+Fonction : findCaptureChunk
+Entrées : lecteur, date (s depuis 1970)
+Sorties : le numéro du dernier morceau commencé à cette date, 0 si elle précède l'enregistrement
+Recherche dichotomique dans l'index.
+*/
+int findCaptureChunk(struct captureReader* reader, double timestamp){
+    int low = 0;
+    int high = reader->nbChunks-1;
+    while(low < high){
+        int middle = (low+high+1)/2;
+        if((reader->index+middle)->timestamp <= timestamp){
+            low = middle;
+        } else {
+            high = middle-1;
+        }
+    }
+    return low;
+}
+
+/*
+Fonction : findCaptureSample
+Entrées : lecteur, numéro d'échantillon
+Sorties : le numéro du morceau contenant l'échantillon
+*/
+int findCaptureSample(struct captureReader* reader, uint64_t sample){
+    int low = 0;
+    int high = reader->nbChunks-1;
+    while(low < high){
+        int middle = (low+high+1)/2;
+        if((reader->index+middle)->firstSample <= sample){
+            low = middle;
+        } else {
+            high = middle-1;
+        }
+    }
+    return low;
+}
+
+/*
+Fonction : openCaptureInput
+Entrées : chemin de l'enregistrement
+Sorties : une entrée IQ qui décompresse l'enregistrement morceau par morceau, NULL en cas d'erreur
+L'entrée peut être repositionnée (seekIqInput, seekCaptureTime).
+*/
+struct iqInput* openCaptureInput(const char* path){
+    struct iqInput* input = (struct iqInput*) calloc(1,sizeof(struct iqInput));
+    if(input == NULL){
+        return NULL;
+    }
+    input->capture = openCaptureReader(path);
+    input->chunkSamples = (uint8_t*) malloc(2*CAPTURE_CHUNK_SAMPLES);
+    if(input->capture == NULL || input->chunkSamples == NULL){
+        closeCaptureReader(input->capture);
+        free(input->chunkSamples);
+        free(input);
+        return NULL;
+    }
+    input->fd = -1;
+    input->format = IQ_CU8;
+    input->sampleSize = 2;
+    input->nbSamples = input->capture->nbSamples;
+    input->chunk = -1;
+    return input;
+}
+
+/*
+Fonction : seekCaptureTime
+Entrées : entrée ouverte par openCaptureInput, date (s depuis 1970)
+Sorties : 0 en cas de succès, -1 si la date est hors de l'enregistrement
+*/
+int seekCaptureTime(struct iqInput* input, double timestamp){
+    struct captureReader* reader = input->capture;
+    if(reader == NULL || reader->nbChunks == 0){
+        return -1;
+    }
+    struct captureIndexEntry* entry = reader->index+findCaptureChunk(reader,timestamp);
+    if(timestamp < entry->timestamp){
+        return -1;
+    }
+    long long sample = entry->firstSample+(long long)floor((timestamp-entry->timestamp)*reader->sampleRate+0.5);
+    return seekIqInput(input,sample);
+}
+
+/*
+Fonction : prepareValues
+Entrées : échantillons cu8, nombre de valeurs (2 par échantillon), méthode, vecteur pour recevoir les valeurs
+Sorties : 
+Valeurs signées (écart à 128 ou différence avec la valeur précédente de la même
+voie, modulo 256) rangées en entiers positifs : 0, -1, 1, -2, 2...
+*/
+void prepareValues(const uint8_t* samples, int nbValues, int method, uint8_t* values){
+    uint8_t previous[2] = {128, 128};
+    for(int i=0; i<nbValues; i++){
+        int8_t value;
+        if(method == CAPTURE_DELTA){
+            value = (int8_t)(uint8_t)(*(samples+i)-previous[i & 1]);
+            previous[i & 1] = *(samples+i);
+        } else {
+            value = (int8_t)(uint8_t)(*(samples+i)-128);
+        }
+        *(values+i) = (uint8_t)((value << 1) ^ (value >> 7));
+    }
+}
+
+/*
+Fonction : chooseRiceParameter
+Entrées : valeurs, nombre de valeurs, coût en bits en sortie
+Sorties : le paramètre de Rice (0 à 7) donnant le codage le plus court
+*/
+int chooseRiceParameter(const uint8_t* values, int nbValues, long long* cost){
+    int best = 0;
+    *cost = -1;
+    for(int k=0; k<8; k++){
+        long long bits = 0;
+        for(int i=0; i<nbValues; i++){
+            int quotient = *(values+i) >> k;
+            bits += quotient < CAPTURE_RICE_ESCAPE ? quotient+1+k : CAPTURE_RICE_ESCAPE+8;
+        }
+        if(*cost < 0 || bits < *cost){
+            *cost = bits;
+            best = k;
+        }
+    }
+    return best;
+}
+
+/*
+Fonction : encodeValues
+Entrées : valeurs, nombre de valeurs, vecteur pour recevoir le flux de bits
+Sorties : la taille du flux en octets
+Chaque bloc commence par son paramètre k sur 3 bits. Une valeur u est codée par
+u>>k en unaire (des 1 terminés par un 0) puis ses k bits de poids faible ; au-delà
+de CAPTURE_RICE_ESCAPE, CAPTURE_RICE_ESCAPE uns sont suivis de la valeur sur 8 bits.
+*/
+int encodeValues(const uint8_t* values, int nbValues, uint8_t* output){
+    struct bitWriter writer = {output, 0, 0};
+    for(int i=0; i<nbValues; i+=CAPTURE_BLOCK_VALUES){
+        long long cost;
+        int size = nbValues-i < CAPTURE_BLOCK_VALUES ? nbValues-i : CAPTURE_BLOCK_VALUES;
+        int k = chooseRiceParameter(values+i,size,&cost);
+        putBits(&writer,k,3);
+        for(int j=i; j<i+size; j++){
+            uint32_t quotient = *(values+j) >> k;
+            if(quotient < CAPTURE_RICE_ESCAPE){
+                uint32_t code = ((1u << quotient)-1) << (k+1);
+                putBits(&writer,code | (*(values+j) & ((1u << k)-1)),quotient+1+k);
+            } else {
+                putBits(&writer,(((1u << CAPTURE_RICE_ESCAPE)-1) << 8) | *(values+j),CAPTURE_RICE_ESCAPE+8);
+            }
+        }
+    }
+    if(writer.nbBits > 0){
+        putBits(&writer,0,8-writer.nbBits);
+    }
+    return writer.output-output;
+}
+
+/*
+Fonction : decodeValues
+Entrées : flux de bits, fin du flux, nombre de valeurs, méthode, vecteur pour recevoir les échantillons cu8
+Sorties : 
+*/
+void decodeValues(const uint8_t* input, const uint8_t* end, int nbValues, int method, uint8_t* output){
+    struct bitReader reader = {input, end, 0, 0};
+    uint8_t previous[2] = {128, 128};
+    for(int i=0; i<nbValues; i+=CAPTURE_BLOCK_VALUES){
+        int size = nbValues-i < CAPTURE_BLOCK_VALUES ? nbValues-i : CAPTURE_BLOCK_VALUES;
+        refillBits(&reader);
+        int k = takeBits(&reader,3);
+        for(int j=i; j<i+size; j++){
+            refillBits(&reader);
+            int ones = ~reader.accumulator == 0 ? 64 : __builtin_clzll(~reader.accumulator);
+            uint32_t value;
+            if(ones >= CAPTURE_RICE_ESCAPE){
+                takeBits(&reader,CAPTURE_RICE_ESCAPE);
+                value = takeBits(&reader,8);
+            } else {
+                takeBits(&reader,ones+1);
+                value = ((uint32_t)ones << k) | takeBits(&reader,k);
+            }
+            int8_t signedValue = (int8_t)((value >> 1) ^ -(value & 1));
+            if(method == CAPTURE_DELTA){
+                previous[j & 1] = (uint8_t)(previous[j & 1]+signedValue);
+                *(output+j) = previous[j & 1];
+            } else {
+                *(output+j) = (uint8_t)(signedValue+128);
+            }
+        }
+    }
+}
+
+void putBits(struct bitWriter* writer, uint32_t value, int nbBits){
+    writer->accumulator = (writer->accumulator << nbBits) | value;
+    writer->nbBits += nbBits;
+    while(writer->nbBits >= 8){
+        *writer->output = (uint8_t)(writer->accumulator >> (writer->nbBits-8));
+        writer->output += 1;
+        writer->nbBits -= 8;
+    }
+}
+
+/*
+Fonction : refillBits
+Entrées : lecteur de bits
+Sorties : 
+Garde au moins 57 bits d'avance dans l'accumulateur (bits de poids fort en tête).
+Au-delà de la fin du flux, des zéros sont lus.
+*/
+void refillBits(struct bitReader* reader){
+    while(reader->nbBits <= 56){
+        uint64_t byte = reader->input < reader->end ? *reader->input : 0;
+        reader->accumulator |= byte << (56-reader->nbBits);
+        reader->input += 1;
+        reader->nbBits += 8;
+    }
+}
+
+uint32_t takeBits(struct bitReader* reader, int nbBits){
+    if(nbBits == 0){
+        return 0;
+    }
+    uint32_t value = (uint32_t)(reader->accumulator >> (64-nbBits));
+    reader->accumulator <<= nbBits;
+    reader->nbBits -= nbBits;
+    return value;
+}
+
+/*
+Fonction : rebuildCaptureIndex
+Entrées : lecteur
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+Parcourt les morceaux d'un enregistrement sans index ; le dernier morceau est
+ignoré s'il est incomplet.
+*/
+int rebuildCaptureIndex(struct captureReader* reader){
+    int capacity = 1024;
+    reader->nbChunks = 0;
+    reader->index = (struct captureIndexEntry*) malloc(capacity*sizeof(struct captureIndexEntry));
+    uint64_t offset = sizeof(struct captureFileHeader);
+    while(reader->index != NULL && offset+sizeof(struct captureChunkHeader) <= reader->size){
+        struct captureChunkHeader header;
+        memcpy(&header,reader->map+offset,sizeof(header));
+        if(header.magic != CHUNK_MAGIC || offset+sizeof(header)+header.dataSize > reader->size){
+            break;
+        }
+        if(reader->nbChunks == capacity){
+            capacity *= 2;
+            struct captureIndexEntry* index = (struct captureIndexEntry*) realloc(reader->index,capacity*sizeof(struct captureIndexEntry));
+            if(index == NULL){
+                free(reader->index);
+                reader->index = NULL;
+                return -1;
+            }
+            reader->index = index;
+        }
+        (reader->index+reader->nbChunks)->timestamp = header.timestamp;
+        (reader->index+reader->nbChunks)->offset = offset;
+        (reader->index+reader->nbChunks)->firstSample = header.firstSample;
+        reader->nbChunks += 1;
+        offset += sizeof(header)+header.dataSize;
+    }
+    return reader->index == NULL ? -1 : 0;
+}
@@ -0,0 +1,92 @@
+#ifndef HEADER_CAPTURE
+#define HEADER_CAPTURE
+
+#include "iqInput.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CAPTURE_CHUNK_SAMPLES (1024*1024)
+#define CAPTURE_BLOCK_VALUES 256
+#define CAPTURE_RICE_ESCAPE 16
+
+#define CAPTURE_RAW 0
+#define CAPTURE_CENTERED 1
+#define CAPTURE_DELTA 2
+
+struct captureFileHeader
+{
+    char magic[8];
+    double sampleRate;
+    double startTime;
+    uint32_t chunkSamples;
+    uint32_t reserved;
+};
+
+struct captureChunkHeader
+{
+    uint32_t magic;
+    uint32_t nbSamples;
+    uint32_t dataSize;
+    uint32_t method;
+    uint64_t firstSample;
+    double timestamp;
+    double centerFrequency;
+    float gain;
+    uint32_t reserved;
+};
+
+struct captureIndexEntry
+{
+    double timestamp;
+    uint64_t offset;
+    uint64_t firstSample;
+};
+
+struct captureTrailer
+{
+    uint32_t magic;
+    uint32_t nbChunks;
+    uint64_t indexOffset;
+};
+
+struct captureWriter
+{
+    FILE* file;
+    double sampleRate, startTime;
+    double centerFrequency;
+    float gain;
+    uint8_t* samples;
+    int nbSamples;
+    uint8_t* values;
+    uint8_t* data;
+    uint64_t totalSamples;
+    struct captureIndexEntry* index;
+    int nbChunks, indexCapacity;
+};
+
+struct captureReader
+{
+    uint8_t* map;
+    size_t size;
+    double sampleRate, startTime;
+    struct captureIndexEntry* index;
+    int nbChunks;
+    uint64_t nbSamples;
+};
+
+struct captureWriter* createCaptureWriter(const char* path, double sampleRate, double startTime);
+void setCaptureMetadata(struct captureWriter* writer, double centerFrequency, float gain);
+int appendCaptureSamples(struct captureWriter* writer, const uint8_t* samples, int nbSamples);
+int flushCapture(struct captureWriter* writer);
+int closeCaptureWriter(struct captureWriter* writer);
+struct captureReader* openCaptureReader(const char* path);
+void closeCaptureReader(struct captureReader* reader);
+int decodeCaptureChunk(struct captureReader* reader, int chunk, uint8_t* output, struct captureChunkHeader* header);
+int findCaptureChunk(struct captureReader* reader, double timestamp);
+int findCaptureSample(struct captureReader* reader, uint64_t sample);
+struct iqInput* openCaptureInput(const char* path);
+int seekCaptureTime(struct iqInput* input, double timestamp);
+
+#endif
@@ -0,0 +1,105 @@
+#include "channelModel.h"
+
+uint64_t splitMix(uint64_t* value);
+
+/*
+Fonction : seedRandom
+Entrées : générateur, graine, numéro de flux
+Sorties :
+Générateur xoshiro256** : chaque couple (graine, flux) donne une suite indépendante,
+si bien qu'un calcul découpé en unités de travail numérotées rend le même résultat
+quel que soit le nombre de fils.
+*/
+void seedRandom(struct randomState* random, uint64_t seed, uint64_t stream){
+    uint64_t value = seed ^ (stream*0xD1342543DE82EF95ULL);
+    for(int i=0; i<4; i++){
+        random->state[i] = splitMix(&value);
+    }
+    random->hasNormal = 0;
+}
+
+uint64_t splitMix(uint64_t* value){
+    uint64_t z = (*value += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t randomNext(struct randomState* random){
+    uint64_t* s = random->state;
+    uint64_t product = s[1]*5;
+    uint64_t result = ((product << 7) | (product >> 57))*9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return result;
+}
+
+/*
+Fonction : randomUniform
+Entrées : générateur
+Sorties : un réel uniforme dans [0, 1[
+*/
+double randomUniform(struct randomState* random){
+    return (randomNext(random) >> 11)*0x1.0p-53;
+}
+
+/*
+Fonction : randomNormal
+Entrées : générateur
+Sorties : un réel de loi normale centrée réduite
+Méthode polaire de Marsaglia (Box-Muller sans sinus ni cosinus), le second tirage est
+gardé pour l'appel suivant.
+*/
+double randomNormal(struct randomState* random){
+    if(random->hasNormal){
+        random->hasNormal = 0;
+        return random->normal;
+    }
+    double u, v, s;
+    do {
+        u = 2*randomUniform(random)-1;
+        v = 2*randomUniform(random)-1;
+        s = u*u+v*v;
+    } while(s >= 1 || s == 0);
+    double factor = sqrt(-2.0*log(s)/s);
+    random->normal = v*factor;
+    random->hasNormal = 1;
+    return u*factor;
+}
+
+/*
+Fonction : rotateSignal
+Entrées : échantillons, nombre d'échantillons, phase initiale, pas de phase par échantillon (rad)
+Sorties :
+Multiplie le signal par exp(j(phase+n*pas)) : un pas non nul décale la fréquence de
+pas/(2*pi) fois la fréquence d'échantillonnage.
+*/
+void rotateSignal(struct complex* samples, int size, double phase, double phaseStep){
+    for(int i=0; i<size; i++){
+        double angle = phase+i*phaseStep;
+        struct complex rotation;
+        rotation.real = cos(angle);
+        rotation.imag = sin(angle);
+        *(samples+i) = complexProduct(*(samples+i),rotation);
+    }
+}
+
+/*
+Fonction : addNoise
+Entrées : générateur, échantillons, nombre d'échantillons, puissance du bruit par échantillon
+Sorties :
+Bruit blanc gaussien complexe, comme AWGN.propagate en Python : avec un signal de
+puissance 1, le rapport signal sur bruit vaut 1/puissance du bruit.
+*/
+void addNoise(struct randomState* random, struct complex* samples, int size, double noisePower){
+    double deviation = sqrt(noisePower/2);
+    for(int i=0; i<size; i++){
+        (samples+i)->real += deviation*randomNormal(random);
+        (samples+i)->imag += deviation*randomNormal(random);
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef HEADER_CHANNELMODEL
+#define HEADER_CHANNELMODEL
+
+#include "complexLib.h"
+#include <stdint.h>
+
+struct randomState
+{
+    uint64_t state[4];
+    int hasNormal;
+    double normal;
+};
+
+void seedRandom(struct randomState* random, uint64_t seed, uint64_t stream);
+uint64_t randomNext(struct randomState* random);
+double randomUniform(struct randomState* random);
+double randomNormal(struct randomState* random);
+void rotateSignal(struct complex* samples, int size, double phase, double phaseStep);
+void addNoise(struct randomState* random, struct complex* samples, int size, double noisePower);
+
+#endif
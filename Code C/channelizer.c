@@ -0,0 +1,145 @@
+#include "channelizer.h"
+
+/*
+Fonction : createChannelizer
+Entrées : fréquence d'échantillonnage d'entrée, écart entre le canal et la fréquence centrale de l'enregistrement (Hz),
+fréquence d'échantillonnage de sortie
+Sorties : le filtre de canal alloué, NULL en cas d'erreur
+Le canal est ramené en bande de base par un oscillateur numérique, filtré par un
+passe-bas à fenêtre de Hamming, puis rééchantillonné par interpolation linéaire à
+la fréquence de sortie. Le filtre n'est évalué qu'aux instants où une sortie en a
+besoin, ce qui limite le coût en décimation.
+*/
+struct channelizer* createChannelizer(double inputRate, double offsetFrequency, double outputRate){
+    struct channelizer* ch = (struct channelizer*) calloc(1,sizeof(struct channelizer));
+    if(ch == NULL){
+        return NULL;
+    }
+    double cutoff = fmin(CHANNEL_CUTOFF,0.4*fmin(inputRate,outputRate));
+    ch->nbTaps = 2*(int)ceil(1.65*inputRate/cutoff)+1;
+    if(ch->nbTaps > CHANNEL_MAX_TAPS){
+        ch->nbTaps = CHANNEL_MAX_TAPS;
+    }
+    ch->taps = (float*) malloc(ch->nbTaps*sizeof(float));
+    ch->history = (struct complex*) calloc(2*ch->nbTaps,sizeof(struct complex));
+    if(ch->taps == NULL || ch->history == NULL){
+        freeChannelizer(ch);
+        return NULL;
+    }
+    double sum = 0;
+    int middle = ch->nbTaps/2;
+    for(int i=0; i<ch->nbTaps; i++){
+        double x = 2*cutoff/inputRate*(i-middle);
+        double sinc = i == middle ? 1.0 : sin(M_PI*x)/(M_PI*x);
+        double window = 0.54-0.46*cos(2*M_PI*i/(ch->nbTaps-1));
+        *(ch->taps+i) = sinc*window;
+        sum += sinc*window;
+    }
+    for(int i=0; i<ch->nbTaps; i++){
+        *(ch->taps+i) /= sum;
+    }
+    ch->inputRate = inputRate;
+    ch->outputRate = outputRate;
+    ch->step = inputRate/outputRate;
+    ch->offset = offsetFrequency;
+    ch->position = 1.0;
+    ch->phaseReal = 1.0;
+    ch->phaseImag = 0.0;
+    ch->rotationReal = cos(-2*M_PI*offsetFrequency/inputRate);
+    ch->rotationImag = sin(-2*M_PI*offsetFrequency/inputRate);
+    ch->lastFiltered = -1;
+    return ch;
+}
+
+void freeChannelizer(struct channelizer* ch){
+    if(ch == NULL){
+        return;
+    }
+    free(ch->taps);
+    free(ch->history);
+    free(ch);
+}
+
+/*
+Fonction : channelizerMaxOutput
+Entrées : filtre de canal, nombre d'échantillons d'entrée
+Sorties : le nombre maximal d'échantillons produits pour cette entrée
+*/
+int channelizerMaxOutput(struct channelizer* ch, int nbInput){
+    return (int)ceil(nbInput/ch->step)+2;
+}
+
+/*
+Fonction : resetChannelizer
+Entrées : filtre de canal, indice du prochain échantillon d'entrée, indice de la prochaine sortie
+Sorties : 
+Prépare le filtre à reprendre au milieu d'un enregistrement : l'oscillateur et le
+rééchantillonneur sont remis dans l'état qu'ils auraient eu en traitant tout depuis
+le début, et les sorties retombent aux mêmes instants. L'historique du filtre est
+vidé ; les nbTaps premières sorties ne sont donc pas fiables. firstInput doit valoir
+floor(1+firstOutput*step)-1.
+*/
+void resetChannelizer(struct channelizer* ch, long long firstInput, long long firstOutput){
+    double angle = fmod(-2*M_PI*ch->offset/ch->inputRate*firstInput,2*M_PI);
+    ch->phaseReal = cos(angle);
+    ch->phaseImag = sin(angle);
+    memset(ch->history,0,2*ch->nbTaps*sizeof(struct complex));
+    ch->historyIndex = 0;
+    ch->nbInput = firstInput;
+    ch->position = 1.0+firstOutput*ch->step;
+    ch->lastFiltered = -1;
+}
+
+/*
+Fonction : channelize
+Entrées : filtre de canal, échantillons d'entrée, nombre d'échantillons d'entrée, vecteur pour recevoir la sortie, taille du vecteur de sortie
+Sorties : le nombre d'échantillons produits
+L'état (oscillateur, historique du filtre, phase du rééchantillonneur) est conservé
+d'un appel à l'autre : l'entrée peut être découpée en blocs de taille quelconque.
+*/
+int channelize(struct channelizer* ch, struct complex* input, int nbInput, struct complex* output, int maxOutput){
+    int nbOutput = 0;
+    for(int i=0; i<nbInput; i++){
+        struct complex sample = *(input+i);
+        struct complex mixed;
+        mixed.real = sample.real*ch->phaseReal-sample.imag*ch->phaseImag;
+        mixed.imag = sample.real*ch->phaseImag+sample.imag*ch->phaseReal;
+        double real = ch->phaseReal*ch->rotationReal-ch->phaseImag*ch->rotationImag;
+        ch->phaseImag = ch->phaseReal*ch->rotationImag+ch->phaseImag*ch->rotationReal;
+        ch->phaseReal = real;
+        if((ch->nbInput & 1023) == 0){
+            double norm = sqrt(ch->phaseReal*ch->phaseReal+ch->phaseImag*ch->phaseImag);
+            ch->phaseReal /= norm;
+            ch->phaseImag /= norm;
+        }
+
+        *(ch->history+ch->historyIndex) = mixed;
+        *(ch->history+ch->historyIndex+ch->nbTaps) = mixed;
+        ch->historyIndex = (ch->historyIndex+1) % ch->nbTaps;
+        long long current = ch->nbInput;
+        ch->nbInput += 1;
+
+        // Le filtre n'est évalué que si une sortie tombe dans [current-1, current+1[
+        if(ch->position >= current+1){
+            continue;
+        }
+        struct complex* window = ch->history+ch->historyIndex;
+        struct complex filtered = {0, 0};
+        for(int k=0; k<ch->nbTaps; k++){
+            filtered.real += *(ch->taps+k)*(window+k)->real;
+            filtered.imag += *(ch->taps+k)*(window+k)->imag;
+        }
+        ch->filtered[0] = ch->lastFiltered == current-1 ? ch->filtered[1] : filtered;
+        ch->filtered[1] = filtered;
+        ch->lastFiltered = current;
+
+        while(ch->position < current && nbOutput < maxOutput){
+            float fraction = ch->position-(current-1);
+            (output+nbOutput)->real = ch->filtered[0].real+fraction*(ch->filtered[1].real-ch->filtered[0].real);
+            (output+nbOutput)->imag = ch->filtered[0].imag+fraction*(ch->filtered[1].imag-ch->filtered[0].imag);
+            nbOutput += 1;
+            ch->position += ch->step;
+        }
+    }
+    return nbOutput;
+}
@@ -0,0 +1,38 @@
+#ifndef HEADER_CHANNELIZER
+#define HEADER_CHANNELIZER
+
+#include "complexLib.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHANNEL_A_FREQUENCY 161975000.0
+#define CHANNEL_B_FREQUENCY 162025000.0
+#define CHANNEL_CUTOFF 9000.0
+#define CHANNEL_MAX_TAPS 1025
+#define CHANNEL_SAMPLES_PER_BIT 10
+
+struct channelizer
+{
+    double inputRate, outputRate;
+    double step;
+    double offset;
+    double position;
+    double phaseReal, phaseImag;
+    double rotationReal, rotationImag;
+    int nbTaps;
+    float* taps;
+    struct complex* history;
+    int historyIndex;
+    long long nbInput;
+    long long lastFiltered;
+    struct complex filtered[2];
+};
+
+struct channelizer* createChannelizer(double inputRate, double offsetFrequency, double outputRate);
+void freeChannelizer(struct channelizer* ch);
+int channelize(struct channelizer* ch, struct complex* input, int nbInput, struct complex* output, int maxOutput);
+int channelizerMaxOutput(struct channelizer* ch, int nbInput);
+void resetChannelizer(struct channelizer* ch, long long firstInput, long long firstOutput);
+
+#endif
@@ -6,11 +6,11 @@ Entrées : vecteur complexe avec données, vecteur complexe pour recevoir donné
 Sorties : 
 Permet de retarder le vecteur d'entrée pour le calcul de la démodulation
 */
-void delayVector(struct complex* inputVector,struct complex* delayedVector){
+void delayVector(struct complex* inputVector,struct complex* delayedVector, int size, int timeDelay){
     struct complex zeroComplex;
     zeroComplex.real=0;
     zeroComplex.imag=0;
-    for(int i=0; i<sizeSignal; i++){
+    for(int i=0; i<size; i++){
         if(i<timeDelay){
             *(delayedVector + i)=zeroComplex;
         } else {
@@ -25,8 +25,8 @@ Entrées : vecteur complexe avec données, vecteur complexe avec données retard
 Sorties : 
 Permet de calculer la multiplication entre les deux signaux
 */
-void computeMultSignals(struct complex* inputVector,struct complex* delayedVector){ 
-    for(int i=0; i<sizeSignal; i++){
+void computeMultSignals(struct complex* inputVector,struct complex* delayedVector, int size){ 
+    for(int i=0; i<size; i++){
         *(inputVector + i)=complexProduct(complexConjug(*(inputVector + i)),*(delayedVector + i));    
     }
     return;
@@ -38,9 +38,9 @@ Entrées : vecteur complexe avec données, vecteur d'entiers avec les bits calcu
 Sorties : 
 Permet de calculer les bits de sortie en fonction du signal d'entrée
 */
-void computeOutput(int* output,struct complex* buffer){
+void computeOutput(int* output,struct complex* buffer, int size, int timeDelay){
     int positionOutput = 0;
-    for(int i = 2*timeDelay-1; i<sizeSignal-timeDelay; i+=timeDelay){
+    for(int i = 2*timeDelay-1; i<size-timeDelay; i+=timeDelay){
         if(arg(*(buffer+i))>0){
             *(output+positionOutput)=1;
         } else {
@@ -58,9 +58,22 @@ Sorties :
 Permet de calculer la démodulation du signal d'entrée
 */
 void demodulate(struct complex* inputVector,struct complex* delayedVector, int* output){
-    delayVector(inputVector,delayedVector);
-    computeMultSignals(inputVector,delayedVector);
-    computeOutput(output,inputVector);
+    demodulateBlock(inputVector,delayedVector,output,sizeSignal,timeDelay);
+    return;
+}
+
+/*
+Fonction : demodulateBlock
+Entrées : vecteur complexe avec données, vecteur complexe pour recevoir données retardées, vecteur d'entiers avec les bits calculés,
+taille du bloc, nombre d'échantillons par bit
+Sorties : 
+Comme demodulate, pour une taille de bloc et un nombre d'échantillons par bit donnés.
+Le bloc produit size/delay-2 bits.
+*/
+void demodulateBlock(struct complex* inputVector,struct complex* delayedVector, int* output, int size, int delay){
+    delayVector(inputVector,delayedVector,size,delay);
+    computeMultSignals(inputVector,delayedVector,size);
+    computeOutput(output,inputVector,size,delay);
     return;
 }
 
@@ -5,6 +5,10 @@
 #include "complexLib.h"
 #include "signalCaracteristics.h"
 
+void delayVector(struct complex* inputVector,struct complex* delayedVector, int size, int timeDelay);
+void computeMultSignals(struct complex* inputVector,struct complex* delayedVector, int size);
+void computeOutput(int* output,struct complex* buffer, int size, int timeDelay);
 void demodulate(struct complex* inputVector,struct complex* delayedVector, int* output);
+void demodulateBlock(struct complex* inputVector,struct complex* delayedVector, int* output, int size, int delay);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include "fusion.h"
+#include <math.h>
+#include <strings.h>
+
+int checkNmeaChecksum(const char* line, int length);
+const char* nmeaField(const char* line, int length, int index, int* fieldLength);
+
+/*
+Fonction : createFusionSet
+Entrées : nombre de messages distincts attendus par fenêtre, largeur de la fenêtre de temps (s)
+Sorties : l'ensemble alloué, NULL en cas d'erreur
+Ensemble des messages déjà vus, découpé en FUSION_BUCKETS fenêtres de temps
+tournantes. Chaque fenêtre est une table à adressage ouvert de taille fixe dont les
+entrées portent le numéro de leur fenêtre : une entrée d'une fenêtre plus ancienne
+compte comme vide, si bien que rien n'est jamais effacé ni alloué après la création.
+Les entrées de fenêtres plus récentes sont gardées : une source en retard sur les
+autres ne fait pas oublier les messages récents. La
+mémoire est bornée et chaque message coûte au plus 3*FUSION_PROBES comparaisons.
+*/
+struct fusionSet* createFusionSet(int capacity, double window){
+    if(capacity < 1 || window <= 0){
+        return NULL;
+    }
+    struct fusionSet* set = (struct fusionSet*) calloc(1,sizeof(struct fusionSet));
+    if(set == NULL){
+        return NULL;
+    }
+    // Table remplie au plus à moitié
+    int size = 64;
+    while(size < 2*capacity){
+        size *= 2;
+    }
+    set->entries = (struct fusionEntry*) calloc((size_t)size*FUSION_BUCKETS,sizeof(struct fusionEntry));
+    if(set->entries == NULL){
+        free(set);
+        return NULL;
+    }
+    set->window = window;
+    set->capacity = size;
+    set->mask = size-1;
+    return set;
+}
+
+void freeFusionSet(struct fusionSet* set){
+    if(set == NULL){
+        return;
+    }
+    free(set->entries);
+    free(set);
+}
+
+/*
+Fonction : checkFusionMessage
+Entrées : ensemble, empreinte du message, date de réception (s), numéro de la source
+Sorties : 1 si le message est nouveau, 0 s'il a déjà été vu dans la fenêtre de sa date ou les deux voisines
+Les horloges des récepteurs pouvant différer, un message est comparé aux fenêtres
+précédente, courante et suivante. La source est ajoutée au masque des sources qui
+l'ont reçu. Si la table de la fenêtre est saturée, le message est déclaré nouveau
+sans être noté (compté dans nbOverflows) : un doublon peut alors passer, mais la
+mémoire et le temps restent bornés.
+*/
+int checkFusionMessage(struct fusionSet* set, uint64_t hash, double time, int source){
+    long long window = (long long)floor(time/set->window);
+    struct fusionEntry* empty = NULL;
+    for(long long w = window-1; w <= window+1; w++){
+        uint32_t epoch = (uint32_t)w+1;
+        struct fusionEntry* bucket = set->entries+(size_t)(((w % FUSION_BUCKETS)+FUSION_BUCKETS) % FUSION_BUCKETS)*set->capacity;
+        for(int i = 0; i < FUSION_PROBES; i++){
+            struct fusionEntry* entry = bucket+((hash+i) & set->mask);
+            // Une entrée d'une fenêtre plus récente (source en retard) est gardée
+            int32_t age = (int32_t)(epoch-entry->epoch);
+            if(entry->epoch == 0 || age > 0){
+                if(w == window && empty == NULL){
+                    empty = entry;
+                }
+                break;
+            }
+            if(age == 0 && entry->hash == hash){
+                entry->sources |= 1u << source;
+                return 0;
+            }
+        }
+    }
+    if(empty == NULL){
+        set->nbOverflows += 1;
+        return 1;
+    }
+    empty->hash = hash;
+    empty->epoch = (uint32_t)window+1;
+    empty->sources = 1u << source;
+    return 1;
+}
+
+/*
+Fonction : hashPayload
+Entrées : charge utile en armure AIS (tous les fragments à la suite), taille, bits de remplissage
+Sorties : l'empreinte sur 64 bits
+FNV-1a suivi d'un mélange final pour répartir les bits de poids faible.
+*/
+uint64_t hashPayload(const char* payload, int length, int fillBits){
+    uint64_t hash = 14695981039346656037ULL;
+    for(int i = 0; i < length; i++){
+        hash ^= (uint8_t)*(payload+i);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= (uint64_t)fillBits;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/*
+Fonction : addFusionLine
+Entrées : source, ligne reçue (sans fin de ligne), taille, date de réception (s)
+Sorties : le message complet si la ligne le termine, NULL sinon
+Accepte les phrases !AIVDM et !AIVDO, éventuellement précédées d'un bloc d'étiquettes
+NMEA 4 (\c:date,...*hh\) dont la date remplace celle de réception. Une source
+marquée needsTag (fichier lu d'un coup, dont la date de lecture ne dit rien) doit
+dater chaque phrase : les autres sont comptées dans nbUntagged et ignorées. Les messages en
+plusieurs phrases sont réassemblés par source, voie et numéro de séquence. Les
+autres lignes sont ignorées ; une somme de contrôle fausse, de la phrase ou du bloc
+d'étiquettes, est comptée en erreur et la phrase est rejetée.
+*/
+struct fusionMessage* addFusionLine(struct fusionSource* source, const char* line, int length, double now){
+    double time = now;
+    int tagged = 0;
+    int validTag = 1;
+    if(length > 0 && *line == '\\'){
+        const char* end = memchr(line+1,'\\',length-1);
+        if(end == NULL){
+            return NULL;
+        }
+        // Le bloc d'étiquettes a sa propre somme de contrôle
+        validTag = checkNmeaChecksum(line,end-line);
+        const char* date = line+1;
+        while(date < end){
+            if(*date == 'c' && *(date+1) == ':'){
+                double value = atof(date+2);
+                // Date en secondes ou en millisecondes
+                time = value > 1e11 ? value/1000 : value;
+                tagged = 1;
+                break;
+            }
+            const char* next = memchr(date,',',end-date);
+            date = next == NULL ? end : next+1;
+        }
+        length -= end+1-line;
+        line = end+1;
+    }
+    if(length < 15 || (strncmp(line,"!AIVDM,",7) != 0 && strncmp(line,"!AIVDO,",7) != 0)){
+        return NULL;
+    }
+    if(!validTag || !checkNmeaChecksum(line,length)){
+        source->nbErrors += 1;
+        return NULL;
+    }
+    if(source->needsTag && !tagged){
+        source->nbUntagged += 1;
+        return NULL;
+    }
+    int size;
+    const char* field = nmeaField(line,length,1,&size);
+    int nbFragments = size == 1 ? *field-'0' : 0;
+    field = nmeaField(line,length,2,&size);
+    int fragment = size == 1 ? *field-'0' : 0;
+    field = nmeaField(line,length,3,&size);
+    int sequence = size == 1 ? *field-'0' : 0;
+    field = nmeaField(line,length,4,&size);
+    int channel = size == 1 && *field == 'B' ? 1 : 0;
+    const char* payload = nmeaField(line,length,5,&size);
+    int fillLength;
+    field = nmeaField(line,length,6,&fillLength);
+    if(nbFragments < 1 || nbFragments > FUSION_MAX_FRAGMENTS || fragment < 1 || fragment > nbFragments
+        || sequence < 0 || sequence > 9 || payload == NULL || field == NULL){
+        source->nbErrors += 1;
+        return NULL;
+    }
+    struct fusionMessage* message = &source->pending[channel][sequence];
+    if(fragment == 1){
+        message->length = 0;
+        message->payloadLength = 0;
+        message->nbFragments = nbFragments;
+        message->nextFragment = 1;
+        message->time = time;
+    }
+    if(fragment != message->nextFragment || nbFragments != message->nbFragments
+        || message->length+length+3 > FUSION_MESSAGE_SIZE || message->payloadLength+size > FUSION_MESSAGE_SIZE){
+        // Fragment manquant ou message trop long : le message est abandonné
+        message->nextFragment = 0;
+        source->nbErrors += 1;
+        return NULL;
+    }
+    memcpy(message->text+message->length,line,length);
+    message->length += length;
+    message->text[message->length++] = '\r';
+    message->text[message->length++] = '\n';
+    memcpy(message->payload+message->payloadLength,payload,size);
+    message->payloadLength += size;
+    message->nextFragment += 1;
+    if(fragment < nbFragments){
+        return NULL;
+    }
+    message->fillBits = *field-'0';
+    message->nextFragment = 0;
+    return message;
+}
+
+int checkNmeaChecksum(const char* line, int length){
+    const char* star = memchr(line,'*',length);
+    if(star == NULL || star+3 > line+length){
+        return 0;
+    }
+    int checksum = 0;
+    for(const char* c = line+1; c < star; c++){
+        checksum ^= *c;
+    }
+    char expected[3];
+    snprintf(expected,sizeof(expected),"%02X",checksum);
+    return strncasecmp(star+1,expected,2) == 0;
+}
+
+/*
+Fonction : nmeaField
+Entrées : phrase, taille, numéro du champ (0 pour l'en-tête), taille du champ en sortie
+Sorties : le début du champ, NULL s'il n'existe pas
+Le dernier champ s'arrête à la somme de contrôle.
+*/
+const char* nmeaField(const char* line, int length, int index, int* fieldLength){
+    const char* end = line+length;
+    const char* star = memchr(line,'*',length);
+    if(star != NULL){
+        end = star;
+    }
+    const char* field = line;
+    for(int i = 0; i < index; i++){
+        field = memchr(field,',',end-field);
+        if(field == NULL){
+            *fieldLength = 0;
+            return NULL;
+        }
+        field += 1;
+    }
+    const char* next = memchr(field,',',end-field);
+    *fieldLength = (int)((next == NULL ? end : next)-field);
+    return field;
+}
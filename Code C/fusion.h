@@ -0,0 +1,62 @@
+#ifndef HEADER_FUSION
+#define HEADER_FUSION
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUSION_MAX_SOURCES 32
+#define FUSION_BUCKETS 4
+#define FUSION_PROBES 16
+#define FUSION_LINE_SIZE 512
+#define FUSION_MESSAGE_SIZE 2048
+#define FUSION_MAX_FRAGMENTS 9
+#define FUSION_NAME_SIZE 64
+
+struct fusionEntry
+{
+    uint64_t hash;
+    uint32_t epoch;
+    uint32_t sources;
+};
+
+struct fusionSet
+{
+    double window;
+    int capacity;
+    int mask;
+    struct fusionEntry* entries;
+    long long nbOverflows;
+};
+
+struct fusionMessage
+{
+    char text[FUSION_MESSAGE_SIZE];
+    int length;
+    char payload[FUSION_MESSAGE_SIZE];
+    int payloadLength;
+    int fillBits;
+    int nbFragments, nextFragment;
+    double time;
+};
+
+struct fusionSource
+{
+    char name[FUSION_NAME_SIZE];
+    int fd;
+    char line[FUSION_LINE_SIZE];
+    int lineLength;
+    struct fusionMessage pending[2][10];
+    int needsTag;
+    long long nbMessages, nbFirst, nbDuplicates, nbErrors, nbUntagged;
+    double lastTime;
+};
+
+struct fusionSet* createFusionSet(int capacity, double window);
+void freeFusionSet(struct fusionSet* set);
+int checkFusionMessage(struct fusionSet* set, uint64_t hash, double time, int source);
+uint64_t hashPayload(const char* payload, int length, int fillBits);
+struct fusionMessage* addFusionLine(struct fusionSource* source, const char* line, int length, double now);
+
+#endif
@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include "fusion.h"
+#include "outputWriter.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define FUSION_READ_SIZE 65536
+
+struct fusionSet *seen;
+struct outputWriter *output;
+int tagBlocks;
+
+int openSource(const char* path);
+void readSource(struct fusionSource* source, int index);
+void emitMessage(struct fusionSource* source, struct fusionMessage* message);
+double realTime();
+
+/*
+Fusion des messages de plusieurs récepteurs : chaque source (fichier, tube nommé,
+socket Unix ou - pour l'entrée standard) fournit des phrases !AIVDM, et chaque
+message n'est écrit qu'une fois, par la première source qui l'a reçu. Les messages
+d'une source en direct sans bloc d'étiquettes sont datés à leur arrivée ; ceux d'un
+fichier doivent être datés par un bloc c:, comme dans la sortie -o nmea du récepteur.
+*/
+int main(int argc, char** argv)
+{
+   int option;
+   double window = 2.0;
+   int capacity = 65536;
+   tagBlocks = 0;
+   while((option = getopt(argc, argv, "n:tw:")) != -1){
+      switch(option){
+      case 'n':
+         capacity = atoi(optarg);
+         break;
+      case 't':
+         tagBlocks = 1;
+         break;
+      case 'w':
+         window = atof(optarg);
+         break;
+      default:
+         fprintf(stderr, "Usage : %s [-w window] [-n messages per window] [-t] source...\n", argv[0]);
+         return(1);
+      }
+   }
+   int nbSources = argc-optind;
+   if(nbSources < 1 || nbSources > FUSION_MAX_SOURCES){
+      fprintf(stderr, "Usage : %s [-w window] [-n messages per window] [-t] source... (at most %d sources)\n", argv[0], FUSION_MAX_SOURCES);
+      return(1);
+   }
+   seen = createFusionSet(capacity, window);
+   struct fusionSource *sources = (struct fusionSource*) calloc(nbSources, sizeof(struct fusionSource));
+   if(seen == NULL || sources == NULL){
+      return(1);
+   }
+   struct pollfd descriptors[FUSION_MAX_SOURCES];
+   int live = 0;
+   for(int i = 0; i < nbSources; i++){
+      const char* path = argv[optind+i];
+      const char* name = strrchr(path, '/') != NULL ? strrchr(path, '/')+1 : path;
+      snprintf(sources[i].name, FUSION_NAME_SIZE, "%s", strcmp(path, "-") == 0 ? "stdin" : name);
+      sources[i].fd = openSource(path);
+      if(sources[i].fd < 0){
+         fprintf(stderr, "Cannot open source %s\n", path);
+         return(1);
+      }
+      // Un fichier est lu bien plus vite qu'il n'a été reçu : seules ses phrases datées sont gardées
+      struct stat status;
+      if(fstat(sources[i].fd, &status) == 0 && !S_ISREG(status.st_mode)){
+         live = 1;
+      } else {
+         sources[i].needsTag = 1;
+      }
+      descriptors[i].fd = sources[i].fd;
+      descriptors[i].events = POLLIN;
+   }
+   // En direct, la sortie est vidée au plus tard toutes les 100 ms
+   output = createOutputWriter(STDOUT_FILENO, OUTPUT_NMEA, 0, live ? 0.1 : -1);
+   if(output == NULL){
+      return(1);
+   }
+
+   int nbOpen = nbSources;
+   while(nbOpen > 0){
+      int nbReady = poll(descriptors, nbSources, 100);
+      if(nbReady < 0 && errno != EINTR){
+         break;
+      }
+      if(nbReady <= 0){
+         if(output->size > 0){
+            flushOutputWriter(output);
+         }
+         continue;
+      }
+      for(int i = 0; i < nbSources; i++){
+         if(descriptors[i].fd >= 0 && (descriptors[i].revents & (POLLIN|POLLHUP|POLLERR))){
+            readSource(sources+i, i);
+            if(sources[i].fd < 0){
+               descriptors[i].fd = -1;
+               nbOpen -= 1;
+            }
+         }
+      }
+   }
+   closeOutputWriter(output);
+
+   long long nbUnique = 0;
+   for(int i = 0; i < nbSources; i++){
+      fprintf(stderr, "%s : %lld messages, %lld first, %lld duplicates, %lld errors\n",
+         sources[i].name, sources[i].nbMessages, sources[i].nbFirst, sources[i].nbDuplicates, sources[i].nbErrors);
+      nbUnique += sources[i].nbFirst;
+      if(sources[i].nbUntagged > 0){
+         fprintf(stderr, "%s : %lld sentences ignored without a c: tag block (a file is read at once, only live sources are dated on arrival)\n",
+            sources[i].name, sources[i].nbUntagged);
+      }
+   }
+   fprintf(stderr, "%lld unique messages, %lld not remembered (window full)\n", nbUnique, seen->nbOverflows);
+   freeFusionSet(seen);
+   free(sources);
+   return(0);
+}
+
+/*
+Fonction : openSource
+Entrées : chemin de la source
+Sorties : le descripteur ouvert en lecture, -1 en cas d'erreur
+Une socket Unix est une socket d'écoute à laquelle la fusion se connecte ; un tube
+nommé attend son écrivain.
+*/
+int openSource(const char* path)
+{
+   if(strcmp(path, "-") == 0){
+      return STDIN_FILENO;
+   }
+   struct stat status;
+   if(stat(path, &status) == 0 && S_ISSOCK(status.st_mode)){
+      struct sockaddr_un address;
+      if(strlen(path) >= sizeof(address.sun_path)){
+         return -1;
+      }
+      int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if(fd < 0){
+         return -1;
+      }
+      memset(&address, 0, sizeof(address));
+      address.sun_family = AF_UNIX;
+      strcpy(address.sun_path, path);
+      if(connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0){
+         close(fd);
+         return -1;
+      }
+      return fd;
+   }
+   return open(path, O_RDONLY);
+}
+
+/*
+Fonction : readSource
+Entrées : source prête, numéro de la source
+Sorties :
+Lit ce qui est disponible et traite chaque ligne complète. Une ligne trop longue est
+ignorée jusqu'à la fin de ligne suivante. La source est fermée en fin de flux.
+*/
+void readSource(struct fusionSource* source, int index)
+{
+   char data[FUSION_READ_SIZE];
+   ssize_t size = read(source->fd, data, sizeof(data));
+   if(size < 0 && (errno == EINTR || errno == EAGAIN)){
+      return;
+   }
+   if(size <= 0){
+      if(source->fd != STDIN_FILENO){
+         close(source->fd);
+      }
+      source->fd = -1;
+      return;
+   }
+   double now = realTime();
+   for(ssize_t i = 0; i < size; i++){
+      if(data[i] != '\n' && data[i] != '\r'){
+         if(source->lineLength < FUSION_LINE_SIZE){
+            source->line[source->lineLength] = data[i];
+         }
+         source->lineLength += 1;
+         continue;
+      }
+      if(source->lineLength > 0 && source->lineLength <= FUSION_LINE_SIZE){
+         struct fusionMessage *message = addFusionLine(source, source->line, source->lineLength, now);
+         if(message != NULL){
+            source->nbMessages += 1;
+            source->lastTime = message->time;
+            if(checkFusionMessage(seen, hashPayload(message->payload, message->payloadLength, message->fillBits), message->time, index)){
+               source->nbFirst += 1;
+               emitMessage(source, message);
+            } else {
+               source->nbDuplicates += 1;
+            }
+         }
+      }
+      source->lineLength = 0;
+   }
+}
+
+/*
+Fonction : emitMessage
+Entrées : source qui a reçu le message en premier, message complet
+Sorties :
+Écrit les phrases du message telles qu'elles ont été reçues, précédées si demandé
+d'un bloc d'étiquettes NMEA 4 avec le nom de la source et la date de réception.
+*/
+void emitMessage(struct fusionSource* source, struct fusionMessage* message)
+{
+   if(tagBlocks){
+      char tag[FUSION_NAME_SIZE+64];
+      int length = snprintf(tag, sizeof(tag), "s:%s,c:%lld", source->name, (long long)message->time);
+      int checksum = 0;
+      for(int i = 0; i < length; i++){
+         checksum ^= tag[i];
+      }
+      char end[8];
+      snprintf(end, sizeof(end), "*%02X\\", checksum);
+      writeString(output, "\\");
+      writeString(output, tag);
+      writeString(output, end);
+   }
+   message->text[message->length] = '\0';
+   writeString(output, message->text);
+   endOutputMessage(output);
+}
+
+double realTime()
+{
+   struct timespec now;
+   clock_gettime(CLOCK_REALTIME, &now);
+   return now.tv_sec+now.tv_nsec*1e-9;
+}
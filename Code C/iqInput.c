@@ -0,0 +1,377 @@
+#include "iqInput.h"
+#include "capture.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char* iqFormatNames[] = {"cu8", "cs8", "cs16", "cf32"};
+const int iqFormatSizes[] = {2, 2, 4, 8};
+
+int fillIqStream(struct iqInput* input);
+void deliverIqSamples(struct iqInput* input, const uint8_t* raw, struct complex* output, int nbSamples);
+
+/*
+Fonction : parseIqFormat
+Entrées : nom du format (cu8, cs8, cs16 ou cf32)
+Sorties : le format correspondant, -1 s'il est inconnu
+*/
+int parseIqFormat(const char* name){
+    for(int i=0; i<4; i++){
+        if(strcmp(name,iqFormatNames[i]) == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+Fonction : iqFormatFromPath
+Entrées : chemin d'un fichier IQ
+Sorties : le format donné par l'extension du fichier, IQ_CU8 par défaut (sortie de rtl_sdr)
+*/
+int iqFormatFromPath(const char* path){
+    const char* extension = strrchr(path,'.');
+    if(extension == NULL || parseIqFormat(extension+1) < 0){
+        return IQ_CU8;
+    }
+    return parseIqFormat(extension+1);
+}
+
+/*
+Fonction : openIqInput
+Entrées : chemin du fichier d'enregistrement, format des échantillons
+Sorties : l'entrée ouverte, NULL en cas d'erreur
+Le fichier est projeté en mémoire : seules les pages en cours de lecture sont
+chargées, quelle que soit la taille de l'enregistrement.
+*/
+struct iqInput* openIqInput(const char* path, int format){
+    return openIqInputRange(path,format,0,-1);
+}
+
+/*
+Fonction : openIqInputRange
+Entrées : chemin du fichier, format des échantillons, position des données dans le fichier (octets),
+taille des données (octets, -1 jusqu'à la fin du fichier)
+Sorties : l'entrée ouverte, NULL en cas d'erreur
+Pour les fichiers dont les échantillons suivent un en-tête (WAV par exemple). Un
+tube nommé ou un périphérique ne peut pas être projeté : il est lu comme un flux.
+*/
+struct iqInput* openIqInputRange(const char* path, int format, long long offset, long long length){
+    if(format < 0 || format > IQ_CF32){
+        return NULL;
+    }
+    int fd = open(path,O_RDONLY);
+    if(fd < 0){
+        return NULL;
+    }
+    struct stat status;
+    if(fstat(fd,&status) == 0 && !S_ISREG(status.st_mode) && offset == 0){
+        struct iqInput* stream = openIqStream(fd,format);
+        if(stream == NULL){
+            close(fd);
+        }
+        return stream;
+    }
+    if(fstat(fd,&status) < 0 || offset < 0 || offset >= status.st_size){
+        close(fd);
+        return NULL;
+    }
+    if(length < 0 || offset+length > status.st_size){
+        length = status.st_size-offset;
+    }
+    struct iqInput* input = (struct iqInput*) calloc(1,sizeof(struct iqInput));
+    if(input == NULL){
+        close(fd);
+        return NULL;
+    }
+    input->fd = -1;
+    input->format = format;
+    input->sampleSize = iqFormatSizes[format];
+    input->size = status.st_size;
+    input->nbSamples = length/input->sampleSize;
+    input->position = 0;
+    input->map = (uint8_t*) mmap(NULL,input->size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(input->map == MAP_FAILED){
+        free(input);
+        return NULL;
+    }
+    input->data = input->map+offset;
+    madvise(input->map,input->size,MADV_SEQUENTIAL);
+    return input;
+}
+
+/*
+Fonction : openIqInputAsync
+Entrées : chemin du fichier, format des échantillons, position des données dans le fichier (octets),
+taille des données (octets, -1 jusqu'à la fin du fichier)
+Sorties : l'entrée ouverte, NULL en cas d'erreur
+Lecture séquentielle par un fil de lecture en avance sur le traitement (voir
+asyncReader) : pour retraiter de gros enregistrements sans attendre le disque.
+L'entrée ne peut pas être repositionnée. Un tube est lu comme un flux.
+*/
+struct iqInput* openIqInputAsync(const char* path, int format, long long offset, long long length){
+    if(format < 0 || format > IQ_CF32){
+        return NULL;
+    }
+    int fd = open(path,O_RDONLY);
+    if(fd < 0){
+        return NULL;
+    }
+    struct stat status;
+    if(fstat(fd,&status) == 0 && !S_ISREG(status.st_mode) && offset == 0){
+        struct iqInput* stream = openIqStream(fd,format);
+        if(stream == NULL){
+            close(fd);
+        }
+        return stream;
+    }
+    if(fstat(fd,&status) < 0 || offset < 0 || offset >= status.st_size){
+        close(fd);
+        return NULL;
+    }
+    if(length < 0 || offset+length > status.st_size){
+        length = status.st_size-offset;
+    }
+    struct iqInput* input = (struct iqInput*) calloc(1,sizeof(struct iqInput));
+    if(input == NULL){
+        close(fd);
+        return NULL;
+    }
+    input->fd = -1;
+    input->format = format;
+    input->sampleSize = iqFormatSizes[format];
+    input->nbSamples = length/input->sampleSize;
+    input->async = createAsyncReader(fd,offset,length);
+    if(input->async == NULL){
+        close(fd);
+        free(input);
+        return NULL;
+    }
+    return input;
+}
+
+/*
+Fonction : openIqStream
+Entrées : descripteur de fichier ouvert en lecture (entrée standard, tube), format des échantillons
+Sorties : l'entrée ouverte, NULL en cas d'erreur
+Flux de longueur inconnue, par exemple la sortie de rtl_sdr. Les octets sont lus par
+grands appels à read() dans un tampon circulaire réutilisé : la mémoire utilisée est
+bornée quelle que soit la durée du flux. Le descripteur est fermé par closeIqInput.
+*/
+struct iqInput* openIqStream(int fd, int format){
+    if(format < 0 || format > IQ_CF32){
+        return NULL;
+    }
+    struct iqInput* input = (struct iqInput*) calloc(1,sizeof(struct iqInput));
+    if(input == NULL){
+        return NULL;
+    }
+    input->ring = (uint8_t*) malloc(IQ_STREAM_BUFFER);
+    if(input->ring == NULL){
+        free(input);
+        return NULL;
+    }
+    input->fd = fd;
+    input->format = format;
+    input->sampleSize = iqFormatSizes[format];
+    input->nbSamples = -1;
+    return input;
+}
+
+/*
+Fonction : fillIqStream
+Entrées : entrée en flux
+Sorties : le nombre d'octets lus, 0 en fin de flux
+Un seul appel à read() sur toute la place libre contiguë du tampon circulaire.
+*/
+int fillIqStream(struct iqInput* input){
+    size_t index = input->ringWrite % IQ_STREAM_BUFFER;
+    size_t space = IQ_STREAM_BUFFER-(input->ringWrite-input->ringRead);
+    if(space > IQ_STREAM_BUFFER-index){
+        space = IQ_STREAM_BUFFER-index;
+    }
+    ssize_t size;
+    do {
+        size = read(input->fd,input->ring+index,space);
+    } while(size < 0 && errno == EINTR);
+    if(size <= 0){
+        input->endOfStream = 1;
+        return 0;
+    }
+    input->ringWrite += size;
+    return size;
+}
+
+/*
+Fonction : readIqSamples
+Entrées : entrée, vecteur complexe pour recevoir les échantillons, nombre d'échantillons voulus
+Sorties : le nombre d'échantillons lus, 0 en fin de fichier
+Les échantillons sont convertis depuis la projection directement dans le vecteur de sortie.
+Pour un flux, la lecture ne bloque que si aucun échantillon complet n'est disponible
+et rend ce qui est arrivé sans attendre d'en avoir nbSamples : la latence reste faible
+même à bas débit. La taille du tampon étant un multiple de toutes les tailles
+d'échantillon, un échantillon n'est jamais coupé par le bord du tampon.
+*/
+int readIqSamples(struct iqInput* input, struct complex* output, int nbSamples){
+    if(input->capture != NULL){
+        while(input->chunkPosition >= input->chunkSize){
+            if(input->chunk+1 >= input->capture->nbChunks){
+                return 0;
+            }
+            input->chunk += 1;
+            input->chunkSize = decodeCaptureChunk(input->capture,input->chunk,input->chunkSamples,NULL);
+            input->chunkPosition = 0;
+            if(input->chunkSize < 0){
+                input->chunkSize = 0;
+                return 0;
+            }
+        }
+        if(nbSamples > input->chunkSize-input->chunkPosition){
+            nbSamples = input->chunkSize-input->chunkPosition;
+        }
+        deliverIqSamples(input,input->chunkSamples+2*input->chunkPosition,output,nbSamples);
+        input->chunkPosition += nbSamples;
+        input->position += nbSamples;
+        return nbSamples;
+    }
+    if(input->async != NULL){
+        // Un échantillon n'est jamais coupé entre deux tampons (taille multiple de 8)
+        while(input->current == NULL || input->currentPosition+input->sampleSize > input->current->size){
+            if(input->current != NULL){
+                if(input->current->size == 0){
+                    return 0;
+                }
+                releaseAsyncBuffer(input->async,input->current);
+            }
+            input->current = nextAsyncBuffer(input->async);
+            input->currentPosition = 0;
+        }
+        int available = (input->current->size-input->currentPosition)/input->sampleSize;
+        if(nbSamples > available){
+            nbSamples = available;
+        }
+        deliverIqSamples(input,input->current->data+input->currentPosition,output,nbSamples);
+        input->currentPosition += nbSamples*input->sampleSize;
+        input->position += nbSamples;
+        return nbSamples;
+    }
+    if(input->ring != NULL){
+        while(input->ringWrite-input->ringRead < (unsigned long long)input->sampleSize && !input->endOfStream){
+            fillIqStream(input);
+        }
+        size_t index = input->ringRead % IQ_STREAM_BUFFER;
+        size_t available = input->ringWrite-input->ringRead;
+        if(available > IQ_STREAM_BUFFER-index){
+            available = IQ_STREAM_BUFFER-index;
+        }
+        if(nbSamples > (int)(available/input->sampleSize)){
+            nbSamples = available/input->sampleSize;
+        }
+        deliverIqSamples(input,input->ring+index,output,nbSamples);
+        input->ringRead += nbSamples*input->sampleSize;
+        input->position += nbSamples;
+        return nbSamples;
+    }
+    if(nbSamples > input->nbSamples-input->position){
+        nbSamples = input->nbSamples-input->position;
+    }
+    deliverIqSamples(input,input->data+input->position*input->sampleSize,output,nbSamples);
+    input->position += nbSamples;
+    return nbSamples;
+}
+
+/*
+Fonction : deliverIqSamples
+Entrées : entrée, échantillons bruts, vecteur complexe pour recevoir les échantillons, nombre d'échantillons
+Sorties : 
+Convertit les échantillons lus et, si l'entrée est enregistrée, les ajoute tels
+quels à l'enregistrement compressé.
+*/
+void deliverIqSamples(struct iqInput* input, const uint8_t* raw, struct complex* output, int nbSamples){
+    convertIqSamples(raw,input->format,output,nbSamples);
+    if(input->record != NULL){
+        appendCaptureSamples(input->record,raw,nbSamples);
+    }
+}
+
+/*
+Fonction : convertIqSamples
+Entrées : échantillons bruts, format des échantillons, vecteur complexe pour recevoir la sortie, nombre d'échantillons
+Sorties : 
+Les formats entiers non signés sont recentrés autour de zéro ; aucune mise à
+l'échelle n'est faite, la démodulation ne dépendant que de la phase.
+*/
+void convertIqSamples(const uint8_t* input, int format, struct complex* output, int nbSamples){
+    switch(format){
+    case IQ_CU8:
+        for(int i=0; i<nbSamples; i++){
+            (output+i)->real = *(input+2*i)-127.5f;
+            (output+i)->imag = *(input+2*i+1)-127.5f;
+        }
+        break;
+    case IQ_CS8:
+        for(int i=0; i<nbSamples; i++){
+            (output+i)->real = (int8_t)*(input+2*i);
+            (output+i)->imag = (int8_t)*(input+2*i+1);
+        }
+        break;
+    case IQ_CS16:
+        for(int i=0; i<nbSamples; i++){
+            int16_t value[2];
+            memcpy(value,input+4*i,4);
+            (output+i)->real = value[0];
+            (output+i)->imag = value[1];
+        }
+        break;
+    case IQ_CF32:
+        memcpy(output,input,nbSamples*sizeof(struct complex));
+        break;
+    }
+}
+
+/*
+Fonction : seekIqInput
+Entrées : entrée, position en nombre d'échantillons
+Sorties : 0 en cas de succès, -1 si la position est hors du fichier ou si l'entrée est un flux
+*/
+int seekIqInput(struct iqInput* input, long long position){
+    if(input->ring != NULL || input->async != NULL || position < 0 || position > input->nbSamples){
+        return -1;
+    }
+    if(input->capture != NULL && input->capture->nbChunks > 0){
+        int chunk = findCaptureSample(input->capture,position);
+        if(chunk != input->chunk){
+            input->chunkSize = decodeCaptureChunk(input->capture,chunk,input->chunkSamples,NULL);
+            if(input->chunkSize < 0){
+                input->chunkSize = 0;
+                return -1;
+            }
+            input->chunk = chunk;
+        }
+        input->chunkPosition = position-(input->capture->index+chunk)->firstSample;
+    }
+    input->position = position;
+    return 0;
+}
+
+void closeIqInput(struct iqInput* input){
+    if(input == NULL){
+        return;
+    }
+    if(input->capture != NULL){
+        closeCaptureReader(input->capture);
+        free(input->chunkSamples);
+    } else if(input->async != NULL){
+        freeAsyncReader(input->async);
+    } else if(input->ring != NULL){
+        close(input->fd);
+        free(input->ring);
+    } else {
+        munmap(input->map,input->size);
+    }
+    free(input);
+}
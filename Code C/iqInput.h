@@ -0,0 +1,52 @@
+#ifndef HEADER_IQINPUT
+#define HEADER_IQINPUT
+
+#include "complexLib.h"
+#include "asyncReader.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define IQ_CU8 0
+#define IQ_CS8 1
+#define IQ_CS16 2
+#define IQ_CF32 3
+
+#define IQ_STREAM_BUFFER (4*1024*1024)
+
+struct captureReader;
+struct captureWriter;
+
+struct iqInput
+{
+    int format;
+    int sampleSize;
+    uint8_t* map;
+    size_t size;
+    uint8_t* data;
+    long long nbSamples;
+    long long position;
+    int fd;
+    uint8_t* ring;
+    unsigned long long ringRead, ringWrite;
+    int endOfStream;
+    struct asyncReader* async;
+    struct asyncBuffer* current;
+    size_t currentPosition;
+    struct captureReader* capture;
+    uint8_t* chunkSamples;
+    int chunk, chunkSize, chunkPosition;
+    struct captureWriter* record;
+};
+
+int parseIqFormat(const char* name);
+int iqFormatFromPath(const char* path);
+struct iqInput* openIqInput(const char* path, int format);
+struct iqInput* openIqInputRange(const char* path, int format, long long offset, long long length);
+struct iqInput* openIqInputAsync(const char* path, int format, long long offset, long long length);
+struct iqInput* openIqStream(int fd, int format);
+int readIqSamples(struct iqInput* input, struct complex* output, int nbSamples);
+void convertIqSamples(const uint8_t* input, int format, struct complex* output, int nbSamples);
+int seekIqInput(struct iqInput* input, long long position);
+void closeIqInput(struct iqInput* input);
+
+#endif
@@ -0,0 +1,195 @@
+#include "modulator.h"
+
+const int aisPreambleFlag[32] = {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 1, 1, 1, 1, 1, 0};
+
+int appendCrc(int* bits, int nbBits);
+
+/*
+Fonction : encodePositionReport
+Entrées : message (type, MMSI, position en degrés, cap), vecteur de POSITION_REPORT_BITS bits à compléter
+Sorties :
+Opération inverse de decodePositionReport : seuls les champs décodés sont écrits, les
+autres bits du vecteur (vitesse, cap vrai, horodatage, état radio...) sont laissés
+tels quels.
+*/
+void encodePositionReport(struct aisMessage* message, int* payload){
+    setMessageField(payload,0,6,message->messageType);
+    setMessageField(payload,8,38,message->mmsi);
+    setMessageField(payload,61,89,(long long)llround(message->longitude*600000.0));
+    setMessageField(payload,89,116,(long long)llround(message->latitude*600000.0));
+    setMessageField(payload,116,128,(long long)llround(message->course*10.0));
+}
+
+/*
+Fonction : setMessageField
+Entrées : vecteur de bits du message, position de départ, position de fin, valeur
+Sorties :
+Écrit la valeur en complément à deux, bit de poids fort en tête, comme la lit getFromMessage.
+*/
+void setMessageField(int* payload, int start, int end, long long value){
+    for(int i=end-1; i>=start; i--){
+        *(payload+i) = value & 1;
+        value >>= 1;
+    }
+}
+
+/*
+Fonction : buildAisPacket
+Entrées : bits du message (multiple de 8), nombre de bits, vecteur recevant le paquet (MAX_PACKET_BITS bits)
+Sorties : le nombre de bits du paquet
+Comme GenAIS.get_ais_packet en Python : les bits de chaque octet sont renversés, la
+somme de contrôle est ajoutée, un 0 est inséré après cinq 1 consécutifs, puis le
+paquet est entouré de la rampe, du préambule, des fanions et du tampon final, et
+passe par le codage NRZI (un 0 change le niveau, un 1 le garde).
+*/
+int buildAisPacket(int* payload, int nbBits, int* packet){
+    int data[MAX_PACKET_BITS];
+    flipBits(payload,data,nbBits);
+    int nbData = appendCrc(data,nbBits);
+
+    int length = 0;
+    for(int i=0; i<PACKET_RAMP_BITS; i++){
+        *(packet+length++) = 0;
+    }
+    for(int i=0; i<32; i++){
+        *(packet+length++) = aisPreambleFlag[i];
+    }
+    int nbOnes = 0;
+    for(int i=0; i<nbData; i++){
+        *(packet+length++) = data[i];
+        nbOnes = data[i] ? nbOnes+1 : 0;
+        if(nbOnes == 5){
+            *(packet+length++) = 0;
+            nbOnes = 0;
+        }
+    }
+    for(int i=0; i<8; i++){
+        *(packet+length++) = aisPreambleFlag[24+i];
+    }
+    for(int i=0; i<PACKET_BUFFER_BITS; i++){
+        *(packet+length++) = 0;
+    }
+
+    int level = 0;
+    for(int i=0; i<length; i++){
+        if(*(packet+i) == 0){
+            level = !level;
+        }
+        *(packet+i) = level;
+    }
+    return length;
+}
+
+/*
+Fonction : appendCrc
+Entrées : bits dans l'ordre d'émission, nombre de bits
+Sorties : le nombre de bits avec la somme de contrôle
+CRC-16 HDLC, le complément du registre est émis bit de poids faible en tête : checkCrc
+retrouve alors le reste constant 0xF0B8.
+*/
+int appendCrc(int* bits, int nbBits){
+    unsigned int crc = 0xFFFF;
+    for(int i=0; i<nbBits; i++){
+        if((crc ^ *(bits+i)) & 1){
+            crc = (crc >> 1) ^ 0x8408;
+        } else {
+            crc >>= 1;
+        }
+    }
+    crc = ~crc & 0xFFFF;
+    for(int i=0; i<sizeCheckSum; i++){
+        *(bits+nbBits+i) = (crc >> i) & 1;
+    }
+    return nbBits+sizeCheckSum;
+}
+
+/*
+Fonction : createGmskModulator
+Entrées : nombre d'échantillons par bit, produit bande-temps du filtre gaussien
+Sorties : le modulateur alloué, NULL en cas d'erreur
+Comme Modulator en Python : filtre gaussien sur GMSK_SPAN_BITS bits de part et
+d'autre, normalisé à une somme de 1, et indice de modulation 0,5.
+*/
+struct gmskModulator* createGmskModulator(int samplesPerBit, double bt){
+    struct gmskModulator* modulator = (struct gmskModulator*) calloc(1,sizeof(struct gmskModulator));
+    if(modulator == NULL || samplesPerBit < 1 || bt <= 0){
+        free(modulator);
+        return NULL;
+    }
+    modulator->samplesPerBit = samplesPerBit;
+    modulator->bt = bt;
+    modulator->nbTaps = 2*GMSK_SPAN_BITS*samplesPerBit+1;
+    modulator->pulseLength = modulator->nbTaps+samplesPerBit-1;
+    modulator->taps = (double*) malloc(modulator->nbTaps*sizeof(double));
+    modulator->pulse = (double*) calloc(modulator->pulseLength,sizeof(double));
+    if(modulator->taps == NULL || modulator->pulse == NULL){
+        freeGmskModulator(modulator);
+        return NULL;
+    }
+    // Variance en échantillons au carré : ln(2)/(2*pi*BT/T)^2 avec T = samplesPerBit
+    double variance = log(2.0)/pow(2*M_PI*bt/samplesPerBit,2);
+    double sum = 0;
+    for(int i=0; i<modulator->nbTaps; i++){
+        double t = i-GMSK_SPAN_BITS*samplesPerBit;
+        *(modulator->taps+i) = exp(-t*t/(2*variance));
+        sum += *(modulator->taps+i);
+    }
+    for(int i=0; i<modulator->nbTaps; i++){
+        *(modulator->taps+i) /= sum;
+    }
+    // Réponse du filtre à un seul bit : chaque échantillon du signal filtré ne dépend
+    // plus que des quelques bits dont l'impulsion le recouvre
+    for(int i=0; i<modulator->pulseLength; i++){
+        for(int j=0; j<samplesPerBit; j++){
+            if(i-j >= 0 && i-j < modulator->nbTaps){
+                *(modulator->pulse+i) += *(modulator->taps+i-j);
+            }
+        }
+    }
+    return modulator;
+}
+
+void freeGmskModulator(struct gmskModulator* modulator){
+    if(modulator == NULL){
+        return;
+    }
+    free(modulator->taps);
+    free(modulator->pulse);
+    free(modulator);
+}
+
+/*
+Fonction : gmskLength
+Entrées : modulateur, nombre de bits
+Sorties : le nombre d'échantillons produits par modulateGmsk
+*/
+int gmskLength(struct gmskModulator* modulator, int nbBits){
+    return nbBits*modulator->samplesPerBit+modulator->nbTaps-1;
+}
+
+/*
+Fonction : modulateGmsk
+Entrées : modulateur, bits à émettre, nombre de bits, vecteur recevant gmskLength échantillons
+Sorties : le nombre d'échantillons écrits
+Les bits en NRZ (+1/-1) sont filtrés par le filtre gaussien (convolution complète,
+calculée comme une somme d'impulsions décalées d'un bit), puis intégrés : chaque bit fait tourner la phase de pi/2. Le signal est cos - j sin
+de la phase, comme en Python, si bien que demodulate rend un 1 pour un bit à 1.
+*/
+int modulateGmsk(struct gmskModulator* modulator, int* bits, int nbBits, struct complex* output){
+    int spb = modulator->samplesPerBit;
+    int nbSamples = gmskLength(modulator,nbBits);
+    double phase = 0;
+    double step = M_PI*0.5/spb;
+    for(int i=0; i<nbSamples; i++){
+        double shaped = 0;
+        int first = i-modulator->pulseLength+1 > 0 ? (i-modulator->pulseLength+spb)/spb : 0;
+        int last = i/spb < nbBits-1 ? i/spb : nbBits-1;
+        for(int b=first; b<=last; b++){
+            shaped += *(modulator->pulse+i-b*spb)*(*(bits+b) ? 1.0 : -1.0);
+        }
+        phase += shaped*step;
+        (output+i)->real = cos(phase);
+        (output+i)->imag = -sin(phase);
+    }
+    return nbSamples;
+}
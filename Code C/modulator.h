@@ -0,0 +1,37 @@
+#ifndef HEADER_MODULATOR
+#define HEADER_MODULATOR
+
+#include "complexLib.h"
+#include "aisdecode.h"
+#include "bitTreatment.h"
+#include "signalCaracteristics.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define POSITION_REPORT_BITS 168
+#define PACKET_RAMP_BITS 8
+#define PACKET_BUFFER_BITS 24
+#define MAX_PACKET_BITS 1400
+#define GMSK_SPAN_BITS 1
+
+struct gmskModulator
+{
+    int samplesPerBit;
+    double bt;
+    int nbTaps;
+    double* taps;
+    int pulseLength;
+    double* pulse;
+};
+
+extern const int aisPreambleFlag[32];
+
+void setMessageField(int* payload, int start, int end, long long value);
+void encodePositionReport(struct aisMessage* message, int* payload);
+int buildAisPacket(int* payload, int nbBits, int* packet);
+struct gmskModulator* createGmskModulator(int samplesPerBit, double bt);
+void freeGmskModulator(struct gmskModulator* modulator);
+int gmskLength(struct gmskModulator* modulator, int nbBits);
+int modulateGmsk(struct gmskModulator* modulator, int* bits, int nbBits, struct complex* output);
+
+#endif
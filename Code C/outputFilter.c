@@ -0,0 +1,119 @@
+#include "outputFilter.h"
+
+double approximateDistance(double lat1, double lon1, double lat2, double lon2);
+
+/*
+Fonction : createOutputFilter
+Entrées : seuils de distance (m), de changement de cap (degrés) et d'intervalle maximal (s), nombre de navires suivis
+Sorties : le filtre alloué, NULL en cas d'erreur
+Chaque consommateur crée son propre filtre avec ses propres seuils. Un seuil nul ou
+négatif est désactivé ; sans aucun seuil actif, tous les rapports sont émis.
+*/
+struct outputFilter* createOutputFilter(struct throttleThresholds thresholds, int capacity){
+    struct outputFilter* filter = (struct outputFilter*) malloc(sizeof(struct outputFilter));
+    if(filter == NULL){
+        return NULL;
+    }
+    filter->capacity = FILTER_MAX_PROBE;
+    while(filter->capacity < capacity){
+        filter->capacity *= 2;
+    }
+    filter->entries = (struct throttleEntry*) calloc(filter->capacity,sizeof(struct throttleEntry));
+    if(filter->entries == NULL){
+        free(filter);
+        return NULL;
+    }
+    filter->thresholds = thresholds;
+    filter->nbEmitted = 0;
+    filter->nbDropped = 0;
+    return filter;
+}
+
+void freeOutputFilter(struct outputFilter* filter){
+    if(filter == NULL){
+        return;
+    }
+    free(filter->entries);
+    free(filter);
+}
+
+/*
+Fonction : shouldEmitMessage
+Entrées : filtre, rapport de position décodé
+Sorties : 1 si le rapport doit être émis, 0 s'il peut être omis
+Un rapport est émis si le navire s'est déplacé de plus de minDistance, a tourné de
+plus de minTurn, ou si son dernier rapport émis date de plus de maxInterval. L'état
+retenu est celui du dernier rapport émis. Un navire inconnu ou évincé de la table est
+toujours émis, de même qu'un rapport plus ancien que le dernier émis (dates d'un
+autre enregistrement).
+*/
+int shouldEmitMessage(struct outputFilter* filter, struct aisMessage* message){
+    struct throttleThresholds* thresholds = &filter->thresholds;
+    if(thresholds->minDistance <= 0 && thresholds->minTurn <= 0 && thresholds->maxInterval <= 0){
+        filter->nbEmitted += 1;
+        return 1;
+    }
+    unsigned int hash = message->mmsi*2654435761u;
+    int mask = filter->capacity-1;
+    struct throttleEntry* entry = NULL;
+    struct throttleEntry* oldest = NULL;
+
+    for(int p=0; p<FILTER_MAX_PROBE; p++){
+        struct throttleEntry* current = filter->entries+((hash+p) & mask);
+        if(current->mmsi == message->mmsi || current->mmsi == 0){
+            entry = current;
+            break;
+        }
+        if(oldest == NULL || current->timestamp < oldest->timestamp){
+            oldest = current;
+        }
+    }
+
+    int emit = 1;
+    if(entry == NULL){
+        entry = oldest;
+    } else if(entry->mmsi == message->mmsi && message->timestamp >= entry->timestamp){
+        emit = 0;
+        if(thresholds->maxInterval > 0 && message->timestamp-entry->timestamp >= thresholds->maxInterval){
+            emit = 1;
+        } else if(thresholds->minDistance > 0 && approximateDistance(entry->latitude,entry->longitude,message->latitude,message->longitude) >= thresholds->minDistance){
+            emit = 1;
+        } else if(thresholds->minTurn > 0 && message->course < 360.0 && entry->course < 360.0){
+            double turn = fabs(message->course-entry->course);
+            if(turn > 180.0){
+                turn = 360.0-turn;
+            }
+            emit = turn >= thresholds->minTurn;
+        }
+    }
+
+    if(!emit){
+        filter->nbDropped += 1;
+        return 0;
+    }
+    entry->mmsi = message->mmsi;
+    entry->timestamp = message->timestamp;
+    entry->latitude = message->latitude;
+    entry->longitude = message->longitude;
+    entry->course = message->course;
+    filter->nbEmitted += 1;
+    return 1;
+}
+
+/*
+Fonction : approximateDistance
+Entrées : deux positions en degrés
+Sorties : la distance en mètres
+Approximation équirectangulaire, suffisante pour les petits déplacements entre deux rapports.
+*/
+double approximateDistance(double lat1, double lon1, double lat2, double lon2){
+    double deltaLon = lon2-lon1;
+    if(deltaLon > 180.0){
+        deltaLon -= 360.0;
+    } else if(deltaLon < -180.0){
+        deltaLon += 360.0;
+    }
+    double x = deltaLon*cos((lat1+lat2)*M_PI/360.0);
+    double y = lat2-lat1;
+    return sqrt(x*x+y*y)*M_PI/180.0*6371000.0;
+}
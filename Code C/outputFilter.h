@@ -0,0 +1,37 @@
+#ifndef HEADER_OUTPUTFILTER
+#define HEADER_OUTPUTFILTER
+
+#include "aisdecode.h"
+#include <stdlib.h>
+
+#define FILTER_MAX_PROBE 16
+
+struct throttleThresholds
+{
+    double minDistance;
+    double minTurn;
+    double maxInterval;
+};
+
+struct throttleEntry
+{
+    unsigned int mmsi;
+    float course;
+    double timestamp;
+    double latitude, longitude;
+};
+
+struct outputFilter
+{
+    struct throttleThresholds thresholds;
+    struct throttleEntry* entries;
+    int capacity;
+    int nbEmitted;
+    int nbDropped;
+};
+
+struct outputFilter* createOutputFilter(struct throttleThresholds thresholds, int capacity);
+void freeOutputFilter(struct outputFilter* filter);
+int shouldEmitMessage(struct outputFilter* filter, struct aisMessage* message);
+
+#endif
@@ -0,0 +1,416 @@
+#include "outputWriter.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+const char* outputFormatNames[] = {"text", "nmea", "raw"};
+const unsigned long long decimalScales[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+void reserveOutput(struct outputWriter* writer, size_t size);
+int writeAll(int fd, const char* data, size_t size);
+int handOffOutput(struct outputWriter* writer);
+
+/*
+Fonction : parseOutputFormat
+Entrées : nom du format (text, nmea ou raw)
+Sorties : le format correspondant, -1 s'il est inconnu
+*/
+int parseOutputFormat(const char* name){
+    for(int i=0; i<3; i++){
+        if(strcmp(name,outputFormatNames[i]) == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+Fonction : createOutputWriter
+Entrées : descripteur de fichier de sortie, format, taille à partir de laquelle le tampon est vidé (octets),
+intervalle maximal entre deux vidages (s, 0 pour vider après chaque message, négatif pour désactiver)
+Sorties : l'écrivain alloué, NULL en cas d'erreur
+Les sorties sont formatées dans un grand tampon et écrites par un seul appel à write()
+à chaque vidage. Un écrivain n'est pas partagé : chaque fil d'exécution utilise le
+sien. Le descripteur reste à la charge de l'appelant.
+*/
+struct outputWriter* createOutputWriter(int fd, int format, size_t flushSize, double flushInterval){
+    struct outputWriter* writer = (struct outputWriter*) calloc(1,sizeof(struct outputWriter));
+    if(writer == NULL){
+        return NULL;
+    }
+    writer->buffer = (char*) malloc(OUTPUT_BUFFER_SIZE);
+    if(writer->buffer == NULL){
+        free(writer);
+        return NULL;
+    }
+    if(flushSize == 0 || flushSize > OUTPUT_BUFFER_SIZE-OUTPUT_MAX_ITEM){
+        flushSize = OUTPUT_BUFFER_SIZE-OUTPUT_MAX_ITEM;
+    }
+    writer->fd = fd;
+    writer->format = format;
+    writer->flushSize = flushSize;
+    writer->flushInterval = flushInterval;
+    writer->lastFlush = monotonicTime();
+    writer->channel = 'A';
+    return writer;
+}
+
+/*
+Fonction : closeOutputWriter
+Entrées : écrivain
+Sorties : 0 en cas de succès, -1 si l'écriture a échoué
+Fin de flux : le tampon est vidé avant d'être libéré.
+*/
+int closeOutputWriter(struct outputWriter* writer){
+    if(writer == NULL){
+        return 0;
+    }
+    int status = flushOutputWriter(writer);
+    free(writer->buffer);
+    free(writer);
+    return status;
+}
+
+/*
+Fonction : flushOutputWriter
+Entrées : écrivain
+Sorties : 0 en cas de succès, -1 si l'écriture a échoué
+*/
+int flushOutputWriter(struct outputWriter* writer){
+    if(writer->pending != NULL){
+        return handOffOutput(writer);
+    }
+    int written = writeAll(writer->fd,writer->buffer,writer->size);
+    writer->bytesWritten += written < 0 ? 0 : written;
+    writer->nbFlushes += 1;
+    writer->size = 0;
+    writer->lastFlush = monotonicTime();
+    return written < 0 ? -1 : 0;
+}
+
+/*
+Fonction : setOutputWriterQueue
+Entrées : écrivain, file des tampons à écrire, file des tampons libres (NULL pour revenir aux écritures directes)
+Sorties : 
+Les vidages ne font plus d'écriture : le tampon plein est échangé contre un tampon
+libre et confié à un autre fil, qui l'écrit avec writeOutputBlock puis le remet dans
+la file des tampons libres.
+*/
+void setOutputWriterQueue(struct outputWriter* writer, struct spscRing* pending, struct spscRing* spare){
+    writer->pending = pending;
+    writer->spare = spare;
+}
+
+/*
+Fonction : writeOutputBlock
+Entrées : descripteur de fichier, tampon confié par un écrivain
+Sorties : 0 en cas de succès, -1 si l'écriture a échoué
+*/
+int writeOutputBlock(int fd, struct outputBlock* block){
+    return writeAll(fd,block->buffer,block->size) < 0 ? -1 : 0;
+}
+
+/*
+Fonction : handOffOutput
+Entrées : écrivain
+Sorties : 0
+Ne bloque que si tous les tampons attendent déjà d'être écrits. Les tampons vides ne
+sont pas confiés.
+*/
+int handOffOutput(struct outputWriter* writer){
+    if(writer->size > 0){
+        struct outputBlock* block = (struct outputBlock*) spscPopWait(writer->spare,NULL);
+        char* buffer = block->buffer;
+        block->buffer = writer->buffer;
+        block->size = writer->size;
+        writer->buffer = buffer;
+        spscPushWait(writer->pending,block,NULL);
+        writer->bytesWritten += writer->size;
+    }
+    writer->nbFlushes += 1;
+    writer->size = 0;
+    writer->lastFlush = monotonicTime();
+    return 0;
+}
+
+/*
+Fonction : writeAll
+Entrées : descripteur de fichier, données, taille
+Sorties : le nombre d'octets écrits, -1 si l'écriture a échoué
+*/
+int writeAll(int fd, const char* data, size_t size){
+    size_t written = 0;
+    while(written < size){
+        ssize_t nbWritten = write(fd,data+written,size-written);
+        if(nbWritten < 0 && errno == EINTR){
+            continue;
+        }
+        if(nbWritten <= 0){
+            return -1;
+        }
+        written += nbWritten;
+    }
+    return (int)written;
+}
+
+/*
+Fonction : endOutputMessage
+Entrées : écrivain
+Sorties : 0 en cas de succès, -1 si l'écriture a échoué
+Marque la fin d'un message complet et applique la politique de vidage : le tampon
+est vidé s'il dépasse flushSize ou si le dernier vidage date de plus de flushInterval.
+Un message n'est donc jamais coupé entre deux écritures.
+*/
+int endOutputMessage(struct outputWriter* writer){
+    if(writer->size >= writer->flushSize || writer->flushInterval == 0){
+        return flushOutputWriter(writer);
+    }
+    if(writer->flushInterval > 0 && monotonicTime()-writer->lastFlush >= writer->flushInterval){
+        return flushOutputWriter(writer);
+    }
+    return 0;
+}
+
+void writeString(struct outputWriter* writer, const char* text){
+    size_t length = strlen(text);
+    while(length > 0){
+        reserveOutput(writer,1);
+        size_t size = OUTPUT_BUFFER_SIZE-writer->size;
+        if(size > length){
+            size = length;
+        }
+        memcpy(writer->buffer+writer->size,text,size);
+        writer->size += size;
+        text += size;
+        length -= size;
+    }
+}
+
+/*
+Fonction : writeUnsigned
+Entrées : écrivain, entier non signé
+Sorties : 
+Les chiffres sont produits à l'envers dans un petit tampon puis copiés.
+*/
+void writeUnsigned(struct outputWriter* writer, unsigned long long value){
+    char digits[20];
+    int nbDigits = 0;
+    do {
+        digits[nbDigits] = '0'+value%10;
+        nbDigits += 1;
+        value /= 10;
+    } while(value != 0);
+    reserveOutput(writer,nbDigits);
+    for(int i=nbDigits-1; i>=0; i--){
+        *(writer->buffer+writer->size) = digits[i];
+        writer->size += 1;
+    }
+}
+
+void writeInteger(struct outputWriter* writer, long long value){
+    if(value < 0){
+        reserveOutput(writer,1);
+        *(writer->buffer+writer->size) = '-';
+        writer->size += 1;
+        writeUnsigned(writer,-(unsigned long long)value);
+    } else {
+        writeUnsigned(writer,value);
+    }
+}
+
+/*
+Fonction : writeFixed
+Entrées : écrivain, valeur, nombre de décimales (9 au plus)
+Sorties : 
+Écriture en virgule fixe, arrondie au plus proche : writeFixed(w,x,6) donne la même
+chose que printf("%f",x), à une unité près sur le dernier chiffre quand x tombe au
+milieu de deux valeurs représentables.
+*/
+void writeFixed(struct outputWriter* writer, double value, int decimals){
+    if(decimals > 9){
+        decimals = 9;
+    }
+    unsigned long long scale = decimalScales[decimals];
+    unsigned long long scaled = llround(fabs(value)*scale);
+    if(value < 0){
+        reserveOutput(writer,1);
+        *(writer->buffer+writer->size) = '-';
+        writer->size += 1;
+    }
+    writeUnsigned(writer,scaled/scale);
+    if(decimals == 0){
+        return;
+    }
+    unsigned long long fraction = scaled%scale;
+    reserveOutput(writer,decimals+1);
+    *(writer->buffer+writer->size) = '.';
+    for(int i=decimals; i>0; i--){
+        *(writer->buffer+writer->size+i) = '0'+fraction%10;
+        fraction /= 10;
+    }
+    writer->size += decimals+1;
+}
+
+/*
+Fonction : writeBits
+Entrées : écrivain, bits démodulés, nombre de bits
+Sorties : 
+Un bit par ligne, au format historique du fichier outputResultDemod.txt. Le vidage
+est fait par blocs de bits complets.
+*/
+void writeBits(struct outputWriter* writer, int* bits, int nbBits){
+    for(int i=0; i<nbBits; i++){
+        if(*(bits+i) == 0 || *(bits+i) == 1){
+            reserveOutput(writer,3);
+            *(writer->buffer+writer->size) = '0'+*(bits+i);
+            *(writer->buffer+writer->size+1) = ' ';
+            *(writer->buffer+writer->size+2) = '\n';
+            writer->size += 3;
+        } else {
+            writeInteger(writer,*(bits+i));
+            writeString(writer," \n");
+        }
+    }
+    endOutputMessage(writer);
+}
+
+/*
+Fonction : writeNmeaFrame
+Entrées : écrivain, bits de la trame (sans fanions, bourrage ni somme de contrôle), nombre de bits,
+date de réception (s depuis 1970, négative pour ne pas l'écrire)
+Sorties : 
+Phrases !AIVDM de la trame, voir encodeNmeaSentence. Chaque phrase est précédée d'un
+bloc d'étiquettes NMEA 4 \c:date*hh\ : la fusion date alors les messages d'un
+enregistrement relu d'un coup à leur réception et non à leur lecture.
+*/
+void writeNmeaFrame(struct outputWriter* writer, int* bits, int nbBits, double timestamp){
+    int nbSentences = nmeaSentenceCount(nbBits);
+    if(nbSentences == 0){
+        return;
+    }
+    if(nbSentences > 1){
+        writer->sequence = (writer->sequence+1)%10;
+    }
+    for(int s=0; s<nbSentences; s++){
+        reserveOutput(writer,NMEA_MAX_TAG_BLOCK+NMEA_MAX_SENTENCE);
+        if(timestamp >= 0){
+            writer->size += encodeNmeaTagBlock(timestamp,writer->buffer+writer->size);
+        }
+        writer->size += encodeNmeaSentence(bits,nbBits,s,writer->sequence,writer->channel,writer->buffer+writer->size);
+    }
+    endOutputMessage(writer);
+}
+
+/*
+Fonction : nmeaSentenceCount
+Entrées : nombre de bits de la trame
+Sorties : nombre de phrases !AIVDM nécessaires, 0 si la trame est vide ou trop longue
+*/
+int nmeaSentenceCount(int nbBits){
+    int nbChars = (nbBits+5)/6;
+    int nbSentences = (nbChars+NMEA_MAX_PAYLOAD-1)/NMEA_MAX_PAYLOAD;
+    return nbSentences > 9 ? 0 : nbSentences;
+}
+
+/*
+Fonction : encodeNmeaSentence
+Entrées : bits de la trame, nombre de bits, numéro de la phrase (à partir de 0), identifiant de séquence, voie AIS,
+phrase à remplir (NMEA_MAX_SENTENCE octets)
+Sorties : longueur de la phrase, fin de ligne comprise
+La trame est codée par groupes de 6 bits (armure AIS), découpée en phrases de
+NMEA_MAX_PAYLOAD caractères au plus, et chaque phrase se termine par la somme de
+contrôle (ou exclusif des caractères entre '!' et '*'). L'identifiant de séquence
+n'est écrit que pour les trames de plusieurs phrases.
+*/
+int encodeNmeaSentence(int* bits, int nbBits, int index, int sequence, char channel, char* sentence){
+    int nbChars = (nbBits+5)/6;
+    int fillBits = nbChars*6-nbBits;
+    int nbSentences = (nbChars+NMEA_MAX_PAYLOAD-1)/NMEA_MAX_PAYLOAD;
+    int length = 0;
+    memcpy(sentence,"!AIVDM,",7);
+    length = 7;
+    sentence[length++] = '0'+nbSentences;
+    sentence[length++] = ',';
+    sentence[length++] = '1'+index;
+    sentence[length++] = ',';
+    if(nbSentences > 1){
+        sentence[length++] = '0'+sequence;
+    }
+    sentence[length++] = ',';
+    sentence[length++] = channel;
+    sentence[length++] = ',';
+    int last = (index+1)*NMEA_MAX_PAYLOAD < nbChars ? (index+1)*NMEA_MAX_PAYLOAD : nbChars;
+    for(int c=index*NMEA_MAX_PAYLOAD; c<last; c++){
+        int value = 0;
+        for(int b=6*c; b<6*c+6; b++){
+            value = (value << 1) | (b < nbBits ? *(bits+b) : 0);
+        }
+        sentence[length++] = value < 40 ? value+48 : value+56;
+    }
+    sentence[length++] = ',';
+    sentence[length++] = index == nbSentences-1 ? '0'+fillBits : '0';
+    int checksum = 0;
+    for(int i=1; i<length; i++){
+        checksum ^= sentence[i];
+    }
+    sentence[length++] = '*';
+    sentence[length++] = "0123456789ABCDEF"[checksum >> 4];
+    sentence[length++] = "0123456789ABCDEF"[checksum & 15];
+    sentence[length++] = '\r';
+    sentence[length++] = '\n';
+    return length;
+}
+
+/*
+Fonction : encodeNmeaTagBlock
+Entrées : date (s depuis 1970), bloc à remplir (NMEA_MAX_TAG_BLOCK octets)
+Sorties : longueur du bloc
+Bloc d'étiquettes \c:date*hh\ : date en secondes entières et somme de contrôle
+(ou exclusif des caractères entre les deux barres obliques inverses).
+*/
+int encodeNmeaTagBlock(double timestamp, char* tagBlock){
+    int length = snprintf(tagBlock,NMEA_MAX_TAG_BLOCK,"\\c:%lld",(long long)floor(timestamp));
+    int checksum = 0;
+    for(int i=1; i<length; i++){
+        checksum ^= *(tagBlock+i);
+    }
+    return length+snprintf(tagBlock+length,NMEA_MAX_TAG_BLOCK-length,"*%02X\\",checksum);
+}
+
+/*
+Fonction : writeRawFrame
+Entrées : écrivain, bits de la trame, nombre de bits, indice du bit de début de la trame
+Sorties : 
+Une ligne par trame : indice du bit de début puis les bits en caractères '0' et '1'.
+*/
+void writeRawFrame(struct outputWriter* writer, int* bits, int nbBits, long long bitIndex){
+    writeInteger(writer,bitIndex);
+    writeString(writer," ");
+    for(int i=0; i<nbBits; i++){
+        reserveOutput(writer,1);
+        *(writer->buffer+writer->size) = *(bits+i) ? '1' : '0';
+        writer->size += 1;
+    }
+    writeString(writer,"\n");
+    endOutputMessage(writer);
+}
+
+/*
+Fonction : reserveOutput
+Entrées : écrivain, nombre d'octets à écrire
+Sorties : 
+Vide le tampon s'il n'a plus la place demandée (OUTPUT_MAX_ITEM au plus).
+*/
+void reserveOutput(struct outputWriter* writer, size_t size){
+    if(writer->size+size > OUTPUT_BUFFER_SIZE){
+        flushOutputWriter(writer);
+    }
+}
+
+double monotonicTime(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec+now.tv_nsec*1e-9;
+}
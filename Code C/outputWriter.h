@@ -0,0 +1,60 @@
+#ifndef HEADER_OUTPUTWRITER
+#define HEADER_OUTPUTWRITER
+
+#include "spscRing.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define OUTPUT_TEXT 0
+#define OUTPUT_NMEA 1
+#define OUTPUT_RAW 2
+
+#define OUTPUT_BUFFER_SIZE (256*1024)
+#define OUTPUT_MAX_ITEM 256
+#define NMEA_MAX_PAYLOAD 60
+#define NMEA_MAX_SENTENCE 96
+#define NMEA_MAX_TAG_BLOCK 32
+
+struct outputBlock
+{
+    char* buffer;
+    size_t size;
+};
+
+struct outputWriter
+{
+    int fd;
+    int format;
+    char* buffer;
+    size_t size;
+    size_t flushSize;
+    double flushInterval;
+    double lastFlush;
+    int sequence;
+    char channel;
+    long long bytesWritten;
+    int nbFlushes;
+    struct spscRing* pending;
+    struct spscRing* spare;
+};
+
+int parseOutputFormat(const char* name);
+struct outputWriter* createOutputWriter(int fd, int format, size_t flushSize, double flushInterval);
+int closeOutputWriter(struct outputWriter* writer);
+int flushOutputWriter(struct outputWriter* writer);
+void setOutputWriterQueue(struct outputWriter* writer, struct spscRing* pending, struct spscRing* spare);
+int writeOutputBlock(int fd, struct outputBlock* block);
+int endOutputMessage(struct outputWriter* writer);
+void writeString(struct outputWriter* writer, const char* text);
+void writeUnsigned(struct outputWriter* writer, unsigned long long value);
+void writeInteger(struct outputWriter* writer, long long value);
+void writeFixed(struct outputWriter* writer, double value, int decimals);
+void writeBits(struct outputWriter* writer, int* bits, int nbBits);
+void writeNmeaFrame(struct outputWriter* writer, int* bits, int nbBits, double timestamp);
+int nmeaSentenceCount(int nbBits);
+int encodeNmeaSentence(int* bits, int nbBits, int index, int sequence, char channel, char* sentence);
+int encodeNmeaTagBlock(double timestamp, char* tagBlock);
+void writeRawFrame(struct outputWriter* writer, int* bits, int nbBits, long long bitIndex);
+double monotonicTime();
+
+#endif
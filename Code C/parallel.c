@@ -0,0 +1,176 @@
+#include "parallel.h"
+
+void* chunkWorker(void* argument);
+
+/*
+Fonction : processRecordingParallel
+Entrées : métadonnées de l'enregistrement, récepteur modèle (taille de bloc, échantillons par bit, filtre de
+canal, fonction des trames), nombre de fils
+Sorties : le nombre de trames trouvées, -1 en cas d'erreur
+L'enregistrement est découpé en morceaux de bits consécutifs, traités par plusieurs
+fils qui ont chacun leur entrée, leur filtre de canal et leur récepteur. Chaque
+morceau est lu avec overlapBits bits de plus de chaque côté (une fenêtre de trame
+complète plus l'historique du filtre) et ne garde que les trames qui commencent
+dans sa partie propre : une trame vue dans deux recouvrements n'est gardée qu'une
+fois. Les bits tombant aux mêmes instants que lors d'un traitement d'un seul
+tenant, les trames sont les mêmes. La fonction des trames du modèle est ensuite
+appelée dans l'ordre, dans le fil appelant, car le décodage met à jour un état
+partagé (réassemblage, navires, sorties).
+*/
+int processRecordingParallel(struct recordingInfo* info, struct receiver* rx, int nbWorkers){
+    if(nbWorkers < 1 || nbWorkers > PARALLEL_MAX_WORKERS){
+        return -1;
+    }
+    struct iqInput* input = openRecording(info);
+    if(input == NULL || input->nbSamples < 0){
+        closeIqInput(input);
+        return -1;
+    }
+    struct parallelRun run;
+    run.info = info;
+    run.model = rx;
+    double step = rx->channelizer != NULL ? rx->channelizer->step : 1.0;
+    run.nbBits = (long long)(input->nbSamples/step)/rx->timeDelay;
+    closeIqInput(input);
+    run.overlapBits = chunkOverlapBits(rx);
+    run.nbChunks = nbWorkers*PARALLEL_CHUNKS_PER_WORKER;
+    run.chunkBits = (run.nbBits+run.nbChunks-1)/run.nbChunks;
+    if(run.chunkBits < PARALLEL_MIN_CHUNK_BITS){
+        run.chunkBits = PARALLEL_MIN_CHUNK_BITS;
+    }
+    run.nbChunks = (int)((run.nbBits+run.chunkBits-1)/run.chunkBits);
+    if(run.nbChunks < 1){
+        run.nbChunks = 1;
+    }
+    run.chunks = (struct chunkResult*) calloc(run.nbChunks,sizeof(struct chunkResult));
+    if(run.chunks == NULL){
+        return -1;
+    }
+    for(int i = 0; i < run.nbChunks; i++){
+        (run.chunks+i)->firstBit = i*run.chunkBits;
+        // Le dernier morceau va jusqu'à la fin de l'entrée
+        (run.chunks+i)->lastBit = i == run.nbChunks-1 ? -1 : (i+1)*run.chunkBits;
+    }
+    atomic_init(&run.nextChunk,0);
+    if(nbWorkers > run.nbChunks){
+        nbWorkers = run.nbChunks;
+    }
+
+    pthread_t threads[PARALLEL_MAX_WORKERS];
+    int nbStarted = 0;
+    for(int i = 0; i < nbWorkers; i++){
+        if(pthread_create(threads+nbStarted,NULL,chunkWorker,&run) == 0){
+            nbStarted += 1;
+        }
+    }
+    for(int i = 0; i < nbStarted; i++){
+        pthread_join(*(threads+i),NULL);
+    }
+
+    // Fusion dans l'ordre des morceaux, chacun étant déjà dans l'ordre
+    int nbFrames = 0;
+    for(int i = 0; i < run.nbChunks; i++){
+        struct chunkResult* result = run.chunks+i;
+        if(!result->done){
+            nbFrames = -1;
+        }
+        for(int j = 0; j < result->nbFrames && nbFrames >= 0; j++){
+            struct pipelineFrame* frame = result->frames+j;
+            rx->callback(frame->bits,frame->size,frame->bitIndex,rx->context);
+            nbFrames += 1;
+        }
+        free(result->frames);
+    }
+    free(run.chunks);
+    return nbFrames;
+}
+
+/*
+Fonction : chunkWorker
+Entrées : traitement en cours
+Sorties : 
+Prend des morceaux jusqu'à ce qu'il n'en reste plus. Un fil qui ne peut pas créer son
+récepteur s'arrête ; ses morceaux sont pris par les autres.
+*/
+void* chunkWorker(void* argument){
+    struct parallelRun* run = (struct parallelRun*) argument;
+    struct receiver* model = run->model;
+    struct iqInput* input = openRecording(run->info);
+    struct receiver* rx;
+    if(model->channelizer != NULL){
+        rx = createChannelReceiver(model->channelizer->inputRate,model->channelizer->offset,collectChunkFrame,NULL);
+    } else {
+        rx = createReceiver(model->blockSize,model->timeDelay,collectChunkFrame,NULL);
+    }
+    int chunk;
+    while(input != NULL && rx != NULL && (chunk = atomic_fetch_add(&run->nextChunk,1)) < run->nbChunks){
+        processChunk(run->chunks+chunk,rx,input,run->overlapBits);
+    }
+    if(rx != NULL){
+        freeChannelizer(rx->channelizer);
+    }
+    freeReceiver(rx);
+    closeIqInput(input);
+    return NULL;
+}
+
+/*
+Fonction : chunkOverlapBits
+Entrées : récepteur
+Sorties : le nombre de bits à lire de chaque côté d'un morceau
+Une fenêtre de trame complète plus l'historique du filtre de canal.
+*/
+long long chunkOverlapBits(struct receiver* rx){
+    long long overlapBits = MAX_FRAME_WINDOW+8;
+    if(rx->channelizer != NULL){
+        overlapBits += (long long)ceil(rx->channelizer->nbTaps/rx->channelizer->step/rx->timeDelay);
+    }
+    return overlapBits;
+}
+
+/*
+Fonction : processChunk
+Entrées : morceau (bits propres, trames trouvées), récepteur, entrée repositionnable, bits lus de chaque côté
+Sorties : 0 en cas de succès, -1 si le morceau est hors de l'entrée
+Le contexte du récepteur est remplacé par le morceau ; sa fonction des trames doit
+être collectChunkFrame.
+*/
+int processChunk(struct chunkResult* result, struct receiver* rx, struct iqInput* input, long long overlapBits){
+    double step = rx->channelizer != NULL ? rx->channelizer->step : 1.0;
+    long long startBit = result->firstBit > overlapBits ? result->firstBit-overlapBits : 0;
+    long long start = (long long)(startBit*rx->timeDelay*step);
+    long long nbSamples = input->nbSamples-start;
+    if(result->lastBit >= 0){
+        long long end = (long long)ceil((result->lastBit+overlapBits)*rx->timeDelay*step)+2;
+        if(end-start < nbSamples){
+            nbSamples = end-start;
+        }
+    }
+    rx->context = result;
+    if(processIqRange(rx,input,start,nbSamples) < 0){
+        return -1;
+    }
+    result->done = 1;
+    return 0;
+}
+
+void collectChunkFrame(int* frame, int size, long long bitIndex, void* context){
+    struct chunkResult* result = (struct chunkResult*) context;
+    if(bitIndex < result->firstBit || (result->lastBit >= 0 && bitIndex >= result->lastBit)){
+        return;
+    }
+    if(result->nbFrames == result->maxFrames){
+        int maxFrames = result->maxFrames > 0 ? 2*result->maxFrames : 16;
+        struct pipelineFrame* frames = (struct pipelineFrame*) realloc(result->frames,maxFrames*sizeof(struct pipelineFrame));
+        if(frames == NULL){
+            return;
+        }
+        result->frames = frames;
+        result->maxFrames = maxFrames;
+    }
+    struct pipelineFrame* output = result->frames+result->nbFrames;
+    memcpy(output->bits,frame,size*sizeof(int));
+    output->size = size;
+    output->bitIndex = bitIndex;
+    result->nbFrames += 1;
+}
@@ -0,0 +1,42 @@
+#ifndef HEADER_PARALLEL
+#define HEADER_PARALLEL
+
+#include "receiver.h"
+#include "recording.h"
+#include "pipeline.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define PARALLEL_CHUNKS_PER_WORKER 4
+#ifndef PARALLEL_MIN_CHUNK_BITS
+#define PARALLEL_MIN_CHUNK_BITS 8192
+#endif
+#define PARALLEL_MAX_WORKERS 256
+
+struct chunkResult
+{
+    long long firstBit, lastBit;
+    struct pipelineFrame* frames;
+    int nbFrames, maxFrames;
+    int done;
+};
+
+struct parallelRun
+{
+    struct recordingInfo* info;
+    struct receiver* model;
+    long long nbBits;
+    long long chunkBits;
+    long long overlapBits;
+    int nbChunks;
+    struct chunkResult* chunks;
+    atomic_int nextChunk;
+};
+
+int processRecordingParallel(struct recordingInfo* info, struct receiver* rx, int nbWorkers);
+long long chunkOverlapBits(struct receiver* rx);
+int processChunk(struct chunkResult* result, struct receiver* rx, struct iqInput* input, long long overlapBits);
+void collectChunkFrame(int* frame, int size, long long bitIndex, void* context);
+
+#endif
@@ -0,0 +1,399 @@
+#define _GNU_SOURCE
+#include "pipeline.h"
+#include <sched.h>
+#include <unistd.h>
+
+void* readerStage(void* argument);
+void* channelizerStage(void* argument);
+void* demodStage(void* argument);
+void* deframerStage(void* argument);
+void* decoderStage(void* argument);
+void* writerStage(void* argument);
+void collectFrame(int* frame, int size, long long bitIndex, void* context);
+int createLink(struct pipelineLink* link, size_t itemSize, int nbItems);
+void freeLink(struct pipelineLink* link);
+struct pipelineBatch* takeBatch(struct pipelineLink* link);
+void handOffBatch(struct pipelineLink* link, struct pipelineBatch* batch, struct pipelineStage* stage);
+struct pipelineBatch* nextBatch(struct pipelineLink* link);
+void endStage(struct pipeline* pipeline, int stage);
+void endOutput(struct pipeline* pipeline);
+void releaseBatch(struct pipelineLink* link, struct pipelineBatch* batch);
+
+/*
+Fonction : createPipeline
+Entrées : récepteur (son filtre de canal éventuel est utilisé), entrée IQ, écrivain de sortie (peut être NULL),
+premier processeur pour épingler les fils (négatif pour ne pas les épingler)
+Sorties : la chaîne allouée, NULL en cas d'erreur
+Chaque étage (lecture, filtre de canal, démodulation, recherche des trames, décodage,
+écriture) tourne dans son propre fil. Deux étages voisins échangent des lots par une
+file sans verrou et se renvoient les lots vides par une seconde file : aucune
+allocation pendant le traitement, et un étage lent ne bloque l'amont qu'une fois
+tous ses lots en attente. Le récepteur ne doit pas enregistrer de salves, ses deux
+moitiés tournant dans deux fils différents.
+*/
+struct pipeline* createPipeline(struct receiver* rx, struct iqInput* input, struct outputWriter* output, int firstCpu){
+    if(rx->bursts != NULL){
+        return NULL;
+    }
+    struct pipeline* pipeline = (struct pipeline*) calloc(1,sizeof(struct pipeline));
+    if(pipeline == NULL){
+        return NULL;
+    }
+    pipeline->rx = rx;
+    pipeline->input = input;
+    pipeline->output = output;
+    pipeline->firstCpu = firstCpu;
+    int nbChannelSamples = PIPELINE_BATCH;
+    if(rx->channelizer != NULL && channelizerMaxOutput(rx->channelizer,PIPELINE_BATCH) > nbChannelSamples){
+        nbChannelSamples = channelizerMaxOutput(rx->channelizer,PIPELINE_BATCH);
+    }
+    int nbBits = (nbChannelSamples/rx->stride+2)*rx->nbBits;
+    int status = createLink(pipeline->links+STAGE_READER,PIPELINE_BATCH*sizeof(struct complex),PIPELINE_DEPTH);
+    status |= createLink(pipeline->links+STAGE_CHANNELIZER,nbChannelSamples*sizeof(struct complex),PIPELINE_DEPTH);
+    status |= createLink(pipeline->links+STAGE_DEMOD,nbBits*sizeof(int),PIPELINE_DEPTH);
+    status |= createLink(pipeline->links+STAGE_DEFRAMER,PIPELINE_FRAMES*sizeof(struct pipelineFrame),PIPELINE_DEPTH);
+    pipeline->pendingBlocks = createSpscRing(PIPELINE_OUTPUT_BLOCKS);
+    pipeline->spareBlocks = createSpscRing(PIPELINE_OUTPUT_BLOCKS);
+    if(status < 0 || pipeline->pendingBlocks == NULL || pipeline->spareBlocks == NULL){
+        freePipeline(pipeline);
+        return NULL;
+    }
+    for(int i = 0; i < PIPELINE_OUTPUT_BLOCKS; i++){
+        (pipeline->blocks+i)->buffer = (char*) malloc(OUTPUT_BUFFER_SIZE);
+        if((pipeline->blocks+i)->buffer == NULL){
+            freePipeline(pipeline);
+            return NULL;
+        }
+        spscPush(pipeline->spareBlocks,pipeline->blocks+i);
+    }
+    (pipeline->stages+STAGE_READER)->run = readerStage;
+    (pipeline->stages+STAGE_CHANNELIZER)->run = rx->channelizer != NULL ? channelizerStage : NULL;
+    (pipeline->stages+STAGE_DEMOD)->run = demodStage;
+    (pipeline->stages+STAGE_DEFRAMER)->run = deframerStage;
+    (pipeline->stages+STAGE_DECODER)->run = decoderStage;
+    (pipeline->stages+STAGE_WRITER)->run = output != NULL ? writerStage : NULL;
+    for(int i = 0; i < PIPELINE_STAGES; i++){
+        (pipeline->stages+i)->pipeline = pipeline;
+    }
+    return pipeline;
+}
+
+void freePipeline(struct pipeline* pipeline){
+    if(pipeline == NULL){
+        return;
+    }
+    for(int i = 0; i < PIPELINE_STAGES-2; i++){
+        freeLink(pipeline->links+i);
+    }
+    for(int i = 0; i < PIPELINE_OUTPUT_BLOCKS; i++){
+        free((pipeline->blocks+i)->buffer);
+    }
+    freeSpscRing(pipeline->pendingBlocks);
+    freeSpscRing(pipeline->spareBlocks);
+    free(pipeline);
+}
+
+/*
+Fonction : runPipeline
+Entrées : chaîne
+Sorties : 0 en cas de succès, -1 si un fil n'a pas pu être lancé ou si l'écriture a échoué
+Traite toute l'entrée puis attend la fin de tous les étages. La fin du flux est
+transmise d'étage en étage par un lot marqué comme dernier ; chaque étage vide alors
+ses états (dernier bloc, dernières fenêtres, tampon de sortie) avant de le
+transmettre.
+*/
+int runPipeline(struct pipeline* pipeline){
+    struct receiver* rx = pipeline->rx;
+    pipeline->callback = rx->callback;
+    pipeline->context = rx->context;
+    rx->callback = collectFrame;
+    rx->context = pipeline;
+    if(pipeline->output != NULL){
+        setOutputWriterQueue(pipeline->output,pipeline->pendingBlocks,pipeline->spareBlocks);
+    }
+    // Les étages sont lancés de l'aval vers l'amont : si un fil ne peut pas être
+    // lancé, la fin du flux est envoyée à sa place et les étages en aval se terminent
+    long nbCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int status = 0;
+    for(int i = PIPELINE_STAGES-1; i >= 0; i--){
+        struct pipelineStage* stage = pipeline->stages+i;
+        if(stage->run == NULL){
+            continue;
+        }
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        if(pipeline->firstCpu >= 0 && nbCpus > 0){
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET((pipeline->firstCpu+i)%nbCpus,&cpus);
+            pthread_attr_setaffinity_np(&attributes,sizeof(cpu_set_t),&cpus);
+        }
+        if(pthread_create(&stage->thread,&attributes,stage->run,stage) != 0){
+            status = -1;
+        } else {
+            stage->started = 1;
+        }
+        pthread_attr_destroy(&attributes);
+        if(status < 0){
+            endStage(pipeline,i);
+            break;
+        }
+    }
+    for(int i = 0; i < PIPELINE_STAGES; i++){
+        if((pipeline->stages+i)->started){
+            pthread_join((pipeline->stages+i)->thread,NULL);
+        }
+    }
+    if(pipeline->output != NULL){
+        setOutputWriterQueue(pipeline->output,NULL,NULL);
+    }
+    rx->callback = pipeline->callback;
+    rx->context = pipeline->context;
+    return status < 0 ? -1 : pipeline->writeStatus;
+}
+
+/*
+Fonction : readerStage
+Entrées : étage
+Sorties : 
+Lit l'entrée par lots de PIPELINE_BATCH échantillons. Sans filtre de canal, les
+lots vont directement à la démodulation.
+*/
+void* readerStage(void* argument){
+    struct pipelineStage* stage = (struct pipelineStage*) argument;
+    struct pipeline* pipeline = stage->pipeline;
+    struct pipelineLink* link = pipeline->links+(pipeline->rx->channelizer != NULL ? STAGE_READER : STAGE_CHANNELIZER);
+    int end = 0;
+    while(!end){
+        struct pipelineBatch* batch = takeBatch(link);
+        batch->size = readIqSamples(pipeline->input,(struct complex*)batch->data,PIPELINE_BATCH);
+        batch->end = end = batch->size == 0;
+        handOffBatch(link,batch,stage);
+    }
+    return NULL;
+}
+
+void* channelizerStage(void* argument){
+    struct pipelineStage* stage = (struct pipelineStage*) argument;
+    struct pipeline* pipeline = stage->pipeline;
+    struct channelizer* ch = pipeline->rx->channelizer;
+    int maxOutput = channelizerMaxOutput(ch,PIPELINE_BATCH);
+    int end = 0;
+    while(!end){
+        struct pipelineBatch* input = nextBatch(pipeline->links+STAGE_READER);
+        struct pipelineBatch* output = takeBatch(pipeline->links+STAGE_CHANNELIZER);
+        output->size = channelize(ch,(struct complex*)input->data,input->size,(struct complex*)output->data,maxOutput);
+        output->end = end = input->end;
+        releaseBatch(pipeline->links+STAGE_READER,input);
+        handOffBatch(pipeline->links+STAGE_CHANNELIZER,output,stage);
+    }
+    return NULL;
+}
+
+void* demodStage(void* argument){
+    struct pipelineStage* stage = (struct pipelineStage*) argument;
+    struct pipeline* pipeline = stage->pipeline;
+    int end = 0;
+    while(!end){
+        struct pipelineBatch* input = nextBatch(pipeline->links+STAGE_CHANNELIZER);
+        struct pipelineBatch* output = takeBatch(pipeline->links+STAGE_DEMOD);
+        output->size = demodulateSamples(pipeline->rx,(struct complex*)input->data,input->size,(int*)output->data);
+        if(input->end){
+            output->size += flushSamples(pipeline->rx,(int*)output->data+output->size);
+        }
+        output->end = end = input->end;
+        releaseBatch(pipeline->links+STAGE_CHANNELIZER,input);
+        handOffBatch(pipeline->links+STAGE_DEMOD,output,stage);
+    }
+    return NULL;
+}
+
+/*
+Fonction : deframerStage
+Entrées : étage
+Sorties : 
+Les trames trouvées dans un lot de bits sont regroupées par collectFrame ; le lot de
+trames part dès qu'il est plein et à la fin de chaque lot de bits.
+*/
+void* deframerStage(void* argument){
+    struct pipelineStage* stage = (struct pipelineStage*) argument;
+    struct pipeline* pipeline = stage->pipeline;
+    struct pipelineLink* link = pipeline->links+STAGE_DEFRAMER;
+    int end = 0;
+    while(!end){
+        struct pipelineBatch* input = nextBatch(pipeline->links+STAGE_DEMOD);
+        pipeline->frames = takeBatch(link);
+        pipeline->frames->size = 0;
+        processBits(pipeline->rx,(int*)input->data,input->size);
+        if(input->end){
+            flushBits(pipeline->rx);
+        }
+        end = input->end;
+        releaseBatch(pipeline->links+STAGE_DEMOD,input);
+        pipeline->frames->end = end;
+        if(pipeline->frames->size > 0 || end){
+            handOffBatch(link,pipeline->frames,stage);
+        } else {
+            releaseBatch(link,pipeline->frames);
+        }
+    }
+    return NULL;
+}
+
+void collectFrame(int* frame, int size, long long bitIndex, void* context){
+    struct pipeline* pipeline = (struct pipeline*) context;
+    struct pipelineLink* link = pipeline->links+STAGE_DEFRAMER;
+    if(pipeline->frames->size == PIPELINE_FRAMES){
+        pipeline->frames->end = 0;
+        handOffBatch(link,pipeline->frames,pipeline->stages+STAGE_DEFRAMER);
+        pipeline->frames = takeBatch(link);
+        pipeline->frames->size = 0;
+    }
+    struct pipelineFrame* output = (struct pipelineFrame*)pipeline->frames->data+pipeline->frames->size;
+    memcpy(output->bits,frame,size*sizeof(int));
+    output->size = size;
+    output->bitIndex = bitIndex;
+    pipeline->frames->size += 1;
+}
+
+/*
+Fonction : decoderStage
+Entrées : étage
+Sorties : 
+Appelle la fonction des trames du récepteur ; ses sorties vont dans le tampon de
+l'écrivain, dont les vidages sont confiés à l'étage d'écriture.
+*/
+void* decoderStage(void* argument){
+    struct pipelineStage* stage = (struct pipelineStage*) argument;
+    struct pipeline* pipeline = stage->pipeline;
+    int end = 0;
+    while(!end){
+        struct pipelineBatch* input = nextBatch(pipeline->links+STAGE_DEFRAMER);
+        for(int i = 0; i < input->size; i++){
+            struct pipelineFrame* frame = (struct pipelineFrame*)input->data+i;
+            pipeline->callback(frame->bits,frame->size,frame->bitIndex,pipeline->context);
+        }
+        end = input->end;
+        releaseBatch(pipeline->links+STAGE_DEFRAMER,input);
+        stage->nbBatches += 1;
+    }
+    if(pipeline->output != NULL){
+        flushOutputWriter(pipeline->output);
+        endOutput(pipeline);
+    }
+    return NULL;
+}
+
+void* writerStage(void* argument){
+    struct pipelineStage* stage = (struct pipelineStage*) argument;
+    struct pipeline* pipeline = stage->pipeline;
+    while(1){
+        struct outputBlock* block = (struct outputBlock*) spscPopWait(pipeline->pendingBlocks,NULL);
+        if(block->size == 0){
+            spscPushWait(pipeline->spareBlocks,block,NULL);
+            break;
+        }
+        if(writeOutputBlock(pipeline->output->fd,block) < 0){
+            pipeline->writeStatus = -1;
+        }
+        stage->nbBatches += 1;
+        spscPushWait(pipeline->spareBlocks,block,NULL);
+    }
+    return NULL;
+}
+
+/*
+Fonction : createLink
+Entrées : lien entre deux étages, taille des données d'un lot (octets), nombre de lots
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+Tous les lots sont alloués ici et commencent dans la file des lots vides.
+*/
+int createLink(struct pipelineLink* link, size_t itemSize, int nbItems){
+    link->full = createSpscRing(nbItems);
+    link->spare = createSpscRing(nbItems);
+    link->batches = (struct pipelineBatch*) calloc(nbItems,sizeof(struct pipelineBatch));
+    if(link->full == NULL || link->spare == NULL || link->batches == NULL){
+        return -1;
+    }
+    link->nbBatches = nbItems;
+    for(int i = 0; i < nbItems; i++){
+        (link->batches+i)->data = aligned_alloc(CACHE_LINE_SIZE,(itemSize+CACHE_LINE_SIZE-1)/CACHE_LINE_SIZE*CACHE_LINE_SIZE);
+        if((link->batches+i)->data == NULL){
+            return -1;
+        }
+        spscPush(link->spare,link->batches+i);
+    }
+    return 0;
+}
+
+void freeLink(struct pipelineLink* link){
+    for(int i = 0; i < link->nbBatches; i++){
+        free((link->batches+i)->data);
+    }
+    free(link->batches);
+    freeSpscRing(link->full);
+    freeSpscRing(link->spare);
+}
+
+struct pipelineBatch* takeBatch(struct pipelineLink* link){
+    return (struct pipelineBatch*) spscPopWait(link->spare,NULL);
+}
+
+/*
+Fonction : handOffBatch
+Entrées : lien, lot rempli, étage producteur
+Sorties : 
+Un blocage (étage suivant en retard avec toutes ses places occupées) est compté.
+*/
+void handOffBatch(struct pipelineLink* link, struct pipelineBatch* batch, struct pipelineStage* stage){
+    stage->nbBatches += 1;
+    if(spscPush(link->full,batch) < 0){
+        stage->nbStalls += 1;
+        spscPushWait(link->full,batch,NULL);
+    }
+}
+
+struct pipelineBatch* nextBatch(struct pipelineLink* link){
+    return (struct pipelineBatch*) spscPopWait(link->full,NULL);
+}
+
+void releaseBatch(struct pipelineLink* link, struct pipelineBatch* batch){
+    spscPushWait(link->spare,batch,NULL);
+}
+
+/*
+Fonction : endStage
+Entrées : chaîne, étage qui n'a pas pu être lancé
+Sorties : 
+Envoie à l'étage suivant le dernier lot que cet étage aurait envoyé.
+*/
+void endStage(struct pipeline* pipeline, int stage){
+    if(stage == STAGE_WRITER){
+        return;
+    }
+    if(stage == STAGE_DECODER){
+        if(pipeline->output != NULL){
+            endOutput(pipeline);
+        }
+        return;
+    }
+    if(stage == STAGE_READER && pipeline->rx->channelizer == NULL){
+        stage = STAGE_CHANNELIZER;
+    }
+    struct pipelineBatch* batch = takeBatch(pipeline->links+stage);
+    batch->size = 0;
+    batch->end = 1;
+    spscPushWait((pipeline->links+stage)->full,batch,NULL);
+}
+
+/*
+Fonction : endOutput
+Entrées : chaîne
+Sorties : 
+Un tampon vide marque la fin du flux pour l'étage d'écriture.
+*/
+void endOutput(struct pipeline* pipeline){
+    struct outputBlock* last = (struct outputBlock*) spscPopWait(pipeline->spareBlocks,NULL);
+    last->size = 0;
+    spscPushWait(pipeline->pendingBlocks,last,NULL);
+}
@@ -0,0 +1,79 @@
+#ifndef HEADER_PIPELINE
+#define HEADER_PIPELINE
+
+#include "complexLib.h"
+#include "iqInput.h"
+#include "receiver.h"
+#include "outputWriter.h"
+#include "spscRing.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIPELINE_BATCH 65536
+#define PIPELINE_DEPTH 16
+#define PIPELINE_FRAMES 64
+#define PIPELINE_OUTPUT_BLOCKS 4
+
+#define STAGE_READER 0
+#define STAGE_CHANNELIZER 1
+#define STAGE_DEMOD 2
+#define STAGE_DEFRAMER 3
+#define STAGE_DECODER 4
+#define STAGE_WRITER 5
+#define PIPELINE_STAGES 6
+
+struct pipelineBatch
+{
+    void* data;
+    int size;
+    int end;
+};
+
+struct pipelineFrame
+{
+    int bits[MAX_FRAME_WINDOW];
+    int size;
+    long long bitIndex;
+};
+
+struct pipelineLink
+{
+    struct spscRing* full;
+    struct spscRing* spare;
+    struct pipelineBatch* batches;
+    int nbBatches;
+};
+
+struct pipelineStage
+{
+    struct pipeline* pipeline;
+    void* (*run)(void*);
+    pthread_t thread;
+    int started;
+    long long nbBatches;
+    long long nbStalls;
+};
+
+struct pipeline
+{
+    struct receiver* rx;
+    struct iqInput* input;
+    struct outputWriter* output;
+    int firstCpu;
+    struct pipelineLink links[PIPELINE_STAGES-2];
+    struct pipelineStage stages[PIPELINE_STAGES];
+    struct pipelineBatch* frames;
+    struct outputBlock blocks[PIPELINE_OUTPUT_BLOCKS];
+    struct spscRing* pendingBlocks;
+    struct spscRing* spareBlocks;
+    int writeStatus;
+    void (*callback)(int* frame, int size, long long bitIndex, void* context);
+    void* context;
+};
+
+struct pipeline* createPipeline(struct receiver* rx, struct iqInput* input, struct outputWriter* output, int firstCpu);
+void freePipeline(struct pipeline* pipeline);
+int runPipeline(struct pipeline* pipeline);
+
+#endif
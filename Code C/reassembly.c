@@ -0,0 +1,238 @@
+#include "reassembly.h"
+
+#define ENTRY_EMPTY 0
+#define ENTRY_PENDING 1
+#define ENTRY_COMPLETED 2
+#define TYPE24_SEQUENCE -24
+
+int findEntry(struct reassemblyCache* cache, unsigned int mmsi, int sequence, double timestamp, int* found);
+void decodeType24(int* inputVector, int part, struct staticRecord* record);
+void decodeType5(int* inputVector, struct staticRecord* record);
+
+/*
+Fonction : createReassemblyCache
+Entrées : nombre d'entrées du cache, durée de vie d'une entrée en secondes
+Sorties : le cache alloué, NULL en cas d'erreur
+Le nombre d'entrées est arrondi à la puissance de 2 supérieure. La mémoire est
+allouée une fois pour toutes : le cache ne grossit jamais.
+*/
+struct reassemblyCache* createReassemblyCache(int capacity, double timeout){
+    struct reassemblyCache* cache = (struct reassemblyCache*) malloc(sizeof(struct reassemblyCache));
+    if(cache == NULL){
+        return NULL;
+    }
+    cache->capacity = REASSEMBLY_MAX_PROBE;
+    while(cache->capacity < capacity){
+        cache->capacity *= 2;
+    }
+    cache->entries = (struct reassemblyEntry*) calloc(cache->capacity,sizeof(struct reassemblyEntry));
+    if(cache->entries == NULL){
+        free(cache);
+        return NULL;
+    }
+    cache->timeout = timeout;
+    cache->nbCompleted = 0;
+    cache->nbEvicted = 0;
+    return cache;
+}
+
+void freeReassemblyCache(struct reassemblyCache* cache){
+    if(cache == NULL){
+        return;
+    }
+    free(cache->entries);
+    free(cache);
+}
+
+/*
+Fonction : findEntry
+Entrées : cache, MMSI, numéro de séquence, date courante, indicateur de présence
+Sorties : l'indice de l'entrée correspondant à la clé, ou de l'entrée à utiliser pour l'insérer
+Adressage ouvert à sondage linéaire borné à REASSEMBLY_MAX_PROBE cases. Une entrée
+plus vieille que le timeout est considérée comme libre : l'éviction se fait au fil
+des insertions, sans parcours du cache. Si aucune case n'est libre, la plus ancienne
+du voisinage est écrasée.
+*/
+int findEntry(struct reassemblyCache* cache, unsigned int mmsi, int sequence, double timestamp, int* found){
+    unsigned int hash = (mmsi*2654435761u) ^ ((unsigned int)sequence*40503u);
+    int mask = cache->capacity-1;
+    int candidate = -1;
+    int oldest = -1;
+    *found = 0;
+    for(int p=0; p<REASSEMBLY_MAX_PROBE; p++){
+        int index = (hash+p) & mask;
+        struct reassemblyEntry* entry = cache->entries+index;
+        if(entry->state == ENTRY_EMPTY){
+            if(candidate < 0){
+                candidate = index;
+            }
+            break;
+        }
+        if(timestamp-entry->timestamp > cache->timeout){
+            if(candidate < 0){
+                candidate = index;
+            }
+            continue;
+        }
+        if(entry->mmsi == mmsi && entry->sequence == sequence){
+            *found = 1;
+            return index;
+        }
+        if(oldest < 0 || entry->timestamp < (cache->entries+oldest)->timestamp){
+            oldest = index;
+        }
+    }
+    if(candidate < 0){
+        candidate = oldest;
+        cache->nbEvicted += 1;
+    }
+    return candidate;
+}
+
+/*
+Fonction : addType24Part
+Entrées : cache, vecteur de bits d'un message de type 24, taille du vecteur, date de réception, enregistrement pour recevoir la sortie
+Sorties : 1 si les parties A et B sont réunies (l'enregistrement est alors rempli), 0 sinon
+Un enregistrement complet n'est renvoyé qu'une fois : les répétitions reçues avant
+l'expiration de l'entrée sont ignorées.
+*/
+int addType24Part(struct reassemblyCache* cache, int* inputVector, int size, double timestamp, struct staticRecord* record){
+    if(size < 160){
+        return 0;
+    }
+    unsigned int mmsi = getUnsignedFromMessage(inputVector,8,38);
+    int part = getUnsignedFromMessage(inputVector,38,40);
+    if(part > 1 || (part == 1 && size < 162)){
+        return 0;
+    }
+
+    int found;
+    struct reassemblyEntry* entry = cache->entries+findEntry(cache,mmsi,TYPE24_SEQUENCE,timestamp,&found);
+    if(!found){
+        memset(&entry->record,0,sizeof(struct staticRecord));
+        entry->mmsi = mmsi;
+        entry->sequence = TYPE24_SEQUENCE;
+        entry->state = ENTRY_PENDING;
+        entry->timestamp = timestamp;
+        entry->partsReceived = 0;
+        entry->partsExpected = 3;
+        entry->nbBits = 0;
+    } else if(entry->state == ENTRY_COMPLETED){
+        return 0;
+    }
+
+    decodeType24(inputVector,part,&entry->record);
+    entry->partsReceived |= 1<<part;
+    if(entry->partsReceived != entry->partsExpected){
+        return 0;
+    }
+    entry->state = ENTRY_COMPLETED;
+    entry->record.messageType = 24;
+    entry->record.mmsi = mmsi;
+    *record = entry->record;
+    cache->nbCompleted += 1;
+    return 1;
+}
+
+/*
+Fonction : addType5Fragment
+Entrées : cache, identifiant de la source (MMSI s'il est connu, 0 sinon), numéro de séquence,
+numéro du fragment (à partir de 1), nombre de fragments, bits du fragment, taille du fragment,
+date de réception, enregistrement pour recevoir la sortie
+Sorties : 1 si le message de type 5 est complet (l'enregistrement est alors rempli), 0 sinon
+Chaque fragment sauf le dernier porte FRAGMENT_SIZE bits. Un message reçu en un seul
+morceau se passe avec numéro et nombre de fragments égaux à 1. Un message complet
+n'est renvoyé qu'une fois : ses répétitions sont ignorées, mais un fragment différent
+sous la même clé avant l'expiration commence un nouveau message.
+*/
+int addType5Fragment(struct reassemblyCache* cache, unsigned int mmsi, int sequence, int fragmentNumber, int nbFragments, int* inputVector, int size, double timestamp, struct staticRecord* record){
+    int offset = (fragmentNumber-1)*FRAGMENT_SIZE;
+    if(nbFragments < 1 || nbFragments > MAX_FRAGMENTS || fragmentNumber < 1 || fragmentNumber > nbFragments){
+        return 0;
+    }
+    if(size > TYPE5_SIZE-offset || (fragmentNumber < nbFragments && size != FRAGMENT_SIZE)){
+        return 0;
+    }
+
+    int found;
+    struct reassemblyEntry* entry = cache->entries+findEntry(cache,mmsi,sequence,timestamp,&found);
+    if(found && (entry->partsExpected != (1<<nbFragments)-1 || (entry->partsReceived & (1<<(fragmentNumber-1))))){
+        // Fragment déjà reçu : répétition s'il est identique, sinon l'identifiant de
+        // séquence (0 à 9) a été réutilisé par un nouveau message qui remplace l'entrée
+        int receivedSize = fragmentNumber == nbFragments ? entry->nbBits-offset : FRAGMENT_SIZE;
+        if(entry->partsExpected == (1<<nbFragments)-1 && receivedSize == size && memcmp(entry->bits+offset,inputVector,size*sizeof(int)) == 0){
+            return 0;
+        }
+        found = 0;
+    }
+    if(!found){
+        entry->mmsi = mmsi;
+        entry->sequence = sequence;
+        entry->state = ENTRY_PENDING;
+        entry->timestamp = timestamp;
+        entry->partsReceived = 0;
+        entry->partsExpected = (1<<nbFragments)-1;
+        entry->nbBits = 0;
+    }
+
+    memcpy(entry->bits+offset,inputVector,size*sizeof(int));
+    entry->partsReceived |= 1<<(fragmentNumber-1);
+    if(fragmentNumber == nbFragments){
+        entry->nbBits = offset+size;
+    }
+    if(entry->partsReceived != entry->partsExpected){
+        return 0;
+    }
+    // Certains encodeurs omettent les 2 derniers bits (bit DTE et réserve). Un message
+    // trop court est oublié sans clore l'entrée : une répétition reste acceptée.
+    if(entry->nbBits < TYPE5_SIZE-2 || getUnsignedFromMessage(entry->bits,0,6) != 5){
+        entry->partsReceived = 0;
+        return 0;
+    }
+    entry->state = ENTRY_COMPLETED;
+    memset(entry->bits+entry->nbBits,0,(TYPE5_SIZE-entry->nbBits)*sizeof(int));
+    decodeType5(entry->bits,&entry->record);
+    *record = entry->record;
+    cache->nbCompleted += 1;
+    return 1;
+}
+
+/*
+Fonction : decodeType24
+Entrées : vecteur de bits d'entrée, numéro de partie, enregistrement à compléter
+Sorties :
+Décode les champs de la partie A (nom) ou B (type, indicatif, dimensions)
+*/
+void decodeType24(int* inputVector, int part, struct staticRecord* record){
+    if(part == 0){
+        getStringFromMessage(inputVector,40,160,record->name);
+        return;
+    }
+    record->shipType = getUnsignedFromMessage(inputVector,40,48);
+    getStringFromMessage(inputVector,90,132,record->callSign);
+    record->toBow = getUnsignedFromMessage(inputVector,132,141);
+    record->toStern = getUnsignedFromMessage(inputVector,141,150);
+    record->toPort = getUnsignedFromMessage(inputVector,150,156);
+    record->toStarboard = getUnsignedFromMessage(inputVector,156,162);
+}
+
+/*
+Fonction : decodeType5
+Entrées : vecteur de bits d'un message de type 5 complet, enregistrement pour recevoir la sortie
+Sorties :
+Décode les données statiques et de voyage
+*/
+void decodeType5(int* inputVector, struct staticRecord* record){
+    memset(record,0,sizeof(struct staticRecord));
+    record->messageType = 5;
+    record->mmsi = getUnsignedFromMessage(inputVector,8,38);
+    record->imo = getUnsignedFromMessage(inputVector,40,70);
+    getStringFromMessage(inputVector,70,112,record->callSign);
+    getStringFromMessage(inputVector,112,232,record->name);
+    record->shipType = getUnsignedFromMessage(inputVector,232,240);
+    record->toBow = getUnsignedFromMessage(inputVector,240,249);
+    record->toStern = getUnsignedFromMessage(inputVector,249,258);
+    record->toPort = getUnsignedFromMessage(inputVector,258,264);
+    record->toStarboard = getUnsignedFromMessage(inputVector,264,270);
+    getStringFromMessage(inputVector,302,422,record->destination);
+}
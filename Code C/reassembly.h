@@ -0,0 +1,52 @@
+#ifndef HEADER_REASSEMBLY
+#define HEADER_REASSEMBLY
+
+#include "aisdecode.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define REASSEMBLY_MAX_PROBE 16
+#define TYPE5_SIZE 424
+#define FRAGMENT_SIZE 360
+#define MAX_FRAGMENTS 2
+
+struct staticRecord
+{
+    int messageType;
+    unsigned int mmsi;
+    unsigned int imo;
+    char callSign[8];
+    char name[21];
+    char destination[21];
+    int shipType;
+    int toBow, toStern, toPort, toStarboard;
+};
+
+struct reassemblyEntry
+{
+    unsigned int mmsi;
+    int sequence;
+    int state;
+    double timestamp;
+    int partsReceived;
+    int partsExpected;
+    int nbBits;
+    struct staticRecord record;
+    int bits[TYPE5_SIZE];
+};
+
+struct reassemblyCache
+{
+    struct reassemblyEntry* entries;
+    int capacity;
+    double timeout;
+    int nbCompleted;
+    int nbEvicted;
+};
+
+struct reassemblyCache* createReassemblyCache(int capacity, double timeout);
+void freeReassemblyCache(struct reassemblyCache* cache);
+int addType24Part(struct reassemblyCache* cache, int* inputVector, int size, double timestamp, struct staticRecord* record);
+int addType5Fragment(struct reassemblyCache* cache, unsigned int mmsi, int sequence, int fragmentNumber, int nbFragments, int* inputVector, int size, double timestamp, struct staticRecord* record);
+
+#endif
@@ -0,0 +1,461 @@
+#include "receiver.h"
+
+int preamble_flag[32]={0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 1, 1, 1, 1, 1, 0};
+
+void runBlock(struct receiver* rx, int nbValidBits);
+void demodulateCurrent(struct receiver* rx, int* bits, int nbValidBits);
+void scanWindows(struct receiver* rx, int nbPositions);
+void processWindow(struct receiver* rx, int* window, long long bitIndex);
+int frameStatus(int* bits, int* data, int* nbData, int* nbFrameBits);
+long long inputSample(struct receiver* rx, long long sample);
+
+/*
+Fonction : createReceiver
+Entrées : taille d'un bloc de démodulation, nombre d'échantillons par bit, fonction appelée pour chaque trame, contexte passé à la fonction
+Sorties : le récepteur alloué, NULL en cas d'erreur
+Les blocs successifs se recouvrent de blockSize-stride échantillons afin que les bits
+démodulés forment un flux continu. La fonction reçoit les bits de chaque trame
+trouvée (sans fanions, bourrage ni somme de contrôle, octets remis dans l'ordre)
+et l'indice du bit où commence la fenêtre de la trame.
+*/
+struct receiver* createReceiver(int blockSize, int timeDelay, void (*callback)(int*, int, long long, void*), void* context){
+    if(blockSize/timeDelay-2 < 1){
+        return NULL;
+    }
+    struct receiver* rx = (struct receiver*) calloc(1,sizeof(struct receiver));
+    if(rx == NULL){
+        return NULL;
+    }
+    rx->blockSize = blockSize;
+    rx->timeDelay = timeDelay;
+    rx->nbBits = blockSize/timeDelay-2;
+    rx->stride = rx->nbBits*timeDelay;
+    rx->samples = (struct complex*) malloc(blockSize*sizeof(struct complex));
+    rx->buffer = (struct complex*) malloc(blockSize*sizeof(struct complex));
+    rx->delayedBuffer = (struct complex*) malloc(blockSize*sizeof(struct complex));
+    rx->bits = (int*) malloc((2*(MAX_FRAME_WINDOW-1)+rx->nbBits)*sizeof(int));
+    if(rx->samples == NULL || rx->buffer == NULL || rx->delayedBuffer == NULL || rx->bits == NULL){
+        freeReceiver(rx);
+        return NULL;
+    }
+    rx->callback = callback;
+    rx->context = context;
+    return rx;
+}
+
+void freeReceiver(struct receiver* rx){
+    if(rx == NULL){
+        return;
+    }
+    free(rx->samples);
+    free(rx->buffer);
+    free(rx->delayedBuffer);
+    free(rx->bits);
+    free(rx->rawSamples);
+    free(rx->channelSamples);
+    free(rx);
+}
+
+/*
+Fonction : createChannelReceiver
+Entrées : fréquence d'échantillonnage de l'entrée (0 si l'entrée est déjà le canal à timeDelay échantillons
+par bit), écart entre le canal et la fréquence centrale (Hz), fonction appelée pour chaque trame, contexte
+Sorties : le récepteur alloué, NULL en cas d'erreur
+Le canal est extrait et rééchantillonné à CHANNEL_SAMPLES_PER_BIT échantillons par
+bit. Le filtre de canal (rx->channelizer) reste à la charge de l'appelant.
+*/
+struct receiver* createChannelReceiver(double sampleRate, double offset, void (*callback)(int*, int, long long, void*), void* context){
+    if(sampleRate <= 0){
+        return createReceiver(sizeSignal,timeDelay,callback,context);
+    }
+    struct channelizer* ch = createChannelizer(sampleRate,offset,CHANNEL_SAMPLES_PER_BIT*bitRate);
+    struct receiver* rx = createReceiver(CHANNEL_BLOCK_SIZE,CHANNEL_SAMPLES_PER_BIT,callback,context);
+    if(ch == NULL || rx == NULL || setReceiverChannelizer(rx,ch) < 0){
+        freeChannelizer(ch);
+        freeReceiver(rx);
+        return NULL;
+    }
+    return rx;
+}
+
+/*
+Fonction : setReceiverChannelizer
+Entrées : récepteur, filtre de canal
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+Les entrées lues par processIqInput passent ensuite par le filtre de canal avant la
+démodulation. Le filtre reste à la charge de l'appelant.
+*/
+int setReceiverChannelizer(struct receiver* rx, struct channelizer* ch){
+    free(rx->rawSamples);
+    free(rx->channelSamples);
+    rx->rawSamples = (struct complex*) malloc(RAW_BLOCK_SIZE*sizeof(struct complex));
+    rx->channelSamples = (struct complex*) malloc(channelizerMaxOutput(ch,RAW_BLOCK_SIZE)*sizeof(struct complex));
+    if(rx->rawSamples == NULL || rx->channelSamples == NULL){
+        free(rx->rawSamples);
+        free(rx->channelSamples);
+        rx->rawSamples = NULL;
+        rx->channelSamples = NULL;
+        rx->channelizer = NULL;
+        return -1;
+    }
+    rx->channelizer = ch;
+    return 0;
+}
+
+/*
+Fonction : processSamples
+Entrées : récepteur, vecteur d'échantillons, nombre d'échantillons
+Sorties : 
+Ajoute des échantillons au flux ; chaque bloc complet est démodulé puis analysé.
+*/
+void processSamples(struct receiver* rx, struct complex* samples, int nbSamples){
+    while(nbSamples > 0){
+        int size = rx->blockSize-rx->nbSamples;
+        if(size > nbSamples){
+            size = nbSamples;
+        }
+        memcpy(rx->samples+rx->nbSamples,samples,size*sizeof(struct complex));
+        rx->nbSamples += size;
+        samples += size;
+        nbSamples -= size;
+        if(rx->nbSamples == rx->blockSize){
+            runBlock(rx,rx->nbBits);
+        }
+    }
+}
+
+/*
+Fonction : processInputSamples
+Entrées : récepteur, échantillons de l'entrée, nombre d'échantillons
+Sorties : 
+Comme processSamples, mais les échantillons passent d'abord par le filtre de canal
+quand il y en a un.
+*/
+void processInputSamples(struct receiver* rx, struct complex* samples, int nbSamples){
+    if(rx->channelizer == NULL){
+        processSamples(rx,samples,nbSamples);
+        return;
+    }
+    int maxOutput = channelizerMaxOutput(rx->channelizer,RAW_BLOCK_SIZE);
+    while(nbSamples > 0){
+        int size = nbSamples < RAW_BLOCK_SIZE ? nbSamples : RAW_BLOCK_SIZE;
+        int nbOutput = channelize(rx->channelizer,samples,size,rx->channelSamples,maxOutput);
+        processSamples(rx,rx->channelSamples,nbOutput);
+        samples += size;
+        nbSamples -= size;
+    }
+}
+
+/*
+Fonction : processIqInput
+Entrées : récepteur, entrée IQ
+Sorties : 
+Lit toute l'entrée bloc par bloc ; les échantillons sont convertis directement dans
+le bloc du récepteur, ou dans un bloc intermédiaire filtré par le filtre de canal
+quand il y en a un. La mémoire utilisée ne dépend pas de la taille de l'entrée.
+*/
+void processIqInput(struct receiver* rx, struct iqInput* input){
+    int size;
+    if(rx->channelizer != NULL){
+        while((size = readIqSamples(input,rx->rawSamples,RAW_BLOCK_SIZE)) > 0){
+            processInputSamples(rx,rx->rawSamples,size);
+        }
+        return;
+    }
+    while((size = readIqSamples(input,rx->samples+rx->nbSamples,rx->blockSize-rx->nbSamples)) > 0){
+        rx->nbSamples += size;
+        if(rx->nbSamples == rx->blockSize){
+            runBlock(rx,rx->nbBits);
+        }
+    }
+}
+
+/*
+Fonction : flushReceiver
+Entrées : récepteur
+Sorties : 
+Fin de flux : le dernier bloc incomplet est complété par des zéros et démodulé (seuls
+ses bits issus d'échantillons réels sont gardés), puis les dernières positions sont
+analysées avec des bits nuls après la fin du flux.
+*/
+void flushReceiver(struct receiver* rx){
+    int nbValidBits = rx->nbSamples/rx->timeDelay-2;
+    if(nbValidBits > 0){
+        memset(rx->samples+rx->nbSamples,0,(rx->blockSize-rx->nbSamples)*sizeof(struct complex));
+        runBlock(rx,nbValidBits);
+    }
+    flushBits(rx);
+    if(rx->bursts != NULL){
+        flushBurstRecorder(rx->bursts);
+    }
+    rx->nbSamples = 0;
+}
+
+/*
+Fonction : demodulateSamples
+Entrées : récepteur, vecteur d'échantillons, nombre d'échantillons, vecteur recevant les bits
+Sorties : le nombre de bits produits
+Première moitié du récepteur : comme processSamples, mais les bits de chaque bloc
+complet sont écrits à la suite dans bits au lieu d'être analysés. Le vecteur doit
+pouvoir recevoir (nbSamples/stride+1)*nbBits bits. Cette moitié n'utilise que les
+échantillons, le filtre de canal, l'enregistreur de salves et la sortie des bits ;
+l'autre moitié (processBits) peut donc tourner dans un autre fil.
+*/
+int demodulateSamples(struct receiver* rx, struct complex* samples, int nbSamples, int* bits){
+    int nbOutput = 0;
+    while(nbSamples > 0){
+        int size = rx->blockSize-rx->nbSamples;
+        if(size > nbSamples){
+            size = nbSamples;
+        }
+        memcpy(rx->samples+rx->nbSamples,samples,size*sizeof(struct complex));
+        rx->nbSamples += size;
+        samples += size;
+        nbSamples -= size;
+        if(rx->nbSamples == rx->blockSize){
+            demodulateCurrent(rx,bits+nbOutput,rx->nbBits);
+            nbOutput += rx->nbBits;
+        }
+    }
+    return nbOutput;
+}
+
+/*
+Fonction : flushSamples
+Entrées : récepteur, vecteur recevant les bits (au moins nbBits)
+Sorties : le nombre de bits produits
+Fin de flux pour demodulateSamples : le dernier bloc incomplet est complété par des
+zéros et démodulé.
+*/
+int flushSamples(struct receiver* rx, int* bits){
+    int nbValidBits = rx->nbSamples/rx->timeDelay-2;
+    if(nbValidBits > 0){
+        memset(rx->samples+rx->nbSamples,0,(rx->blockSize-rx->nbSamples)*sizeof(struct complex));
+        demodulateCurrent(rx,bits,nbValidBits);
+    }
+    if(rx->bursts != NULL){
+        flushBurstRecorder(rx->bursts);
+    }
+    rx->nbSamples = 0;
+    return nbValidBits > 0 ? nbValidBits : 0;
+}
+
+/*
+Fonction : processBits
+Entrées : récepteur, bits démodulés, nombre de bits
+Sorties : 
+Seconde moitié du récepteur : ajoute des bits à l'historique et cherche les trames.
+N'utilise que l'historique de bits, l'index de salves et la fonction des trames.
+*/
+void processBits(struct receiver* rx, int* bits, int nbBits){
+    while(nbBits > 0){
+        int size = nbBits < rx->nbBits ? nbBits : rx->nbBits;
+        memcpy(rx->bits+rx->nbHistory,bits,size*sizeof(int));
+        rx->nbHistory += size;
+        scanWindows(rx,rx->nbHistory-(MAX_FRAME_WINDOW-1));
+        bits += size;
+        nbBits -= size;
+    }
+}
+
+/*
+Fonction : flushBits
+Entrées : récepteur
+Sorties : 
+Fin de flux pour processBits : les dernières positions sont analysées avec des bits
+nuls après la fin du flux.
+*/
+void flushBits(struct receiver* rx){
+    int nbPositions = rx->nbHistory;
+    memset(rx->bits+rx->nbHistory,0,(MAX_FRAME_WINDOW-1)*sizeof(int));
+    rx->nbHistory += MAX_FRAME_WINDOW-1;
+    scanWindows(rx,nbPositions);
+    rx->nbHistory = 0;
+}
+
+/*
+Fonction : processIqRange
+Entrées : récepteur, entrée IQ repositionnable, premier échantillon de la région, nombre d'échantillons
+Sorties : 0 en cas de succès, -1 si la région est hors de l'entrée
+Ne traite qu'une région de l'entrée, par exemple une salve notée dans un index ; les
+dates des trames restent celles de l'enregistrement complet. Le début de la région
+est avancé jusqu'au premier bit entier : les bits tombent aux mêmes instants que
+lors d'un traitement de tout l'enregistrement.
+*/
+int processIqRange(struct receiver* rx, struct iqInput* input, long long start, long long nbSamples){
+    long long first, firstInput;
+    if(rx->channelizer != NULL){
+        first = (long long)ceil(start/rx->channelizer->step/rx->timeDelay)*rx->timeDelay;
+        firstInput = (long long)floor(1+first*rx->channelizer->step)-1;
+    } else {
+        first = (start+rx->timeDelay-1)/rx->timeDelay*rx->timeDelay;
+        firstInput = first;
+    }
+    if(seekIqInput(input,firstInput) < 0){
+        return -1;
+    }
+    if(rx->channelizer != NULL){
+        resetChannelizer(rx->channelizer,firstInput,first);
+    }
+    nbSamples -= firstInput-start;
+    rx->nbSamples = 0;
+    rx->nbHistory = 0;
+    rx->bitIndex = first/rx->timeDelay;
+    rx->sampleIndex = first;
+    while(nbSamples > 0){
+        int size;
+        if(rx->channelizer != NULL){
+            size = readIqSamples(input,rx->rawSamples,nbSamples < RAW_BLOCK_SIZE ? nbSamples : RAW_BLOCK_SIZE);
+            processInputSamples(rx,rx->rawSamples,size);
+        } else {
+            size = rx->blockSize-rx->nbSamples;
+            size = readIqSamples(input,rx->samples+rx->nbSamples,nbSamples < size ? nbSamples : size);
+            rx->nbSamples += size;
+            if(rx->nbSamples == rx->blockSize){
+                runBlock(rx,rx->nbBits);
+            }
+        }
+        if(size == 0){
+            break;
+        }
+        nbSamples -= size;
+    }
+    flushReceiver(rx);
+    return 0;
+}
+
+/*
+Fonction : runBlock
+Entrées : récepteur, nombre de bits valides du bloc
+Sorties : 
+Démodule le bloc courant directement dans l'historique puis analyse toutes les
+fenêtres complètes.
+*/
+void runBlock(struct receiver* rx, int nbValidBits){
+    demodulateCurrent(rx,rx->bits+rx->nbHistory,nbValidBits);
+    rx->nbHistory += nbValidBits;
+    scanWindows(rx,rx->nbHistory-(MAX_FRAME_WINDOW-1));
+}
+
+/*
+Fonction : demodulateCurrent
+Entrées : récepteur, vecteur recevant les bits du bloc, nombre de bits valides du bloc
+Sorties : 
+Démodule le bloc courant puis garde le recouvrement pour le bloc suivant. Les
+échantillons encore jamais vus sont d'abord passés à l'enregistreur de salves.
+*/
+void demodulateCurrent(struct receiver* rx, int* bits, int nbValidBits){
+    if(rx->bursts != NULL){
+        long long nbRecorded = atomic_load_explicit(&rx->bursts->written,memory_order_relaxed)-rx->sampleIndex;
+        if(nbRecorded < rx->nbSamples){
+            recordBurstSamples(rx->bursts,rx->samples+nbRecorded,rx->nbSamples-nbRecorded);
+        }
+    }
+    memcpy(rx->buffer,rx->samples,rx->blockSize*sizeof(struct complex));
+    demodulateBlock(rx->buffer,rx->delayedBuffer,bits,rx->blockSize,rx->timeDelay);
+    if(rx->demodOutput != NULL){
+        writeBits(rx->demodOutput,bits,nbValidBits);
+    }
+
+    int nbPending = rx->blockSize-rx->stride;
+    memmove(rx->samples,rx->samples+rx->stride,nbPending*sizeof(struct complex));
+    rx->nbSamples = nbPending;
+    rx->sampleIndex += rx->stride;
+}
+
+/*
+Fonction : scanWindows
+Entrées : récepteur, nombre de positions de départ à analyser
+Sorties : 
+Cherche une trame à chaque position puis retire les bits analysés de l'historique.
+*/
+void scanWindows(struct receiver* rx, int nbPositions){
+    if(nbPositions <= 0){
+        return;
+    }
+    for(int i = 0; i < nbPositions; i++){
+        processWindow(rx,rx->bits+i,rx->bitIndex+i);
+    }
+    rx->nbHistory -= nbPositions;
+    memmove(rx->bits,rx->bits+nbPositions,rx->nbHistory*sizeof(int));
+    rx->bitIndex += nbPositions;
+}
+
+/*
+Fonction : processWindow
+Entrées : récepteur, fenêtre de MAX_FRAME_WINDOW bits démodulés, indice du premier bit de la fenêtre
+Sorties : 
+Teste la présence du préambule et du fanion de début, puis retire fanions, bourrage
+et somme de contrôle et remet les bits de chaque octet dans l'ordre. La trame
+s'arrête au fanion de fin : un message de plusieurs créneaux (type 5) est rendu en
+entier. Seules les trames dont la somme de contrôle est correcte sont transmises à la
+fonction des trames ; l'index et l'enregistreur de salves voient toutes les trames.
+*/
+void processWindow(struct receiver* rx, int* window, long long bitIndex){
+    // Test the presence of the preamble flag before any copy : after the NRZI
+    // inversion, a bit is 1 when the level does not change
+    for(int j=8; j<40;j++){
+        if((*(window+j) == *(window+j-1)) != *(preamble_flag+j-8)){
+            return;
+        }
+    }
+    int bits[MAX_FRAME_WINDOW];
+    memcpy(bits,window,MAX_FRAME_WINDOW*sizeof(int));
+    nrziInv(bits,MAX_FRAME_WINDOW);
+
+    int data[MAX_FRAME_WINDOW];
+    int nbFrameBits, nbData;
+    int status = frameStatus(bits,data,&nbData,&nbFrameBits);
+
+    // Note every detected frame and whether it passes the checksum
+    if(rx->index != NULL){
+        addBurstEntry(rx->index,inputSample(rx,bitIndex*rx->timeDelay),
+            inputSample(rx,(bitIndex+nbFrameBits)*rx->timeDelay),status);
+    }
+
+    // Keep the raw samples of every detected frame, decoded or not
+    if(rx->bursts != NULL){
+        triggerBurst(rx->bursts,bitIndex*rx->timeDelay,(bitIndex+nbFrameBits)*rx->timeDelay,BURST_PREAMBLE);
+    }
+
+    // Treatment before decoding
+    int currentSize = (nbData-sizeCheckSum)/8*8;
+    if(status != BURST_DECODED || currentSize <= 0){
+        return;
+    }
+    int flipVector[MAX_FRAME_WINDOW];
+    flipBits(data,flipVector,currentSize);
+    rx->callback(flipVector,currentSize,bitIndex,rx->context);
+}
+
+/*
+Fonction : frameStatus
+Entrées : fenêtre de bits (NRZI inversé) commençant par le préambule, vecteur recevant les
+bits sans bourrage (somme de contrôle comprise), nombre de ces bits, nombre de bits de la trame en sortie
+Sorties : BURST_DECODED si la somme de contrôle est correcte, BURST_CRC_ERROR sinon,
+BURST_TRUNCATED si le fanion de fin n'est pas dans la fenêtre
+*/
+int frameStatus(int* bits, int* data, int* nbData, int* nbFrameBits){
+    int endFlag = findEndFlag(bits+sizePreambleFlag,MAX_FRAME_WINDOW-sizePreambleFlag);
+    if(endFlag < 0){
+        *nbFrameBits = FRAME_WINDOW;
+        *nbData = 0;
+        return BURST_TRUNCATED;
+    }
+    *nbFrameBits = sizePreambleFlag+endFlag+8;
+    *nbData = bitStuffingInv(bits+sizePreambleFlag,data,endFlag);
+    return checkCrc(data,*nbData) ? BURST_DECODED : BURST_CRC_ERROR;
+}
+
+/*
+Fonction : inputSample
+Entrées : récepteur, indice d'un échantillon démodulé
+Sorties : l'indice de l'échantillon correspondant dans l'entrée, avant le filtre de canal
+Le retard du filtre (la moitié de sa longueur) est compensé.
+*/
+long long inputSample(struct receiver* rx, long long sample){
+    if(rx->channelizer == NULL){
+        return sample;
+    }
+    return (long long)(sample*rx->channelizer->step)-rx->channelizer->nbTaps/2;
+}
@@ -0,0 +1,60 @@
+#ifndef HEADER_RECEIVER
+#define HEADER_RECEIVER
+
+#include "complexLib.h"
+#include "demod.h"
+#include "bitTreatment.h"
+#include "iqInput.h"
+#include "channelizer.h"
+#include "outputWriter.h"
+#include "burstRecorder.h"
+#include "burstIndex.h"
+#include "signalCaracteristics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAME_WINDOW 256
+#define MAX_FRAME_WINDOW 1280
+#define RAW_BLOCK_SIZE 16384
+#define CHANNEL_BLOCK_SIZE 65536
+
+struct receiver
+{
+    int blockSize;
+    int timeDelay;
+    int nbBits;
+    int stride;
+    struct complex* samples;
+    int nbSamples;
+    struct complex* buffer;
+    struct complex* delayedBuffer;
+    int* bits;
+    int nbHistory;
+    long long bitIndex;
+    struct outputWriter* demodOutput;
+    struct channelizer* channelizer;
+    struct complex* rawSamples;
+    struct complex* channelSamples;
+    struct burstRecorder* bursts;
+    struct burstIndex* index;
+    long long sampleIndex;
+    void (*callback)(int* frame, int size, long long bitIndex, void* context);
+    void* context;
+};
+
+struct receiver* createReceiver(int blockSize, int timeDelay, void (*callback)(int*, int, long long, void*), void* context);
+void freeReceiver(struct receiver* rx);
+struct receiver* createChannelReceiver(double sampleRate, double offset, void (*callback)(int*, int, long long, void*), void* context);
+int setReceiverChannelizer(struct receiver* rx, struct channelizer* ch);
+void processSamples(struct receiver* rx, struct complex* samples, int nbSamples);
+void processInputSamples(struct receiver* rx, struct complex* samples, int nbSamples);
+void processIqInput(struct receiver* rx, struct iqInput* input);
+void flushReceiver(struct receiver* rx);
+int processIqRange(struct receiver* rx, struct iqInput* input, long long start, long long nbSamples);
+int demodulateSamples(struct receiver* rx, struct complex* samples, int nbSamples, int* bits);
+int flushSamples(struct receiver* rx, int* bits);
+void processBits(struct receiver* rx, int* bits, int nbBits);
+void flushBits(struct receiver* rx);
+
+#endif
@@ -0,0 +1,315 @@
+#include "recording.h"
+#include "capture.h"
+#include <stdint.h>
+
+const char* findJsonValue(const char* json, const char* key);
+double parseIsoDate(const char* value);
+double readSystemTime(const uint8_t* input);
+int hasSuffix(const char* path, const char* suffix);
+uint32_t readLittleEndian(const uint8_t* input, int size);
+
+/*
+Fonction : readRecordingInfo
+Entrées : chemin de l'enregistrement, informations pour recevoir la sortie
+Sorties : 1 si des métadonnées ont été lues, 0 pour un fichier brut sans métadonnées, -1 en cas d'erreur
+Les fichiers SigMF (.sigmf-meta ou .sigmf-data), WAV et les enregistrements
+compressés (.aisiq) sont décrits par leurs métadonnées ; les autres fichiers sont des échantillons bruts dont le format est
+donné par l'extension.
+*/
+int readRecordingInfo(const char* path, struct recordingInfo* info){
+    memset(info,0,sizeof(struct recordingInfo));
+    info->dataSize = -1;
+    if(hasSuffix(path,".sigmf-meta") || hasSuffix(path,".sigmf-data")){
+        return readSigmfMeta(path,info) == 0 ? 1 : -1;
+    }
+    if(hasSuffix(path,".wav") || hasSuffix(path,".WAV")){
+        return readWavHeader(path,info) == 0 ? 1 : -1;
+    }
+    if(hasSuffix(path,".aisiq")){
+        return readCaptureInfo(path,info) == 0 ? 1 : -1;
+    }
+    if(strlen(path) >= RECORDING_PATH_SIZE){
+        return -1;
+    }
+    strcpy(info->dataPath,path);
+    info->format = iqFormatFromPath(path);
+    return 0;
+}
+
+/*
+Fonction : readSigmfMeta
+Entrées : chemin du fichier .sigmf-meta ou .sigmf-data, informations pour recevoir la sortie
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+Lit core:datatype et core:sample_rate dans global, core:frequency, core:header_bytes
+et core:datetime dans la première capture. Seuls les types complexes petit-boutistes
+sont acceptés.
+*/
+int readSigmfMeta(const char* path, struct recordingInfo* info){
+    size_t length = strlen(path)-strlen(".sigmf-meta");
+    if(length+strlen(".sigmf-data") >= RECORDING_PATH_SIZE){
+        return -1;
+    }
+    char metaPath[RECORDING_PATH_SIZE];
+    memcpy(metaPath,path,length);
+    strcpy(metaPath+length,".sigmf-meta");
+    memcpy(info->dataPath,path,length);
+    strcpy(info->dataPath+length,".sigmf-data");
+
+    FILE* file = fopen(metaPath,"rb");
+    if(file == NULL){
+        return -1;
+    }
+    fseek(file,0,SEEK_END);
+    long size = ftell(file);
+    fseek(file,0,SEEK_SET);
+    char* json = (char*) malloc(size+1);
+    if(json == NULL || fread(json,1,size,file) != (size_t)size){
+        free(json);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    *(json+size) = '\0';
+
+    int status = -1;
+    const char* value = findJsonValue(json,"core:datatype");
+    const char* datatypes[] = {"\"cu8\"", "\"ci8\"", "\"ci16_le\"", "\"cf32_le\""};
+    for(int i=0; value != NULL && i<4; i++){
+        if(strncmp(value,datatypes[i],strlen(datatypes[i])) == 0){
+            info->format = i;
+            status = 0;
+        }
+    }
+    value = findJsonValue(json,"core:sample_rate");
+    if(value == NULL){
+        status = -1;
+    } else {
+        info->sampleRate = atof(value);
+    }
+    const char* captures = strstr(json,"\"captures\"");
+    if(captures != NULL){
+        value = findJsonValue(captures,"core:frequency");
+        if(value != NULL){
+            info->centerFrequency = atof(value);
+        }
+        value = findJsonValue(captures,"core:header_bytes");
+        if(value != NULL){
+            info->dataOffset = atoll(value);
+        }
+        value = findJsonValue(captures,"core:datetime");
+        if(value != NULL){
+            info->startTime = parseIsoDate(value);
+        }
+    }
+    free(json);
+    return status;
+}
+
+/*
+Fonction : readWavHeader
+Entrées : chemin du fichier WAV, informations pour recevoir la sortie
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+Fichier WAV à 2 voies (I et Q) en PCM 8 bits, 16 bits ou flottant 32 bits, tel
+qu'enregistré par SDR# ou SDRuno. La date de début et la fréquence centrale sont
+lues dans le bloc auxi quand il est présent.
+*/
+int readWavHeader(const char* path, struct recordingInfo* info){
+    if(strlen(path) >= RECORDING_PATH_SIZE){
+        return -1;
+    }
+    strcpy(info->dataPath,path);
+    FILE* file = fopen(path,"rb");
+    if(file == NULL){
+        return -1;
+    }
+    uint8_t header[12];
+    uint8_t chunk[40];
+    int nbChannels = 0;
+    int audioFormat = 0;
+    int bitsPerSample = 0;
+    int status = -1;
+    if(fread(header,1,12,file) != 12 || memcmp(header,"RIFF",4) != 0 || memcmp(header+8,"WAVE",4) != 0){
+        fclose(file);
+        return -1;
+    }
+    while(fread(chunk,1,8,file) == 8){
+        uint32_t chunkSize = readLittleEndian(chunk+4,4);
+        long next = ftell(file)+chunkSize+(chunkSize & 1);
+        if(memcmp(chunk,"fmt ",4) == 0 && chunkSize >= 16 && fread(chunk,1,16,file) == 16){
+            audioFormat = readLittleEndian(chunk,2);
+            nbChannels = readLittleEndian(chunk+2,2);
+            info->sampleRate = readLittleEndian(chunk+4,4);
+            bitsPerSample = readLittleEndian(chunk+14,2);
+            // WAVE_FORMAT_EXTENSIBLE : le vrai format est au début du sous-format
+            if(audioFormat == 0xfffe && chunkSize >= 40 && fread(chunk,1,10,file) == 10){
+                audioFormat = readLittleEndian(chunk+8,2);
+            }
+        } else if(memcmp(chunk,"auxi",4) == 0 && chunkSize >= 36 && fread(chunk,1,36,file) == 36){
+            info->startTime = readSystemTime(chunk);
+            info->centerFrequency = readLittleEndian(chunk+32,4);
+        } else if(memcmp(chunk,"data",4) == 0){
+            info->dataOffset = ftell(file);
+            info->dataSize = chunkSize;
+            status = 0;
+            break;
+        }
+        fseek(file,next,SEEK_SET);
+    }
+    fclose(file);
+
+    if(status < 0 || nbChannels != 2){
+        return -1;
+    }
+    if(audioFormat == 1 && bitsPerSample == 8){
+        info->format = IQ_CU8;
+    } else if(audioFormat == 1 && bitsPerSample == 16){
+        info->format = IQ_CS16;
+    } else if(audioFormat == 3 && bitsPerSample == 32){
+        info->format = IQ_CF32;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+Fonction : readCaptureInfo
+Entrées : chemin de l'enregistrement compressé, informations pour recevoir la sortie
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+La fréquence centrale est celle du premier morceau.
+*/
+int readCaptureInfo(const char* path, struct recordingInfo* info){
+    if(strlen(path) >= RECORDING_PATH_SIZE){
+        return -1;
+    }
+    struct captureReader* reader = openCaptureReader(path);
+    if(reader == NULL){
+        return -1;
+    }
+    strcpy(info->dataPath,path);
+    info->format = IQ_CU8;
+    info->compressed = 1;
+    info->sampleRate = reader->sampleRate;
+    info->startTime = reader->startTime;
+    if(reader->nbChunks > 0){
+        struct captureChunkHeader header;
+        memcpy(&header,reader->map+reader->index->offset,sizeof(header));
+        info->centerFrequency = header.centerFrequency;
+    }
+    closeCaptureReader(reader);
+    return 0;
+}
+
+/*
+Fonction : openRecording
+Entrées : informations sur l'enregistrement
+Sorties : l'entrée ouverte sur les échantillons, NULL en cas d'erreur
+*/
+struct iqInput* openRecording(struct recordingInfo* info){
+    if(info->compressed){
+        return openCaptureInput(info->dataPath);
+    }
+    return openIqInputRange(info->dataPath,info->format,info->dataOffset,info->dataSize);
+}
+
+/*
+Fonction : openRecordingAsync
+Entrées : informations sur l'enregistrement
+Sorties : l'entrée ouverte pour une lecture séquentielle en avance, NULL en cas d'erreur
+*/
+struct iqInput* openRecordingAsync(struct recordingInfo* info){
+    if(info->compressed){
+        return openCaptureInput(info->dataPath);
+    }
+    return openIqInputAsync(info->dataPath,info->format,info->dataOffset,info->dataSize);
+}
+
+/*
+Fonction : findJsonValue
+Entrées : texte JSON, clé recherchée
+Sorties : le début de la valeur associée à la première occurrence de la clé, NULL si elle est absente
+Lecture minimale suffisante pour les métadonnées SigMF : pas d'analyse complète du JSON.
+*/
+const char* findJsonValue(const char* json, const char* key){
+    size_t length = strlen(key);
+    const char* position = json;
+    while((position = strchr(position,'"')) != NULL){
+        position += 1;
+        if(strncmp(position,key,length) == 0 && *(position+length) == '"'){
+            position += length+1;
+            while(*position == ' ' || *position == '\t' || *position == '\r' || *position == '\n'){
+                position += 1;
+            }
+            if(*position != ':'){
+                continue;
+            }
+            position += 1;
+            while(*position == ' ' || *position == '\t' || *position == '\r' || *position == '\n'){
+                position += 1;
+            }
+            return position;
+        }
+        // Saute la fin de la chaîne pour ne pas prendre une valeur pour une clé
+        while(*position != '\0' && *position != '"'){
+            position += *position == '\\' && *(position+1) != '\0' ? 2 : 1;
+        }
+        if(*position == '\0'){
+            return NULL;
+        }
+        position += 1;
+    }
+    return NULL;
+}
+
+/*
+Fonction : readSystemTime
+Entrées : structure SYSTEMTIME de Windows (8 entiers de 16 bits petit-boutistes : année, mois,
+jour de la semaine, jour, heure, minute, seconde, milliseconde)
+Sorties : la date en secondes depuis 1970, 0 si elle n'est pas renseignée
+La date de début du bloc auxi est écrite en UTC par SDR# et SDRuno.
+*/
+double readSystemTime(const uint8_t* input){
+    struct tm date;
+    memset(&date,0,sizeof(date));
+    date.tm_year = readLittleEndian(input,2)-1900;
+    date.tm_mon = readLittleEndian(input+2,2)-1;
+    date.tm_mday = readLittleEndian(input+6,2);
+    date.tm_hour = readLittleEndian(input+8,2);
+    date.tm_min = readLittleEndian(input+10,2);
+    date.tm_sec = readLittleEndian(input+12,2);
+    if(date.tm_year < 70 || date.tm_mon < 0 || date.tm_mon > 11 || date.tm_mday < 1 || date.tm_mday > 31){
+        return 0;
+    }
+    return (double)timegm(&date)+readLittleEndian(input+14,2)/1000.0;
+}
+
+/*
+Fonction : parseIsoDate
+Entrées : chaîne JSON contenant une date ISO 8601 en UTC ("2024-05-01T12:00:00.25Z")
+Sorties : la date en secondes depuis le 1er janvier 1970, 0 si elle n'est pas lisible
+*/
+double parseIsoDate(const char* value){
+    struct tm date;
+    double seconds;
+    memset(&date,0,sizeof(date));
+    if(sscanf(value,"\"%d-%d-%dT%d:%d:%lf",&date.tm_year,&date.tm_mon,&date.tm_mday,&date.tm_hour,&date.tm_min,&seconds) != 6){
+        return 0;
+    }
+    date.tm_year -= 1900;
+    date.tm_mon -= 1;
+    return (double)timegm(&date)+seconds;
+}
+
+int hasSuffix(const char* path, const char* suffix){
+    size_t length = strlen(path);
+    size_t suffixLength = strlen(suffix);
+    return length >= suffixLength && strcmp(path+length-suffixLength,suffix) == 0;
+}
+
+uint32_t readLittleEndian(const uint8_t* input, int size){
+    uint32_t value = 0;
+    for(int i=size-1; i>=0; i--){
+        value = (value << 8) | *(input+i);
+    }
+    return value;
+}
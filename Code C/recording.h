@@ -0,0 +1,31 @@
+#ifndef HEADER_RECORDING
+#define HEADER_RECORDING
+
+#include "iqInput.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RECORDING_PATH_SIZE 1024
+
+struct recordingInfo
+{
+    int format;
+    double sampleRate;
+    double centerFrequency;
+    long long dataOffset;
+    long long dataSize;
+    int compressed;
+    double startTime;
+    char dataPath[RECORDING_PATH_SIZE];
+};
+
+int readRecordingInfo(const char* path, struct recordingInfo* info);
+int readSigmfMeta(const char* path, struct recordingInfo* info);
+int readWavHeader(const char* path, struct recordingInfo* info);
+int readCaptureInfo(const char* path, struct recordingInfo* info);
+struct iqInput* openRecording(struct recordingInfo* info);
+struct iqInput* openRecordingAsync(struct recordingInfo* info);
+
+#endif
@@ -0,0 +1,107 @@
+#include "replay.h"
+#include <errno.h>
+#include <time.h>
+
+double replayClock();
+
+/*
+Fonction : createReplay
+Entrées : entrée IQ, fréquence d'échantillonnage de l'enregistrement, vitesse (1 temps réel, N fois plus vite,
+0 aussi vite que possible)
+Sorties : la source de relecture, NULL en cas d'erreur
+L'enregistrement est découpé comme les transferts de rtlsdr_read_async
+(DEFAULT_BUF_LENGTH octets cu8) et chaque morceau est livré à la date où la clé
+l'aurait livré, à la vitesse demandée.
+*/
+struct replay* createReplay(struct iqInput* input, double sampleRate, double speed){
+    if(sampleRate <= 0 || speed < 0){
+        return NULL;
+    }
+    struct replay* replay = (struct replay*) calloc(1,sizeof(struct replay));
+    if(replay == NULL){
+        return NULL;
+    }
+    replay->chunkSamples = DEFAULT_BUF_LENGTH/2;
+    replay->chunk = (struct complex*) malloc(replay->chunkSamples*sizeof(struct complex));
+    if(replay->chunk == NULL){
+        free(replay);
+        return NULL;
+    }
+    replay->input = input;
+    replay->sampleRate = sampleRate;
+    replay->speed = speed;
+    replay->chunkDuration = replay->chunkSamples/sampleRate;
+    return replay;
+}
+
+void freeReplay(struct replay* replay){
+    if(replay == NULL){
+        return;
+    }
+    free(replay->chunk);
+    free(replay);
+}
+
+/*
+Fonction : runReplay
+Entrées : source de relecture, fonction appelée pour chaque morceau, contexte passé à la fonction
+Sorties : le nombre de morceaux livrés
+Les dates de livraison suivent une horloge virtuelle : le retard d'un morceau ne
+décale pas les suivants. Un morceau livré plus d'une durée de transfert après sa
+date est en retard ; au-delà de DEFAULT_BUF_NUMBER transferts, la clé aurait perdu
+des échantillons. Le retard est signalé au plus une fois par seconde.
+*/
+long long runReplay(struct replay* replay, void (*callback)(struct complex*, int, void*), void* context){
+    int size;
+    replay->start = replayClock();
+    replay->lastReport = replay->start;
+    while((size = readIqSamples(replay->input,replay->chunk,replay->chunkSamples)) > 0){
+        // Complète le morceau comme un transfert USB complet
+        while(size < replay->chunkSamples){
+            int nbRead = readIqSamples(replay->input,replay->chunk+size,replay->chunkSamples-size);
+            if(nbRead == 0){
+                break;
+            }
+            size += nbRead;
+        }
+        double due = replay->start;
+        if(replay->speed > 0){
+            due += (replay->nbChunks+1)*replay->chunkDuration/replay->speed;
+            double now = replayClock();
+            if(now < due){
+                struct timespec wait;
+                wait.tv_sec = (time_t)due;
+                wait.tv_nsec = (long)((due-wait.tv_sec)*1e9);
+                while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&wait,NULL) == EINTR){
+                }
+            } else {
+                double lag = now-due;
+                double transfer = replay->chunkDuration/replay->speed;
+                if(lag > replay->maxLag){
+                    replay->maxLag = lag;
+                }
+                if(lag > transfer){
+                    replay->nbLate += 1;
+                }
+                if(lag > DEFAULT_BUF_NUMBER*transfer){
+                    replay->nbOverflows += 1;
+                }
+                if(lag > transfer && now-replay->lastReport >= 1.0){
+                    fprintf(stderr,"[REPLAY] falling behind by %.1f ms (%d transfers queued)\n",lag*1000,(int)(lag/transfer));
+                    replay->lastReport = now;
+                }
+            }
+        }
+        callback(replay->chunk,size,context);
+        replay->nbChunks += 1;
+        replay->nbSamples += size;
+    }
+    replay->elapsed = replayClock()-replay->start;
+    return replay->nbChunks;
+}
+
+double replayClock(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec+now.tv_nsec*1e-9;
+}
@@ -0,0 +1,35 @@
+#ifndef HEADER_REPLAY
+#define HEADER_REPLAY
+
+#include "complexLib.h"
+#include "iqInput.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Transferts USB de librtlsdr (rtlsdr_read_async)
+#define DEFAULT_BUF_LENGTH (16*32*512)
+#define DEFAULT_BUF_NUMBER 15
+
+struct replay
+{
+    struct iqInput* input;
+    double sampleRate;
+    double speed;
+    int chunkSamples;
+    struct complex* chunk;
+    double start;
+    double chunkDuration;
+    long long nbChunks;
+    long long nbSamples;
+    long long nbLate;
+    long long nbOverflows;
+    double maxLag;
+    double lastReport;
+    double elapsed;
+};
+
+struct replay* createReplay(struct iqInput* input, double sampleRate, double speed);
+void freeReplay(struct replay* replay);
+long long runReplay(struct replay* replay, void (*callback)(struct complex*, int, void*), void* context);
+
+#endif
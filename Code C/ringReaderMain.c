@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include "sharedRing.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+
+volatile sig_atomic_t stopped;
+
+void stopReading(int signal);
+void printMessage(struct sharedMessage* message);
+void skipToOldest(struct sharedRing* ring);
+
+/*
+Lecteur de l'anneau en mémoire partagée publié par main -m : affiche chaque message
+décodé jusqu'à la fermeture de l'anneau par le récepteur ou une interruption, puis
+le nombre de messages perdus parce que le lecteur a été dépassé. Un anneau déjà
+fermé est lu à partir de son plus ancien message avec -a, sinon le lecteur attend
+la prochaine exécution du récepteur.
+*/
+int main(int argc, char** argv)
+{
+   int option;
+   int oldest = 0;
+   int delay = 0;
+   while((option = getopt(argc, argv, "ad:")) != -1){
+      switch(option){
+      case 'a':
+         oldest = 1;
+         break;
+      case 'd':
+         // attente après chaque message en microsecondes, pour simuler un lecteur lent
+         delay = atoi(optarg);
+         break;
+      default:
+         fprintf(stderr, "Usage : %s [-a] [-d delay] name\n", argv[0]);
+         return(1);
+      }
+   }
+   if(optind >= argc){
+      fprintf(stderr, "Usage : %s [-a] [-d delay] name\n", argv[0]);
+      return(1);
+   }
+   struct sharedRing *ring = attachSharedRing(argv[optind]);
+   if(ring == NULL){
+      fprintf(stderr, "Cannot attach shared memory ring %s\n", argv[optind]);
+      return(1);
+   }
+   if(oldest){
+      skipToOldest(ring);
+   }
+   int waiting = atomic_load(&ring->header->closed) != SHARED_OPEN && !oldest;
+   signal(SIGINT, stopReading);
+   signal(SIGTERM, stopReading);
+
+   struct sharedMessage message;
+   long long nbRead = 0, nbLost = 0, nbOverruns = 0;
+   while(!stopped){
+      int status = readSharedMessage(ring, &message);
+      if(status > 0){
+         printMessage(&message);
+         nbRead += 1;
+         waiting = 0;
+         if(delay > 0){
+            usleep(delay);
+         }
+         continue;
+      }
+      if(status < 0){
+         fflush(stdout);
+         fprintf(stderr, "[LOST] %lld messages lost so far\n", nbLost+ring->nbLost);
+         continue;
+      }
+      int closed = atomic_load(&ring->header->closed);
+      if(closed == SHARED_RETIRED){
+         // Le récepteur a recréé l'anneau avec une autre taille
+         nbLost += ring->nbLost;
+         nbOverruns += ring->nbOverruns;
+         detachSharedRing(ring);
+         while((ring = attachSharedRing(argv[optind])) == NULL || atomic_load(&ring->header->closed) == SHARED_RETIRED){
+            detachSharedRing(ring);
+            ring = NULL;
+            if(stopped){
+               break;
+            }
+            usleep(100000);
+         }
+         if(ring == NULL){
+            break;
+         }
+         skipToOldest(ring);
+         waiting = 0;
+      } else if(closed == SHARED_CLOSED && !waiting){
+         if(atomic_load(&ring->header->head) == ring->next){
+            break;
+         }
+      } else {
+         waiting = waiting && closed != SHARED_OPEN;
+         fflush(stdout);
+         waitSharedRing(ring, 100);
+      }
+   }
+   fflush(stdout);
+   if(ring != NULL){
+      nbLost += ring->nbLost;
+      nbOverruns += ring->nbOverruns;
+   }
+   fprintf(stderr, "%lld messages read, %lld lost in %lld overruns\n", nbRead, nbLost, nbOverruns);
+   detachSharedRing(ring);
+   return(0);
+}
+
+void stopReading(int signal)
+{
+   (void)signal;
+   stopped = 1;
+}
+
+/*
+Fonction : skipToOldest
+Entrées : anneau ouvert en lecture
+Sorties :
+Place le lecteur sur le plus ancien message encore retenu.
+*/
+void skipToOldest(struct sharedRing* ring)
+{
+   uint64_t head = atomic_load(&ring->header->head);
+   ring->next = head > ring->mask ? head-ring->mask : 0;
+}
+
+void printMessage(struct sharedMessage* message)
+{
+   printf("%llu %.6f %c type %d mmsi %u", (unsigned long long)message->sequence, message->timestamp, message->channel, message->messageType, message->mmsi);
+   if(message->hasPosition){
+      printf(" lat %f long %f course %f", message->latitude, message->longitude, message->course);
+   }
+   printf(" ");
+   for(int i = 0; i < message->nbBits; i++){
+      putchar('0'+((*(message->payload+i/8) >> (7-i%8)) & 1));
+   }
+   putchar('\n');
+}
@@ -0,0 +1,544 @@
+#include <stdio.h>
+#include "benchmark.h"
+#include "traffic.h"
+#include "receiver.h"
+#include "recording.h"
+#include "aisdecode.h"
+#include "pipeline.h"
+#include "parallel.h"
+#include "batch.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_STREAMS 256
+#define MAX_THREADS 256
+
+#define SCALING_ROUND 0
+#define SCALING_PIPELINE 1
+#define SCALING_PARALLEL 2
+#define SCALING_BATCH 3
+
+struct scalingStream
+{
+   struct complex *samples;
+   long long nbSamples;
+   double sampleRate;
+   double centerFrequency;
+   char path[RECORDING_PATH_SIZE];
+   struct recordingInfo info;
+};
+
+struct scalingTask
+{
+   struct scalingStream *stream;
+   double channelFrequency;
+   struct receiver *rx;
+   long long position;
+   long long nbFrames;
+   double finished;
+};
+
+struct scalingThread
+{
+   pthread_t thread;
+   int index;
+   double *latencies;
+   int nbLatencies;
+};
+
+struct scalingBatch
+{
+   struct batchRun *batch;
+   int channel;
+   int stream;
+};
+
+const char* scalingModeNames[] = {"round", "pipeline", "parallel", "batch"};
+
+struct scalingStream streams[MAX_STREAMS];
+struct scalingTask *tasks;
+int nbTasks, nbStreams, nbChannels, nbThreads, blockSize;
+char directory[] = "/tmp/scalingXXXXXX";
+char listPath[RECORDING_PATH_SIZE];
+atomic_int nextTask;
+double runStart;
+
+int generateStream(struct scalingStream* stream, int nbVessels, double duration, double sampleRate, uint64_t seed);
+int loadStream(struct scalingStream* stream, const char* path, double duration, double sampleRate);
+void* runScalingThread(void* argument);
+void countFrame(int* frame, int size, long long bitIndex, void* context);
+int writeStreamFiles();
+void removeStreamFiles();
+int runFileMode(int mode);
+void* runPipelineTasks(void* argument);
+void startScalingFile(struct batchFile* file, void* context);
+void countBatchFrame(int* frame, int size, long long bitIndex, void* context);
+
+/*
+Mesure de bout en bout : N flux (trafic synthétique généré en mémoire, ou
+enregistrements rejoués depuis la mémoire) passent par le récepteur complet, une ou
+deux voies par flux, avec 1 à K fils. Chaque couple (flux, voie) est confié à un fil
+qui traite ses flux bloc par bloc, tour à tour, comme s'ils arrivaient ensemble :
+la latence d'un bloc est le temps écoulé entre le début du tour et la fin de son
+traitement. Pour chaque nombre de fils, une ligne CSV donne le débit total,
+le facteur temps réel (durée d'un flux / durée du traitement), les trames par
+seconde et les latences médiane et à 99 %.
+Avec -m, les mêmes flux sont écrits en SigMF dans un dossier temporaire puis passent
+par les traitements de fichiers de main : une chaîne d'étages par couple (flux,
+voie), autant de chaînes à la fois que de fils (pipeline, comme -P), chaque couple
+découpé en morceaux entre les fils (parallel, comme -j) ou un lot par voie réparti
+entre les fils (batch, comme -B). La latence est alors le temps écoulé entre le
+début de la mesure et la dernière trame de chaque couple.
+*/
+int main(int argc, char** argv)
+{
+   int option;
+   int mode = SCALING_ROUND;
+   int maxThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   nbStreams = 4;
+   nbChannels = 2;
+   int nbVessels = 200;
+   double duration = 10;
+   double sampleRate = 288000;
+   blockSize = 65536;
+   while((option = getopt(argc, argv, "b:c:d:j:m:n:s:v:")) != -1){
+      switch(option){
+      case 'b':
+         blockSize = atoi(optarg);
+         break;
+      case 'c':
+         nbChannels = atoi(optarg);
+         break;
+      case 'd':
+         duration = atof(optarg);
+         break;
+      case 'j':
+         maxThreads = atoi(optarg);
+         break;
+      case 'm':
+         mode = -1;
+         for(int i = 0; i <= SCALING_BATCH; i++){
+            if(strcmp(optarg, scalingModeNames[i]) == 0){
+               mode = i;
+            }
+         }
+         break;
+      case 'n':
+         nbStreams = atoi(optarg);
+         break;
+      case 's':
+         sampleRate = atof(optarg);
+         break;
+      case 'v':
+         nbVessels = atoi(optarg);
+         break;
+      default:
+         fprintf(stderr, "Usage : %s [-m round|pipeline|parallel|batch] [-n streams] [-j max threads] [-c 1|2 channels] [-d duration] [-s sample rate] [-v vessels] [-b block size] [recording...]\n", argv[0]);
+         return(1);
+      }
+   }
+   if(mode < 0 || nbStreams < 1 || nbStreams > MAX_STREAMS || maxThreads < 1 || maxThreads > MAX_THREADS || nbChannels < 1 || nbChannels > 2 || blockSize < 1){
+      fprintf(stderr, "Invalid option (mode round, pipeline, parallel or batch, at most %d streams and %d threads, 1 or 2 channels)\n", MAX_STREAMS, MAX_THREADS);
+      return(1);
+   }
+   // Les enregistrements donnés sont répartis tour à tour entre les flux
+   double streamDuration = 0;
+   for(int s = 0; s < nbStreams; s++){
+      int status = optind < argc ? loadStream(streams+s, argv[optind+s%(argc-optind)], duration, sampleRate)
+         : generateStream(streams+s, nbVessels, duration, sampleRate, s+1);
+      if(status < 0){
+         fprintf(stderr, "Cannot prepare stream %d\n", s);
+         return(1);
+      }
+      double length = streams[s].nbSamples/streams[s].sampleRate;
+      streamDuration = length > streamDuration ? length : streamDuration;
+   }
+   long long nbSamples = 0;
+   for(int s = 0; s < nbStreams; s++){
+      nbSamples += streams[s].nbSamples;
+   }
+   fprintf(stderr, "%d streams of %.1f s, %d channels each\n", nbStreams, streamDuration, nbChannels);
+   if(mode != SCALING_ROUND && writeStreamFiles() < 0){
+      fprintf(stderr, "Cannot write the streams to %s\n", directory);
+      removeStreamFiles();
+      return(1);
+   }
+
+   nbTasks = nbStreams*nbChannels;
+   tasks = (struct scalingTask*) calloc(nbTasks, sizeof(struct scalingTask));
+   struct scalingThread *threads = (struct scalingThread*) calloc(maxThreads, sizeof(struct scalingThread));
+   if(tasks == NULL || threads == NULL){
+      return(1);
+   }
+   printf("mode,threads,streams,channels,msamples_per_s,realtime_factor,frames_per_s,latency_p50_ms,latency_p99_ms\n");
+   for(nbThreads = 1; nbThreads <= maxThreads; nbThreads++){
+      for(int t = 0; t < nbTasks; t++){
+         struct scalingTask *task = tasks+t;
+         task->stream = streams+t/nbChannels;
+         task->channelFrequency = t%nbChannels == 0 ? CHANNEL_A_FREQUENCY : CHANNEL_B_FREQUENCY;
+         task->rx = createChannelReceiver(task->stream->sampleRate, task->channelFrequency-task->stream->centerFrequency, countFrame, task);
+         task->position = 0;
+         task->nbFrames = 0;
+         if(task->rx == NULL){
+            fprintf(stderr, "Cannot create the receivers\n");
+            return(1);
+         }
+      }
+      double start = benchmarkTime();
+      int nbStarted = 0;
+      if(mode == SCALING_ROUND){
+         for(int i = 0; i < nbThreads; i++){
+            threads[i].index = i;
+            threads[i].nbLatencies = 0;
+            if(pthread_create(&threads[i].thread, NULL, runScalingThread, threads+i) == 0){
+               nbStarted += 1;
+            }
+         }
+         for(int i = 0; i < nbStarted; i++){
+            pthread_join(threads[i].thread, NULL);
+         }
+      } else if(runFileMode(mode) == 0){
+         nbStarted = nbThreads;
+      }
+      double elapsed = benchmarkTime()-start;
+      if(nbStarted < nbThreads){
+         fprintf(stderr, mode == SCALING_ROUND ? "Cannot start %d threads\n" : "Cannot run the files with %d threads\n", nbThreads);
+         removeStreamFiles();
+         return(1);
+      }
+
+      long long nbFrames = 0;
+      int nbLatencies = 0;
+      for(int t = 0; t < nbTasks; t++){
+         nbFrames += tasks[t].nbFrames;
+         freeChannelizer(tasks[t].rx->channelizer);
+         freeReceiver(tasks[t].rx);
+      }
+      for(int i = 0; i < nbStarted && mode == SCALING_ROUND; i++){
+         nbLatencies += threads[i].nbLatencies;
+      }
+      // Hors du mode tour à tour, une latence par couple (flux, voie)
+      double *latencies = (double*) malloc((nbLatencies > nbTasks ? nbLatencies : nbTasks)*sizeof(double));
+      if(latencies == NULL){
+         return(1);
+      }
+      nbLatencies = 0;
+      for(int i = 0; i < nbStarted && mode == SCALING_ROUND; i++){
+         memcpy(latencies+nbLatencies, threads[i].latencies, threads[i].nbLatencies*sizeof(double));
+         nbLatencies += threads[i].nbLatencies;
+         free(threads[i].latencies);
+      }
+      for(int t = 0; t < nbTasks && mode != SCALING_ROUND; t++){
+         latencies[nbLatencies++] = tasks[t].finished;
+      }
+      double p50 = percentile(latencies, nbLatencies, 0.5);
+      double p99 = percentile(latencies, nbLatencies, 0.99);
+      free(latencies);
+      printf("%s,%d,%d,%d,%.3f,%.2f,%.1f,%.3f,%.3f\n", scalingModeNames[mode], nbThreads, nbStreams, nbChannels, nbSamples/elapsed/1e6,
+         streamDuration/elapsed, nbFrames/elapsed, p50*1e3, p99*1e3);
+      fflush(stdout);
+   }
+   for(int s = 0; s < nbStreams; s++){
+      free(streams[s].samples);
+   }
+   if(mode != SCALING_ROUND){
+      removeStreamFiles();
+   }
+   free(tasks);
+   free(threads);
+   return(0);
+}
+
+/*
+Fonction : runScalingThread
+Entrées : fil (ses tâches sont celles dont l'indice modulo nbThreads est le sien)
+Sorties : NULL
+À chaque tour, un bloc de chaque tâche non terminée est traité ; la fin du flux est
+vidée dans le récepteur avec le dernier bloc.
+*/
+void* runScalingThread(void* argument)
+{
+   struct scalingThread *thread = (struct scalingThread*) argument;
+   int maxLatencies = 0;
+   for(int t = thread->index; t < nbTasks; t += nbThreads){
+      maxLatencies += (tasks[t].stream->nbSamples+blockSize-1)/blockSize;
+   }
+   thread->latencies = (double*) malloc((maxLatencies > 0 ? maxLatencies : 1)*sizeof(double));
+   if(thread->latencies == NULL){
+      return NULL;
+   }
+   int active = 1;
+   while(active){
+      active = 0;
+      double round = benchmarkTime();
+      for(int t = thread->index; t < nbTasks; t += nbThreads){
+         struct scalingTask *task = tasks+t;
+         long long remaining = task->stream->nbSamples-task->position;
+         if(remaining <= 0){
+            continue;
+         }
+         int size = remaining < blockSize ? remaining : blockSize;
+         processInputSamples(task->rx, task->stream->samples+task->position, size);
+         task->position += size;
+         if(task->position == task->stream->nbSamples){
+            flushReceiver(task->rx);
+         }
+         thread->latencies[thread->nbLatencies++] = benchmarkTime()-round;
+         active = 1;
+      }
+   }
+   return NULL;
+}
+
+/*
+Fonction : countFrame
+Entrées : trame, taille, indice du premier bit, tâche
+Sorties :
+Décode le rapport de position comme le ferait la sortie texte et compte la trame.
+*/
+void countFrame(int* frame, int size, long long bitIndex, void* context)
+{
+   struct scalingTask *task = (struct scalingTask*) context;
+   struct aisMessage message;
+   (void)bitIndex;
+   decodePositionReport(frame, size, 0, &message);
+   task->nbFrames += 1;
+}
+
+/*
+Fonction : runFileMode
+Entrées : mode (pipeline, parallel ou batch)
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+Traite les fichiers des flux avec nbThreads fils et note pour chaque tâche le temps
+écoulé jusqu'à sa dernière trame.
+*/
+int runFileMode(int mode)
+{
+   runStart = benchmarkTime();
+   if(mode == SCALING_PIPELINE){
+      pthread_t runners[MAX_THREADS];
+      int nbStarted = 0;
+      atomic_store(&nextTask, 0);
+      for(int i = 0; i < nbThreads && i < nbTasks; i++){
+         if(pthread_create(runners+nbStarted, NULL, runPipelineTasks, NULL) == 0){
+            nbStarted += 1;
+         }
+      }
+      int status = 0;
+      for(int i = 0; i < nbStarted; i++){
+         void *result;
+         pthread_join(runners[i], &result);
+         status |= result != NULL ? -1 : 0;
+      }
+      return nbStarted > 0 ? status : -1;
+   }
+   if(mode == SCALING_PARALLEL){
+      for(int t = 0; t < nbTasks; t++){
+         if(processRecordingParallel(&tasks[t].stream->info, tasks[t].rx, nbThreads) < 0){
+            return -1;
+         }
+         tasks[t].finished = benchmarkTime()-runStart;
+      }
+      return 0;
+   }
+   // Un lot par voie, les flux dans l'ordre de la liste
+   for(int c = 0; c < nbChannels; c++){
+      struct scalingBatch context;
+      context.channel = c;
+      context.stream = -1;
+      context.batch = createBatch(listPath, -1, 0, 0, c == 0 ? CHANNEL_A_FREQUENCY : CHANNEL_B_FREQUENCY);
+      if(context.batch == NULL || context.batch->nbFiles != nbStreams){
+         freeBatch(context.batch);
+         return -1;
+      }
+      int nbFrames = runBatch(context.batch, nbThreads, startScalingFile, countBatchFrame, &context);
+      int nbFailed = context.batch->nbFailed;
+      freeBatch(context.batch);
+      if(nbFrames < 0 || nbFailed > 0){
+         return -1;
+      }
+      if(context.stream >= 0){
+         tasks[context.stream*nbChannels+c].finished = benchmarkTime()-runStart;
+      }
+   }
+   return 0;
+}
+
+/*
+Fonction : runPipelineTasks
+Entrées : 
+Sorties : NULL en cas de succès, une valeur non nulle si une chaîne n'a pas pu tourner
+Prend les tâches une à une et fait passer chacune par sa propre chaîne d'étages.
+*/
+void* runPipelineTasks(void* argument)
+{
+   int t;
+   (void)argument;
+   while((t = atomic_fetch_add(&nextTask, 1)) < nbTasks){
+      struct scalingTask *task = tasks+t;
+      struct iqInput *input = openRecording(&task->stream->info);
+      struct pipeline *stages = input != NULL ? createPipeline(task->rx, input, NULL, -1) : NULL;
+      int status = stages != NULL ? runPipeline(stages) : -1;
+      freePipeline(stages);
+      closeIqInput(input);
+      if(status < 0){
+         return task;
+      }
+      task->finished = benchmarkTime()-runStart;
+   }
+   return NULL;
+}
+
+/*
+Fonction : startScalingFile
+Entrées : fichier dont les trames vont être rendues, lot en cours
+Sorties :
+Les trames sont rendues dans l'ordre des fichiers : le fichier précédent est terminé.
+*/
+void startScalingFile(struct batchFile* file, void* context)
+{
+   struct scalingBatch *run = (struct scalingBatch*) context;
+   if(run->stream >= 0){
+      tasks[run->stream*nbChannels+run->channel].finished = benchmarkTime()-runStart;
+   }
+   run->stream = (int)(file-run->batch->files);
+}
+
+void countBatchFrame(int* frame, int size, long long bitIndex, void* context)
+{
+   struct scalingBatch *run = (struct scalingBatch*) context;
+   countFrame(frame, size, bitIndex, tasks+run->stream*nbChannels+run->channel);
+}
+
+/*
+Fonction : writeStreamFiles
+Entrées :
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+Écrit chaque flux en cf32 avec ses métadonnées SigMF dans un dossier temporaire,
+ainsi que la liste des fichiers pour le lot. Les fichiers viennent d'être écrits et
+restent en cache : comme en mémoire, le disque pèse peu sur le débit mesuré.
+*/
+int writeStreamFiles()
+{
+   if(mkdtemp(directory) == NULL){
+      return -1;
+   }
+   snprintf(listPath, sizeof(listPath), "%s/streams.txt", directory);
+   FILE *list = fopen(listPath, "w");
+   if(list == NULL){
+      return -1;
+   }
+   for(int s = 0; s < nbStreams; s++){
+      struct scalingStream *stream = streams+s;
+      char metaPath[RECORDING_PATH_SIZE];
+      snprintf(stream->path, sizeof(stream->path), "%s/stream%03d.sigmf-data", directory, s);
+      snprintf(metaPath, sizeof(metaPath), "%s/stream%03d.sigmf-meta", directory, s);
+      FILE *data = fopen(stream->path, "wb");
+      FILE *meta = fopen(metaPath, "w");
+      int status = data != NULL && meta != NULL ? 0 : -1;
+      if(status == 0 && fwrite(stream->samples, sizeof(struct complex), stream->nbSamples, data) != (size_t)stream->nbSamples){
+         status = -1;
+      }
+      if(meta != NULL){
+         fprintf(meta, "{\n  \"global\": {\"core:datatype\": \"cf32_le\", \"core:sample_rate\": %.0f, \"core:version\": \"1.0.0\"},\n", stream->sampleRate);
+         fprintf(meta, "  \"captures\": [{\"core:sample_start\": 0, \"core:frequency\": %.0f}],\n  \"annotations\": []\n}\n", stream->centerFrequency);
+      }
+      if((data != NULL && fclose(data) != 0) || (meta != NULL && fclose(meta) != 0) || status < 0
+         || readRecordingInfo(stream->path, &stream->info) < 0){
+         fclose(list);
+         return -1;
+      }
+      fprintf(list, "%s\n", stream->path);
+   }
+   return fclose(list) == 0 ? 0 : -1;
+}
+
+/*
+Fonction : removeStreamFiles
+Entrées :
+Sorties :
+Efface le dossier temporaire et ce qu'y a écrit writeStreamFiles.
+*/
+void removeStreamFiles()
+{
+   char path[RECORDING_PATH_SIZE];
+   if(strcmp(directory+strlen(directory)-6, "XXXXXX") == 0){
+      return;
+   }
+   for(int s = 0; s < nbStreams; s++){
+      unlink(streams[s].path);
+      snprintf(path, sizeof(path), "%s/stream%03d.sigmf-meta", directory, s);
+      unlink(path);
+   }
+   unlink(listPath);
+   rmdir(directory);
+}
+
+/*
+Fonction : generateStream
+Entrées : flux à remplir, nombre de navires, durée (s), fréquence d'échantillonnage, graine
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+*/
+int generateStream(struct scalingStream* stream, int nbVessels, double duration, double sampleRate, uint64_t seed)
+{
+   struct trafficGenerator *traffic = createTrafficGenerator(nbVessels, sampleRate, 5, 30, 500, seed);
+   stream->nbSamples = llround(duration*sampleRate);
+   stream->sampleRate = sampleRate;
+   stream->centerFrequency = TRAFFIC_CENTER_FREQUENCY;
+   stream->samples = (struct complex*) malloc((stream->nbSamples > 0 ? stream->nbSamples : 1)*sizeof(struct complex));
+   if(traffic == NULL || stream->samples == NULL || stream->nbSamples <= 0){
+      freeTrafficGenerator(traffic);
+      return -1;
+   }
+   for(long long position = 0; position < stream->nbSamples; position += blockSize){
+      int size = stream->nbSamples-position < blockSize ? stream->nbSamples-position : blockSize;
+      if(generateTraffic(traffic, stream->samples+position, size) < 0){
+         freeTrafficGenerator(traffic);
+         return -1;
+      }
+      // Même échelle que l'entrée cu8 convertie par iqInput
+      for(int i = 0; i < size; i++){
+         struct complex *sample = stream->samples+position+i;
+         sample->real = fmaxf(-127.5f, fminf(127.5f, sample->real));
+         sample->imag = fmaxf(-127.5f, fminf(127.5f, sample->imag));
+      }
+   }
+   freeTrafficGenerator(traffic);
+   return 0;
+}
+
+/*
+Fonction : loadStream
+Entrées : flux à remplir, chemin de l'enregistrement, durée maximale (s), fréquence d'échantillonnage
+(0 ou celle des métadonnées)
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+L'enregistrement est lu entièrement en mémoire avant la mesure : le disque n'entre
+pas dans le débit mesuré.
+*/
+int loadStream(struct scalingStream* stream, const char* path, double duration, double sampleRate)
+{
+   struct recordingInfo info;
+   if(readRecordingInfo(path, &info) < 0){
+      return -1;
+   }
+   stream->sampleRate = info.sampleRate > 0 ? info.sampleRate : sampleRate;
+   stream->centerFrequency = info.centerFrequency > 0 ? info.centerFrequency : TRAFFIC_CENTER_FREQUENCY;
+   long long maxSamples = llround(duration*stream->sampleRate);
+   struct iqInput *input = openRecording(&info);
+   stream->samples = (struct complex*) malloc((maxSamples > 0 ? maxSamples : 1)*sizeof(struct complex));
+   if(input == NULL || stream->samples == NULL){
+      closeIqInput(input);
+      return -1;
+   }
+   stream->nbSamples = 0;
+   int size;
+   while(stream->nbSamples < maxSamples && (size = readIqSamples(input, stream->samples+stream->nbSamples,
+         maxSamples-stream->nbSamples < RAW_BLOCK_SIZE ? maxSamples-stream->nbSamples : RAW_BLOCK_SIZE)) > 0){
+      stream->nbSamples += size;
+   }
+   closeIqInput(input);
+   return stream->nbSamples > 0 ? 0 : -1;
+}
@@ -0,0 +1,292 @@
+#include "sharedRing.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+struct sharedRing* mapSharedRing(int fd, size_t size);
+size_t sharedRingSize(int nbSlots);
+void retireSharedRing(int fd, size_t size);
+
+/*
+Fonction : createSharedRing
+Entrées : nom de la mémoire partagée (par exemple /ais), nombre de messages retenus (arrondi à la puissance de deux supérieure)
+Sorties : l'anneau ouvert en écriture, NULL en cas d'erreur
+Les messages décodés sont publiés dans un anneau en mémoire partagée POSIX que
+d'autres processus lisent sans verrou. Un anneau existant de même taille est repris
+là où il s'était arrêté, pour que ses lecteurs n'aient pas à se rattacher ; un anneau
+d'une autre taille est remplacé par un nouvel objet, l'ancien restant valide pour les
+lecteurs qui l'ont projeté.
+*/
+struct sharedRing* createSharedRing(const char* name, int nbSlots){
+    int size = 2;
+    while(size < nbSlots){
+        size *= 2;
+    }
+    int fd = shm_open(name,O_RDWR|O_CREAT,0644);
+    if(fd < 0){
+        return NULL;
+    }
+    struct stat status;
+    if(fstat(fd,&status) < 0){
+        close(fd);
+        return NULL;
+    }
+    if(status.st_size != 0 && (size_t)status.st_size != sharedRingSize(size)){
+        shm_unlink(name);
+        retireSharedRing(fd,status.st_size);
+        close(fd);
+        fd = shm_open(name,O_RDWR|O_CREAT|O_EXCL,0644);
+        if(fd < 0){
+            return NULL;
+        }
+        status.st_size = 0;
+    }
+    int reuse = status.st_size != 0;
+    if(!reuse && ftruncate(fd,sharedRingSize(size)) < 0){
+        close(fd);
+        return NULL;
+    }
+    struct sharedRing* ring = mapSharedRing(fd,sharedRingSize(size));
+    close(fd);
+    if(ring == NULL){
+        return NULL;
+    }
+    struct sharedRingHeader* header = ring->header;
+    if(!reuse || memcmp(header->magic,SHARED_RING_MAGIC,8) != 0 || header->nbSlots != (uint32_t)size || header->slotSize != sizeof(struct sharedSlot)){
+        // Les lecteurs ne s'attachent qu'une fois la signature écrite
+        memset(header->magic,0,8);
+        atomic_thread_fence(memory_order_release);
+        header->nbSlots = size;
+        header->slotSize = sizeof(struct sharedSlot);
+        atomic_store(&header->head,0);
+        for(int i=0; i<size; i++){
+            atomic_store_explicit(&(ring->slots+i)->stamp,0,memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_release);
+        memcpy(header->magic,SHARED_RING_MAGIC,8);
+    }
+    atomic_store(&header->closed,SHARED_OPEN);
+    ring->mask = size-1;
+    ring->next = atomic_load(&header->head);
+    return ring;
+}
+
+/*
+Fonction : closeSharedRing
+Entrées : anneau ouvert en écriture
+Sorties : 0
+Marque l'anneau comme terminé et réveille les lecteurs. La mémoire partagée n'est
+pas supprimée : les derniers messages restent lisibles jusqu'au prochain démarrage.
+*/
+int closeSharedRing(struct sharedRing* ring){
+    if(ring == NULL){
+        return 0;
+    }
+    if(atomic_load(&ring->header->closed) == SHARED_OPEN){
+        atomic_store(&ring->header->closed,SHARED_CLOSED);
+    }
+    atomic_fetch_add(&ring->header->wake,1);
+    syscall(SYS_futex,&ring->header->wake,FUTEX_WAKE,INT_MAX,NULL,NULL,0);
+    detachSharedRing(ring);
+    return 0;
+}
+
+/*
+Fonction : retireSharedRing
+Entrées : descripteur de l'ancien objet, taille de l'ancien objet
+Sorties :
+Marque l'anneau qui va être remplacé pour que ses lecteurs se rattachent au nouveau.
+*/
+void retireSharedRing(int fd, size_t size){
+    if(size < sizeof(struct sharedRingHeader)){
+        return;
+    }
+    struct sharedRing* old = mapSharedRing(fd,size);
+    if(old == NULL){
+        return;
+    }
+    if(memcmp(old->header->magic,SHARED_RING_MAGIC,8) == 0){
+        atomic_store(&old->header->closed,SHARED_RETIRED);
+        closeSharedRing(old);
+    } else {
+        detachSharedRing(old);
+    }
+}
+
+/*
+Fonction : publishSharedMessage
+Entrées : anneau, bits de la trame, nombre de bits, indice du bit de début, date de la trame, voie AIS, message décodé (NULL si ce n'est pas un rapport de position)
+Sorties :
+Le rédacteur n'attend jamais ses lecteurs : il écrase le plus ancien message. Le
+tampon de l'emplacement est marqué occupé pendant la copie puis reçoit le numéro
+du message, ce qui permet à un lecteur trop lent de détecter qu'il a été dépassé.
+Un appel système n'est fait que si un lecteur dort.
+*/
+void publishSharedMessage(struct sharedRing* ring, int* bits, int nbBits, long long bitIndex, double timestamp, char channel, struct aisMessage* message){
+    struct sharedRingHeader* header = ring->header;
+    uint64_t sequence = ring->next;
+    struct sharedSlot* slot = ring->slots+(sequence & ring->mask);
+    atomic_store_explicit(&slot->stamp,SHARED_BUSY,memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    struct sharedMessage* shared = &slot->message;
+    if(nbBits > SHARED_PAYLOAD_BYTES*8){
+        nbBits = SHARED_PAYLOAD_BYTES*8;
+    }
+    shared->sequence = sequence;
+    shared->timestamp = timestamp;
+    shared->bitIndex = bitIndex;
+    shared->messageType = nbBits >= 6 ? getFromMessage(bits,0,6) : 0;
+    shared->mmsi = nbBits >= 38 ? getUnsignedFromMessage(bits,8,38) : 0;
+    shared->hasPosition = message != NULL;
+    shared->latitude = message != NULL ? message->latitude : 0;
+    shared->longitude = message != NULL ? message->longitude : 0;
+    shared->course = message != NULL ? message->course : 0;
+    shared->nbBits = nbBits;
+    shared->channel = channel;
+    shared->reserved = 0;
+    memset(shared->payload,0,(nbBits+7)/8);
+    for(int i=0; i<nbBits; i++){
+        *(shared->payload+i/8) |= (*(bits+i) != 0) << (7-i%8);
+    }
+
+    atomic_store_explicit(&slot->stamp,sequence+1,memory_order_release);
+    ring->next = sequence+1;
+    atomic_store(&header->head,sequence+1);
+    atomic_fetch_add(&header->wake,1);
+    if(atomic_load(&header->nbWaiters) > 0){
+        syscall(SYS_futex,&header->wake,FUTEX_WAKE,INT_MAX,NULL,NULL,0);
+    }
+}
+
+/*
+Fonction : attachSharedRing
+Entrées : nom de la mémoire partagée
+Sorties : l'anneau ouvert en lecture, NULL s'il n'existe pas ou n'est pas initialisé
+La lecture commence au prochain message publié.
+*/
+struct sharedRing* attachSharedRing(const char* name){
+    int fd = shm_open(name,O_RDWR,0);
+    if(fd < 0){
+        return NULL;
+    }
+    struct stat status;
+    if(fstat(fd,&status) < 0 || (size_t)status.st_size < sharedRingSize(2)){
+        close(fd);
+        return NULL;
+    }
+    struct sharedRing* ring = mapSharedRing(fd,status.st_size);
+    close(fd);
+    if(ring == NULL){
+        return NULL;
+    }
+    struct sharedRingHeader* header = ring->header;
+    if(memcmp(header->magic,SHARED_RING_MAGIC,8) != 0 || header->slotSize != sizeof(struct sharedSlot)
+            || sharedRingSize(header->nbSlots) != ring->size){
+        detachSharedRing(ring);
+        return NULL;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    ring->mask = header->nbSlots-1;
+    ring->next = atomic_load(&header->head);
+    return ring;
+}
+
+void detachSharedRing(struct sharedRing* ring){
+    if(ring == NULL){
+        return;
+    }
+    munmap(ring->header,ring->size);
+    free(ring);
+}
+
+/*
+Fonction : readSharedMessage
+Entrées : anneau ouvert en lecture, message à remplir
+Sorties : 1 si un message a été lu, 0 s'il n'y en a pas de nouveau, -1 si le lecteur a été dépassé
+Lecture sans verrou : le message est copié puis le numéro de l'emplacement est relu ;
+s'il a changé pendant la copie, le rédacteur l'a réécrit. Un lecteur dépassé compte
+les messages perdus et repart à mi-anneau derrière le rédacteur.
+*/
+int readSharedMessage(struct sharedRing* ring, struct sharedMessage* message){
+    struct sharedRingHeader* header = ring->header;
+    uint64_t head = atomic_load_explicit(&header->head,memory_order_acquire);
+    if(ring->next == head){
+        return 0;
+    }
+    if(ring->next > head){
+        // Le rédacteur a recréé l'anneau
+        ring->next = head;
+        return 0;
+    }
+    if(head-ring->next <= ring->mask){
+        struct sharedSlot* slot = ring->slots+(ring->next & ring->mask);
+        uint64_t stamp = atomic_load_explicit(&slot->stamp,memory_order_acquire);
+        if(stamp == ring->next+1){
+            memcpy(message,&slot->message,sizeof(struct sharedMessage));
+            atomic_thread_fence(memory_order_acquire);
+            if(atomic_load_explicit(&slot->stamp,memory_order_relaxed) == stamp){
+                ring->next += 1;
+                return 1;
+            }
+        }
+        head = atomic_load_explicit(&header->head,memory_order_acquire);
+    }
+    uint64_t next = head-(ring->mask+1)/2;
+    ring->nbLost += next-ring->next;
+    ring->nbOverruns += 1;
+    ring->next = next;
+    return -1;
+}
+
+/*
+Fonction : waitSharedRing
+Entrées : anneau ouvert en lecture, attente maximale en millisecondes
+Sorties : 1 si un message est disponible, 0 sinon (attente écoulée ou anneau fermé entre-temps)
+L'attente tourne d'abord quelques tours puis dort sur le compteur de réveil. Le
+compteur est lu avant la tête : une publication entre les deux le fait changer et
+l'attente se termine aussitôt.
+*/
+int waitSharedRing(struct sharedRing* ring, int timeout){
+    struct sharedRingHeader* header = ring->header;
+    for(int spin=0; spin<SHARED_SPIN; spin++){
+        if(atomic_load_explicit(&header->head,memory_order_acquire) != ring->next){
+            return 1;
+        }
+    }
+    struct timespec delay;
+    delay.tv_sec = timeout/1000;
+    delay.tv_nsec = (long)(timeout%1000)*1000000;
+    atomic_fetch_add(&header->nbWaiters,1);
+    uint32_t wake = atomic_load(&header->wake);
+    if(atomic_load(&header->head) == ring->next){
+        syscall(SYS_futex,&header->wake,FUTEX_WAIT,wake,&delay,NULL,0);
+    }
+    atomic_fetch_sub(&header->nbWaiters,1);
+    return atomic_load_explicit(&header->head,memory_order_acquire) != ring->next;
+}
+
+struct sharedRing* mapSharedRing(int fd, size_t size){
+    struct sharedRing* ring = (struct sharedRing*) calloc(1,sizeof(struct sharedRing));
+    if(ring == NULL){
+        return NULL;
+    }
+    void* map = mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    if(map == MAP_FAILED){
+        free(ring);
+        return NULL;
+    }
+    ring->header = (struct sharedRingHeader*) map;
+    ring->slots = (struct sharedSlot*) ((char*)map+sizeof(struct sharedRingHeader));
+    ring->size = size;
+    return ring;
+}
+
+size_t sharedRingSize(int nbSlots){
+    return sizeof(struct sharedRingHeader)+(size_t)nbSlots*sizeof(struct sharedSlot);
+}
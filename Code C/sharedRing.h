@@ -0,0 +1,75 @@
+#ifndef HEADER_SHAREDRING
+#define HEADER_SHAREDRING
+
+#include "aisdecode.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+#define SHARED_RING_MAGIC "AISRING1"
+#define SHARED_RING_SLOTS 65536
+#define SHARED_PAYLOAD_BYTES 128
+#define SHARED_BUSY UINT64_MAX
+#define SHARED_SPIN 256
+
+#define SHARED_OPEN 0
+#define SHARED_CLOSED 1
+#define SHARED_RETIRED 2
+
+struct sharedMessage
+{
+    uint64_t sequence;
+    double timestamp;
+    int64_t bitIndex;
+    int32_t messageType;
+    uint32_t mmsi;
+    double latitude, longitude, course;
+    uint16_t nbBits;
+    uint8_t channel;
+    uint8_t hasPosition;
+    uint32_t reserved;
+    uint8_t payload[SHARED_PAYLOAD_BYTES];
+};
+
+struct sharedSlot
+{
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t stamp;
+    struct sharedMessage message;
+};
+
+struct sharedRingHeader
+{
+    char magic[8];
+    uint32_t nbSlots;
+    uint32_t slotSize;
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t head;
+    _Atomic uint32_t wake;
+    _Atomic uint32_t nbWaiters;
+    _Atomic uint32_t closed;
+};
+
+struct sharedRing
+{
+    struct sharedRingHeader* header;
+    struct sharedSlot* slots;
+    size_t size;
+    uint64_t mask;
+    uint64_t next;
+    long long nbLost;
+    long long nbOverruns;
+};
+
+struct sharedRing* createSharedRing(const char* name, int nbSlots);
+int closeSharedRing(struct sharedRing* ring);
+void publishSharedMessage(struct sharedRing* ring, int* bits, int nbBits, long long bitIndex, double timestamp, char channel, struct aisMessage* message);
+struct sharedRing* attachSharedRing(const char* name);
+void detachSharedRing(struct sharedRing* ring);
+int readSharedMessage(struct sharedRing* ring, struct sharedMessage* message);
+int waitSharedRing(struct sharedRing* ring, int timeout);
+
+#endif
@@ -4,4 +4,5 @@ const int sizeSignal = 275865;
 const int timeDelay = 1000;
 const int sizePreambleFlag = 40;
 const int sizeEndFlag = 32;
-const int sizeCheckSum = 16;
\ No newline at end of file
+const int sizeCheckSum = 16;
+const int bitRate = 9600;
\ No newline at end of file
@@ -6,5 +6,6 @@ extern const int timeDelay;
 extern const int sizePreambleFlag;
 extern const int sizeEndFlag;
 extern const int sizeCheckSum;
+extern const int bitRate;
 
 #endif
\ No newline at end of file
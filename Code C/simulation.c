@@ -0,0 +1,482 @@
+#include "simulation.h"
+
+struct trialFrame
+{
+    int nbFrames;
+    long long bitIndex;
+    int size;
+    int bits[POSITION_REPORT_BITS];
+};
+
+struct simulationWorker
+{
+    struct simulation* sim;
+    struct randomState random;
+    int payload[POSITION_REPORT_BITS];
+    struct receiver* rx;
+    struct complex* samples;
+    struct complex* channelSamples;
+    int maxChannelSamples;
+    int* bits;
+    int nbBits;
+    int* packets;
+    int lengths[SIMULATION_BLOCK];
+    int offsets[SIMULATION_BLOCK];
+    struct aisMessage messages[SIMULATION_BLOCK];
+    struct trialFrame frames[2*SIMULATION_BLOCK];
+};
+
+void* runSimulationWorker(void* argument);
+void runSimulationUnit(struct simulationWorker* worker, int unit);
+void addSignalSegment(struct simulationWorker* worker, int trial, double noisePower);
+void addNoiseSegment(struct simulationWorker* worker, double noisePower);
+void countSignalTrial(struct simulationWorker* worker, int trial, struct simulationResult* result);
+void countNoiseTrial(struct simulationWorker* worker, int trial, struct simulationResult* result);
+void startStream(struct simulationWorker* worker);
+void receiveSegment(struct simulationWorker* worker);
+void endStream(struct simulationWorker* worker);
+void collectTrialFrame(int* frame, int size, long long bitIndex, void* context);
+int bestPreambleScore(int* bits, int nbBits, int* position);
+void calibrateTiming(struct simulationWorker* worker);
+struct simulationWorker* createSimulationWorker(struct simulation* sim);
+void freeSimulationWorker(struct simulationWorker* worker);
+
+/*
+Fonction : createSimulation
+Entrées : nombre d'échantillons par bit, produit bande-temps du modulateur, rapports signal sur bruit (dB),
+nombre de rapports, nombre d'essais par rapport, graine
+Sorties : la simulation allouée, NULL en cas d'erreur
+Équivalent de demo_perf_demodulator.py et demo_perf_detector.py : le travail est
+découpé en unités de SIMULATION_BLOCK essais d'un même rapport signal sur bruit,
+chacune avec son propre flux aléatoire, si bien que le résultat ne dépend pas du
+nombre de fils. Les essais passent par le récepteur lui-même (filtre de canal,
+démodulateur, détection du préambule et décodage) : seules les trames qu'il rend
+comptent comme reçues.
+*/
+struct simulation* createSimulation(int samplesPerBit, double bt, double* snrs, int nbSnrs, int nbTrials, uint64_t seed){
+    struct simulation* sim = (struct simulation*) calloc(1,sizeof(struct simulation));
+    if(sim == NULL || nbSnrs < 1 || nbTrials < 1){
+        free(sim);
+        return NULL;
+    }
+    if(samplesPerBit < 2){
+        free(sim);
+        return NULL;
+    }
+    sim->samplesPerBit = samplesPerBit;
+    // Place pour le paquet le plus long et un décalage aléatoire de SIMULATION_MARGIN_BITS/2 bits
+    sim->nbSamples = (FRAME_WINDOW+(POSITION_REPORT_BITS+sizeCheckSum)/5+SIMULATION_MARGIN_BITS)*samplesPerBit;
+    sim->segmentBits = FRAME_WINDOW+(POSITION_REPORT_BITS+sizeCheckSum)/5+SIMULATION_MARGIN_BITS;
+    sim->nbSnrs = nbSnrs;
+    sim->nbTrials = nbTrials;
+    sim->seed = seed;
+    sim->unitsPerSnr = (nbTrials+SIMULATION_BLOCK-1)/SIMULATION_BLOCK;
+    sim->nbUnits = sim->unitsPerSnr*nbSnrs;
+    sim->modulator = createGmskModulator(samplesPerBit,bt);
+    sim->snrs = (double*) malloc(nbSnrs*sizeof(double));
+    sim->timingShifts = (int*) calloc(samplesPerBit > 0 ? samplesPerBit : 1,sizeof(int));
+    sim->units = (struct simulationResult*) calloc(sim->nbUnits,sizeof(struct simulationResult));
+    if(sim->modulator == NULL || sim->snrs == NULL || sim->timingShifts == NULL || sim->units == NULL){
+        freeSimulation(sim);
+        return NULL;
+    }
+    memcpy(sim->snrs,snrs,nbSnrs*sizeof(double));
+    struct simulationWorker* worker = createSimulationWorker(sim);
+    if(worker == NULL){
+        freeSimulation(sim);
+        return NULL;
+    }
+    calibrateTiming(worker);
+    freeSimulationWorker(worker);
+    return sim;
+}
+
+void freeSimulation(struct simulation* sim){
+    if(sim == NULL){
+        return;
+    }
+    freeGmskModulator(sim->modulator);
+    free(sim->snrs);
+    free(sim->timingShifts);
+    free(sim->units);
+    free(sim);
+}
+
+/*
+Fonction : runSimulation
+Entrées : simulation, nombre de fils
+Sorties : 0 en cas de succès, -1 si aucun fil n'a pu être lancé
+Les fils prennent les unités de travail une par une grâce à un compteur partagé.
+*/
+int runSimulation(struct simulation* sim, int nbThreads){
+    pthread_t threads[SIMULATION_MAX_THREADS];
+    nbThreads = nbThreads < 1 ? 1 : nbThreads > SIMULATION_MAX_THREADS ? SIMULATION_MAX_THREADS : nbThreads;
+    atomic_store(&sim->nextUnit,0);
+    int nbStarted = 0;
+    for(int i=0; i<nbThreads; i++){
+        if(pthread_create(threads+nbStarted,NULL,runSimulationWorker,sim) == 0){
+            nbStarted += 1;
+        }
+    }
+    for(int i=0; i<nbStarted; i++){
+        pthread_join(*(threads+i),NULL);
+    }
+    return nbStarted > 0 && atomic_load(&sim->nextUnit) >= sim->nbUnits ? 0 : -1;
+}
+
+/*
+Fonction : getSimulationResult
+Entrées : simulation terminée, indice du rapport signal sur bruit, résultat à remplir
+Sorties :
+Somme, dans l'ordre, des unités de travail du rapport signal sur bruit.
+*/
+void getSimulationResult(struct simulation* sim, int snr, struct simulationResult* result){
+    memset(result,0,sizeof(struct simulationResult));
+    for(int u=snr*sim->unitsPerSnr; u<(snr+1)*sim->unitsPerSnr; u++){
+        struct simulationResult* unit = sim->units+u;
+        result->nbTrials += unit->nbTrials;
+        result->nbBits += unit->nbBits;
+        result->nbBitErrors += unit->nbBitErrors;
+        result->nbDetected += unit->nbDetected;
+        result->nbCrcErrors += unit->nbCrcErrors;
+        result->nbPacketErrors += unit->nbPacketErrors;
+        result->nbFalseFrames += unit->nbFalseFrames;
+        result->nbTypeErrors += unit->nbTypeErrors;
+        result->nbMmsiErrors += unit->nbMmsiErrors;
+        result->nbLatitudeErrors += unit->nbLatitudeErrors;
+        result->nbLongitudeErrors += unit->nbLongitudeErrors;
+        result->nbCourseErrors += unit->nbCourseErrors;
+        result->positionError += unit->positionError;
+        for(int s=0; s<SIMULATION_SCORES; s++){
+            result->signalScores[s] += unit->signalScores[s];
+            result->noiseScores[s] += unit->noiseScores[s];
+        }
+    }
+}
+
+void* runSimulationWorker(void* argument){
+    struct simulation* sim = (struct simulation*) argument;
+    struct simulationWorker* worker = createSimulationWorker(sim);
+    int unit;
+    while(worker != NULL && (unit = atomic_fetch_add(&sim->nextUnit,1)) < sim->nbUnits){
+        runSimulationUnit(worker,unit);
+    }
+    freeSimulationWorker(worker);
+    return NULL;
+}
+
+/*
+Fonction : createSimulationWorker
+Entrées : simulation
+Sorties : le fil de calcul alloué, NULL en cas d'erreur
+Chaque fil a son propre récepteur, à samplesPerBit échantillons par bit comme une
+entrée enregistrée à cette fréquence, et garde les bits démodulés de toute une unité
+de travail pour le taux d'erreur binaire et les scores du préambule.
+*/
+struct simulationWorker* createSimulationWorker(struct simulation* sim){
+    struct simulationWorker* worker = (struct simulationWorker*) calloc(1,sizeof(struct simulationWorker));
+    if(worker == NULL){
+        return NULL;
+    }
+    worker->sim = sim;
+    worker->rx = createChannelReceiver((double)sim->samplesPerBit*bitRate,0,collectTrialFrame,worker);
+    worker->samples = (struct complex*) malloc(sim->nbSamples*sizeof(struct complex));
+    worker->packets = (int*) malloc(SIMULATION_BLOCK*MAX_PACKET_BITS*sizeof(int));
+    if(worker->rx == NULL || worker->samples == NULL || worker->packets == NULL){
+        freeSimulationWorker(worker);
+        return NULL;
+    }
+    struct receiver* rx = worker->rx;
+    worker->maxChannelSamples = channelizerMaxOutput(rx->channelizer,sim->nbSamples);
+    // demodulateSamples rend les bits par blocs entiers, flushSamples le dernier bloc
+    long long nbChannelSamples = 2LL*SIMULATION_BLOCK*worker->maxChannelSamples;
+    worker->channelSamples = (struct complex*) malloc(worker->maxChannelSamples*sizeof(struct complex));
+    worker->bits = (int*) malloc((nbChannelSamples/rx->stride+2)*rx->nbBits*sizeof(int));
+    if(worker->channelSamples == NULL || worker->bits == NULL){
+        freeSimulationWorker(worker);
+        return NULL;
+    }
+    return worker;
+}
+
+void freeSimulationWorker(struct simulationWorker* worker){
+    if(worker == NULL){
+        return;
+    }
+    if(worker->rx != NULL){
+        freeChannelizer(worker->rx->channelizer);
+        freeReceiver(worker->rx);
+    }
+    free(worker->samples);
+    free(worker->channelSamples);
+    free(worker->bits);
+    free(worker->packets);
+    free(worker);
+}
+
+/*
+Fonction : runSimulationUnit
+Entrées : fil de calcul, numéro de l'unité de travail
+Sorties :
+Chaque essai émet une trame (hypothèse H1) puis du bruit seul (hypothèse H0), chacun
+dans un segment de nbSamples échantillons. Les segments de l'unité forment un seul
+flux passé au récepteur, remis à zéro au début de l'unité ; les trames qu'il rend
+sont rangées par segment puis comptées à la fin du flux.
+*/
+void runSimulationUnit(struct simulationWorker* worker, int unit){
+    struct simulation* sim = worker->sim;
+    struct simulationResult* result = sim->units+unit;
+    int snr = unit/sim->unitsPerSnr;
+    int block = unit%sim->unitsPerSnr;
+    int nbTrials = sim->nbTrials-block*SIMULATION_BLOCK < SIMULATION_BLOCK ? sim->nbTrials-block*SIMULATION_BLOCK : SIMULATION_BLOCK;
+    double noisePower = pow(10.0,-*(sim->snrs+snr)/10.0);
+    seedRandom(&worker->random,sim->seed,unit);
+    memset(result,0,sizeof(struct simulationResult));
+    startStream(worker);
+    for(int t=0; t<nbTrials; t++){
+        addSignalSegment(worker,t,noisePower);
+        addNoiseSegment(worker,noisePower);
+    }
+    endStream(worker);
+    for(int t=0; t<nbTrials; t++){
+        countSignalTrial(worker,t,result);
+        countNoiseTrial(worker,t,result);
+        result->nbTrials += 1;
+    }
+}
+
+/*
+Fonction : addSignalSegment
+Entrées : fil de calcul, numéro de l'essai dans l'unité, puissance du bruit
+Sorties :
+Comme GenAIS.gen_rand_ais_type_1 : rapport de position aux champs aléatoires, placé à
+un instant aléatoire avec une phase aléatoire, puis passé au récepteur.
+*/
+void addSignalSegment(struct simulationWorker* worker, int trial, double noisePower){
+    struct simulation* sim = worker->sim;
+    struct aisMessage* message = worker->messages+trial;
+    int* packet = worker->packets+trial*MAX_PACKET_BITS;
+    for(int i=0; i<POSITION_REPORT_BITS; i++){
+        worker->payload[i] = randomNext(&worker->random) >> 63;
+    }
+    message->messageType = 1;
+    message->mmsi = randomNext(&worker->random)%1000000000;
+    message->latitude = floor(randomUniform(&worker->random)*108000000-54000000)/600000.0;
+    message->longitude = floor(randomUniform(&worker->random)*216000000-108000000)/600000.0;
+    message->course = floor(randomUniform(&worker->random)*3600)/10.0;
+    encodePositionReport(message,worker->payload);
+    worker->lengths[trial] = buildAisPacket(worker->payload,POSITION_REPORT_BITS,packet);
+
+    int offset = randomNext(&worker->random)%(SIMULATION_MARGIN_BITS/2*sim->samplesPerBit);
+    worker->offsets[trial] = offset;
+    memset(worker->samples,0,sim->nbSamples*sizeof(struct complex));
+    int nbSignal = modulateGmsk(sim->modulator,packet,worker->lengths[trial],worker->samples+offset);
+    rotateSignal(worker->samples+offset,nbSignal,2*M_PI*randomUniform(&worker->random),0);
+    addNoise(&worker->random,worker->samples,sim->nbSamples,noisePower);
+    receiveSegment(worker);
+}
+
+/*
+Fonction : addNoiseSegment
+Entrées : fil de calcul, puissance du bruit
+Sorties :
+Même durée que pour H1 mais sans signal.
+*/
+void addNoiseSegment(struct simulationWorker* worker, double noisePower){
+    struct simulation* sim = worker->sim;
+    memset(worker->samples,0,sim->nbSamples*sizeof(struct complex));
+    addNoise(&worker->random,worker->samples,sim->nbSamples,noisePower);
+    receiveSegment(worker);
+}
+
+/*
+Fonction : countSignalTrial
+Entrées : fil de calcul, numéro de l'essai dans l'unité, résultat de l'unité
+Sorties :
+Le taux d'erreur binaire porte sur tous les bits du paquet, en sortie du
+démodulateur du récepteur. La trame est détectée si le test du préambule du
+récepteur passe dans le segment ; elle est reçue si le récepteur rend une trame
+(somme de contrôle correcte), dont les champs sont comparés à ceux émis.
+*/
+void countSignalTrial(struct simulationWorker* worker, int trial, struct simulationResult* result){
+    struct simulation* sim = worker->sim;
+    struct aisMessage decoded;
+    struct aisMessage* message = worker->messages+trial;
+    int* packet = worker->packets+trial*MAX_PACKET_BITS;
+    int segment = 2*trial*sim->segmentBits;
+    int offset = worker->offsets[trial];
+
+    // Position du premier bit du paquet dans la sortie du démodulateur
+    int start = segment+offset/sim->samplesPerBit+*(sim->timingShifts+offset%sim->samplesPerBit);
+    for(int b=0; b<worker->lengths[trial] && start+b<worker->nbBits; b++){
+        result->nbBits += 1;
+        result->nbBitErrors += *(worker->bits+start+b) != *(packet+b);
+    }
+
+    int position;
+    int score = bestPreambleScore(worker->bits+segment,sim->segmentBits,&position);
+    result->signalScores[score] += 1;
+    struct trialFrame* frame = worker->frames+2*trial;
+    if(score == SIMULATION_SCORES-1){
+        result->nbDetected += 1;
+        result->nbCrcErrors += frame->nbFrames == 0;
+    }
+    if(frame->nbFrames == 0){
+        result->nbPacketErrors += 1;
+        if(score == SIMULATION_SCORES-1){
+            result->nbTypeErrors += 1;
+            result->nbMmsiErrors += 1;
+            result->nbLatitudeErrors += 1;
+            result->nbLongitudeErrors += 1;
+            result->nbCourseErrors += 1;
+        }
+        return;
+    }
+    result->positionError += llabs(frame->bitIndex-start);
+    if(decodePositionReport(frame->bits,frame->size,0,&decoded) == 0){
+        result->nbTypeErrors += 1;
+        result->nbMmsiErrors += 1;
+        result->nbLatitudeErrors += 1;
+        result->nbLongitudeErrors += 1;
+        result->nbCourseErrors += 1;
+        return;
+    }
+    result->nbTypeErrors += decoded.messageType != message->messageType;
+    result->nbMmsiErrors += decoded.mmsi != message->mmsi;
+    result->nbLatitudeErrors += fabs(decoded.latitude-message->latitude) > 1e-5;
+    result->nbLongitudeErrors += fabs(decoded.longitude-message->longitude) > 1e-5;
+    result->nbCourseErrors += fabs(decoded.course-message->course) > 0.05;
+}
+
+/*
+Fonction : countNoiseTrial
+Entrées : fil de calcul, numéro de l'essai dans l'unité, résultat de l'unité
+Sorties :
+Le meilleur score du préambule sur le bruit seul donne la fausse alarme ; une trame
+rendue par le récepteur sur ce segment est une fausse trame.
+*/
+void countNoiseTrial(struct simulationWorker* worker, int trial, struct simulationResult* result){
+    struct simulation* sim = worker->sim;
+    int position;
+    result->noiseScores[bestPreambleScore(worker->bits+(2*trial+1)*sim->segmentBits,sim->segmentBits,&position)] += 1;
+    result->nbFalseFrames += (worker->frames+2*trial+1)->nbFrames > 0;
+}
+
+/*
+Fonction : startStream
+Entrées : fil de calcul
+Sorties :
+Remet le récepteur et son filtre de canal au début d'un flux, comme processIqRange.
+*/
+void startStream(struct simulationWorker* worker){
+    struct receiver* rx = worker->rx;
+    resetChannelizer(rx->channelizer,0,0);
+    rx->nbSamples = 0;
+    rx->nbHistory = 0;
+    rx->bitIndex = 0;
+    rx->sampleIndex = 0;
+    worker->nbBits = 0;
+    memset(worker->frames,0,sizeof(worker->frames));
+}
+
+/*
+Fonction : receiveSegment
+Entrées : fil de calcul
+Sorties :
+Passe le segment courant au récepteur en deux moitiés, comme le mode en étages :
+les bits démodulés sont gardés avant d'être cherchés par processBits.
+*/
+void receiveSegment(struct simulationWorker* worker){
+    struct receiver* rx = worker->rx;
+    int nbChannelSamples = channelize(rx->channelizer,worker->samples,worker->sim->nbSamples,worker->channelSamples,worker->maxChannelSamples);
+    int nbBits = demodulateSamples(rx,worker->channelSamples,nbChannelSamples,worker->bits+worker->nbBits);
+    processBits(rx,worker->bits+worker->nbBits,nbBits);
+    worker->nbBits += nbBits;
+}
+
+void endStream(struct simulationWorker* worker){
+    int nbBits = flushSamples(worker->rx,worker->bits+worker->nbBits);
+    processBits(worker->rx,worker->bits+worker->nbBits,nbBits);
+    flushBits(worker->rx);
+    worker->nbBits += nbBits;
+}
+
+/*
+Fonction : collectTrialFrame
+Entrées : bits de la trame, nombre de bits, indice du bit où commence la fenêtre de la trame, fil de calcul
+Sorties :
+Fonction des trames du récepteur : la première trame de chaque segment est gardée.
+*/
+void collectTrialFrame(int* frame, int size, long long bitIndex, void* context){
+    struct simulationWorker* worker = (struct simulationWorker*) context;
+    long long segment = bitIndex/worker->sim->segmentBits;
+    if(segment < 0 || segment >= 2*SIMULATION_BLOCK){
+        return;
+    }
+    struct trialFrame* trialFrame = worker->frames+segment;
+    if(trialFrame->nbFrames == 0){
+        trialFrame->bitIndex = bitIndex;
+        trialFrame->size = size < POSITION_REPORT_BITS ? size : POSITION_REPORT_BITS;
+        memcpy(trialFrame->bits,frame,trialFrame->size*sizeof(int));
+    }
+    trialFrame->nbFrames += 1;
+}
+
+/*
+Fonction : bestPreambleScore
+Entrées : bits démodulés, nombre de bits, position à remplir
+Sorties : le plus grand nombre de bits communs avec le préambule et le fanion de début
+Test du préambule de processWindow (un bit vaut 1 quand le niveau ne change pas),
+à ceci près qu'il compte les bits conformes au lieu d'exiger les 32 : seul le score
+32 fait détecter une trame par le récepteur, les autres donnent les courbes COR. La
+position est celle de la première fenêtre ayant ce score.
+*/
+int bestPreambleScore(int* bits, int nbBits, int* position){
+    int best = 0;
+    *position = 0;
+    for(int w=0; w+40<=nbBits; w++){
+        int score = 0;
+        for(int j=8; j<40; j++){
+            score += (*(bits+w+j) == *(bits+w+j-1)) == aisPreambleFlag[j-8];
+        }
+        if(score > best){
+            best = score;
+            *position = w;
+        }
+    }
+    return best;
+}
+
+/*
+Fonction : calibrateTiming
+Entrées : fil de calcul de la simulation
+Sorties :
+Sans bruit, cherche pour chaque décalage modulo samplesPerBit l'écart entre le premier
+bit du paquet et la sortie du démodulateur qui donne le moins d'erreurs. L'écart
+comprend le retard du filtre de canal.
+*/
+void calibrateTiming(struct simulationWorker* worker){
+    struct simulation* sim = worker->sim;
+    for(int i=0; i<POSITION_REPORT_BITS; i++){
+        worker->payload[i] = (i*7/3) & 1;
+    }
+    int length = buildAisPacket(worker->payload,POSITION_REPORT_BITS,worker->packets);
+    for(int r=0; r<sim->samplesPerBit; r++){
+        startStream(worker);
+        memset(worker->samples,0,sim->nbSamples*sizeof(struct complex));
+        modulateGmsk(sim->modulator,worker->packets,length,worker->samples+r);
+        receiveSegment(worker);
+        endStream(worker);
+        int bestErrors = length+1;
+        for(int shift=-2; shift<=SIMULATION_MARGIN_BITS/2; shift++){
+            int errors = 0;
+            for(int b=0; b<length; b++){
+                errors += shift+b < 0 || shift+b >= worker->nbBits || *(worker->bits+shift+b) != *(worker->packets+b);
+            }
+            if(errors < bestErrors){
+                bestErrors = errors;
+                *(sim->timingShifts+r) = shift;
+            }
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef HEADER_SIMULATION
+#define HEADER_SIMULATION
+
+#include "modulator.h"
+#include "channelModel.h"
+#include "demod.h"
+#include "receiver.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIMULATION_SCORES 33
+#define SIMULATION_BLOCK 250
+#define SIMULATION_MARGIN_BITS 64
+#define SIMULATION_MAX_THREADS 256
+
+struct simulationResult
+{
+    long long nbTrials;
+    long long nbBits, nbBitErrors;
+    long long nbDetected;
+    long long nbCrcErrors, nbPacketErrors, nbFalseFrames;
+    long long nbTypeErrors, nbMmsiErrors, nbLatitudeErrors, nbLongitudeErrors, nbCourseErrors;
+    long long positionError;
+    long long signalScores[SIMULATION_SCORES];
+    long long noiseScores[SIMULATION_SCORES];
+};
+
+struct simulation
+{
+    struct gmskModulator* modulator;
+    int samplesPerBit;
+    int nbSamples;
+    double* snrs;
+    int nbSnrs;
+    int nbTrials;
+    int segmentBits;
+    uint64_t seed;
+    int* timingShifts;
+    int unitsPerSnr, nbUnits;
+    atomic_int nextUnit;
+    struct simulationResult* units;
+};
+
+struct simulation* createSimulation(int samplesPerBit, double bt, double* snrs, int nbSnrs, int nbTrials, uint64_t seed);
+void freeSimulation(struct simulation* sim);
+int runSimulation(struct simulation* sim, int nbThreads);
+void getSimulationResult(struct simulation* sim, int snr, struct simulationResult* result);
+
+#endif
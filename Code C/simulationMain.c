@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include "simulation.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_SNRS 1024
+
+int parseSnrs(const char* range, double* snrs);
+
+/*
+Simulation de Monte-Carlo du récepteur (filtre de canal, démodulateur, détecteur du
+préambule et décodeur) sur des rapports de position aléatoires modulés en GMSK et
+bruités. Une ligne CSV par rapport signal sur bruit sur la sortie standard : taux
+d'erreur binaire, probabilité de détection, taux d'erreur de somme de contrôle,
+taux d'erreur paquet, taux d'erreur de chaque champ parmi les trames détectées et
+taux de trames rendues sur du bruit seul.
+Avec -R, les points des courbes COR (fausse alarme, détection) pour les seuils de
+-30 à 32 sont écrits dans le fichier donné.
+*/
+int main(int argc, char** argv)
+{
+   int option;
+   int nbTrials = 5000;
+   int nbThreads = 0;
+   int samplesPerBit = 10;
+   double bt = 0.4;
+   unsigned long long seed = 1;
+   const char *rocPath = NULL;
+   const char *range = "-10:24:2";
+   while((option = getopt(argc, argv, "b:j:n:p:r:R:s:")) != -1){
+      switch(option){
+      case 'b':
+         bt = atof(optarg);
+         break;
+      case 'j':
+         nbThreads = atoi(optarg);
+         break;
+      case 'n':
+         nbTrials = atoi(optarg);
+         break;
+      case 'p':
+         samplesPerBit = atoi(optarg);
+         break;
+      case 'r':
+         seed = strtoull(optarg, NULL, 10);
+         break;
+      case 'R':
+         rocPath = optarg;
+         break;
+      case 's':
+         range = optarg;
+         break;
+      default:
+         fprintf(stderr, "Usage : %s [-n trials] [-s min:max:step] [-j threads] [-r seed] [-b bt] [-p samples per bit] [-R roc.csv]\n", argv[0]);
+         return(1);
+      }
+   }
+   double snrs[MAX_SNRS];
+   int nbSnrs = parseSnrs(range, snrs);
+   if(nbSnrs < 1){
+      fprintf(stderr, "Invalid SNR range %s\n", range);
+      return(1);
+   }
+   struct simulation *sim = createSimulation(samplesPerBit, bt, snrs, nbSnrs, nbTrials, seed);
+   if(sim == NULL){
+      fprintf(stderr, "Cannot create the simulation\n");
+      return(1);
+   }
+   if(nbThreads < 1){
+      nbThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   }
+   if(runSimulation(sim, nbThreads) < 0){
+      fprintf(stderr, "Simulation failed\n");
+      freeSimulation(sim);
+      return(1);
+   }
+
+   FILE *roc = NULL;
+   if(rocPath != NULL){
+      roc = fopen(rocPath, "w");
+      if(roc == NULL){
+         fprintf(stderr, "Cannot open %s\n", rocPath);
+         freeSimulation(sim);
+         return(1);
+      }
+      fprintf(roc, "snr_db,threshold,false_alarm,detection\n");
+   }
+   printf("snr_db,trials,ber,detection,crc_error,packet_error,type_error,mmsi_error,latitude_error,longitude_error,course_error,position_error_bits,false_frames\n");
+   for(int s = 0; s < nbSnrs; s++){
+      struct simulationResult result;
+      getSimulationResult(sim, s, &result);
+      double trials = result.nbTrials;
+      double detected = result.nbDetected > 0 ? result.nbDetected : 1;
+      printf("%g,%lld,%.6e,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.4f,%.6f\n", snrs[s], result.nbTrials,
+         result.nbBits > 0 ? (double)result.nbBitErrors/result.nbBits : 0,
+         result.nbDetected/trials, result.nbCrcErrors/detected, result.nbPacketErrors/trials,
+         result.nbTypeErrors/detected, result.nbMmsiErrors/detected, result.nbLatitudeErrors/detected,
+         result.nbLongitudeErrors/detected, result.nbCourseErrors/detected, result.positionError/detected, result.nbFalseFrames/trials);
+      if(roc != NULL){
+         // Score : nombre de bits communs avec le préambule, produit scalaire = 2*score-32
+         long long falseAlarms[SIMULATION_SCORES+1], detections[SIMULATION_SCORES+1];
+         falseAlarms[SIMULATION_SCORES] = 0;
+         detections[SIMULATION_SCORES] = 0;
+         for(int score = SIMULATION_SCORES-1; score >= 0; score--){
+            falseAlarms[score] = falseAlarms[score+1]+result.noiseScores[score];
+            detections[score] = detections[score+1]+result.signalScores[score];
+         }
+         for(int score = 1; score < SIMULATION_SCORES; score++){
+            fprintf(roc, "%g,%d,%.6f,%.6f\n", snrs[s], 2*score-32, falseAlarms[score]/trials, detections[score]/trials);
+         }
+      }
+   }
+   if(roc != NULL){
+      fclose(roc);
+   }
+   freeSimulation(sim);
+   return(0);
+}
+
+/*
+Fonction : parseSnrs
+Entrées : intervalle min:max:pas (ou une seule valeur) en dB, tableau de MAX_SNRS valeurs à remplir
+Sorties : le nombre de valeurs, -1 si l'intervalle est invalide
+*/
+int parseSnrs(const char* range, double* snrs)
+{
+   double min, max, step = 1;
+   int nbFields = sscanf(range, "%lf:%lf:%lf", &min, &max, &step);
+   if(nbFields == 1){
+      max = min;
+   } else if(nbFields < 2 || step <= 0 || max < min){
+      return -1;
+   }
+   int nbSnrs = 0;
+   for(double snr = min; snr <= max+step*1e-6 && nbSnrs < MAX_SNRS; snr += step){
+      snrs[nbSnrs++] = snr;
+   }
+   return nbSnrs;
+}
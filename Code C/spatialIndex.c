@@ -0,0 +1,329 @@
+#include "spatialIndex.h"
+
+#define NO_NODE -1
+
+struct spatialQuery
+{
+    double latMin, latMax, lonMin, lonMax;
+    double latitude, longitude, radius;
+    unsigned int* output;
+    int maxOutput;
+    int count;
+};
+
+int findNode(struct spatialIndex* index, unsigned int mmsi, int* slot);
+void removeHashSlot(struct spatialIndex* index, int slot);
+int cellOf(struct spatialIndex* index, double latitude, double longitude);
+void unlinkNode(struct spatialIndex* index, int node);
+void linkNode(struct spatialIndex* index, int node, int cell);
+void scanQuery(struct spatialIndex* index, struct spatialQuery* query);
+void scanCells(struct spatialIndex* index, struct spatialQuery* query, int rowMin, int rowMax, int columnMin, int columnMax);
+double haversineDistance(double lat1, double lon1, double lat2, double lon2);
+
+/*
+Fonction : createSpatialIndex
+Entrées : taille d'une cellule de la grille en degrés, nombre maximal de navires
+Sorties : l'index alloué, NULL en cas d'erreur
+Grille uniforme en latitude/longitude couvrant tout le globe. Chaque cellule est la
+tête d'une liste doublement chaînée de navires : déplacer un navire d'une cellule à
+l'autre se fait en temps constant.
+*/
+struct spatialIndex* createSpatialIndex(double cellSize, int maxVessels){
+    struct spatialIndex* index = (struct spatialIndex*) malloc(sizeof(struct spatialIndex));
+    if(index == NULL){
+        return NULL;
+    }
+    index->cellSize = cellSize;
+    index->nbLatCells = (int)ceil(180.0/cellSize);
+    index->nbLonCells = (int)ceil(360.0/cellSize);
+    index->maxVessels = maxVessels;
+    int hashSize = 2;
+    while(hashSize < 2*maxVessels){
+        hashSize *= 2;
+    }
+    index->hashMask = hashSize-1;
+    index->cells = (int*) malloc(index->nbLatCells*index->nbLonCells*sizeof(int));
+    index->nodes = (struct spatialNode*) malloc(maxVessels*sizeof(struct spatialNode));
+    index->hashTable = (int*) malloc(hashSize*sizeof(int));
+    if(index->cells == NULL || index->nodes == NULL || index->hashTable == NULL){
+        freeSpatialIndex(index);
+        return NULL;
+    }
+    for(int i=0; i<index->nbLatCells*index->nbLonCells; i++){
+        *(index->cells+i) = NO_NODE;
+    }
+    for(int i=0; i<hashSize; i++){
+        *(index->hashTable+i) = NO_NODE;
+    }
+    // Les noeuds libres sont chaînés par leur champ next et n'ont pas de cellule
+    for(int i=0; i<maxVessels; i++){
+        (index->nodes+i)->next = i+1 < maxVessels ? i+1 : NO_NODE;
+        (index->nodes+i)->cell = NO_NODE;
+    }
+    index->freeNode = maxVessels > 0 ? 0 : NO_NODE;
+    index->nbVessels = 0;
+    index->nbRejected = 0;
+    return index;
+}
+
+void freeSpatialIndex(struct spatialIndex* index){
+    if(index == NULL){
+        return;
+    }
+    free(index->cells);
+    free(index->nodes);
+    free(index->hashTable);
+    free(index);
+}
+
+/*
+Fonction : updateVesselPosition
+Entrées : index, MMSI, latitude et longitude en degrés, date du rapport
+Sorties : 0 en cas de succès, -1 si l'index est plein (le navire n'est alors pas indexé)
+À appeler à chaque rapport de position décodé. Une position non disponible
+(latitude 91, longitude 181) retire le navire de l'index. Les places ne se libèrent
+que par removeVesselPosition et expireVesselPositions.
+*/
+int updateVesselPosition(struct spatialIndex* index, unsigned int mmsi, double latitude, double longitude, double timestamp){
+    if(latitude < -90.0 || latitude > 90.0 || longitude < -180.0 || longitude > 180.0){
+        removeVesselPosition(index,mmsi);
+        return 0;
+    }
+    int slot;
+    int node = findNode(index,mmsi,&slot);
+    int cell = cellOf(index,latitude,longitude);
+    if(node == NO_NODE){
+        if(index->freeNode == NO_NODE){
+            index->nbRejected += 1;
+            return -1;
+        }
+        node = index->freeNode;
+        index->freeNode = (index->nodes+node)->next;
+        (index->nodes+node)->mmsi = mmsi;
+        *(index->hashTable+slot) = node;
+        linkNode(index,node,cell);
+        index->nbVessels += 1;
+    } else if((index->nodes+node)->cell != cell){
+        unlinkNode(index,node);
+        linkNode(index,node,cell);
+    }
+    (index->nodes+node)->latitude = latitude;
+    (index->nodes+node)->longitude = longitude;
+    (index->nodes+node)->timestamp = timestamp;
+    return 0;
+}
+
+/*
+Fonction : removeVesselPosition
+Entrées : index, MMSI
+Sorties : 1 si le navire a été retiré, 0 s'il n'était pas présent
+*/
+int removeVesselPosition(struct spatialIndex* index, unsigned int mmsi){
+    int slot;
+    int node = findNode(index,mmsi,&slot);
+    if(node == NO_NODE){
+        return 0;
+    }
+    unlinkNode(index,node);
+    removeHashSlot(index,slot);
+    (index->nodes+node)->cell = NO_NODE;
+    (index->nodes+node)->next = index->freeNode;
+    index->freeNode = node;
+    index->nbVessels -= 1;
+    return 1;
+}
+
+/*
+Fonction : expireVesselPositions
+Entrées : index, date du plus ancien rapport à garder
+Sorties : le nombre de navires retirés
+Retire les navires dont la dernière position est antérieure à minTimestamp, par
+exemple ceux que la table des navires ne suit plus : l'index ne se remplit pas des
+navires partis.
+*/
+int expireVesselPositions(struct spatialIndex* index, double minTimestamp){
+    int count = 0;
+    for(int i=0; i<index->maxVessels; i++){
+        struct spatialNode* current = index->nodes+i;
+        if(current->cell != NO_NODE && current->timestamp < minTimestamp){
+            count += removeVesselPosition(index,current->mmsi);
+        }
+    }
+    return count;
+}
+
+/*
+Fonction : queryBoundingBox
+Entrées : index, latitudes et longitudes minimales et maximales en degrés, tableau pour recevoir les MMSI, taille du tableau
+Sorties : le nombre de navires dans la zone (seuls les maxOutput premiers sont écrits)
+Une zone traversant l'antiméridien se donne avec lonMin > lonMax. Seules les cellules
+recouvrant la zone sont parcourues.
+*/
+int queryBoundingBox(struct spatialIndex* index, double latMin, double latMax, double lonMin, double lonMax, unsigned int* output, int maxOutput){
+    struct spatialQuery query = {latMin, latMax, lonMin, lonMax, 0.0, 0.0, -1.0, output, maxOutput, 0};
+    scanQuery(index,&query);
+    return query.count;
+}
+
+/*
+Fonction : queryRadius
+Entrées : index, latitude et longitude du centre en degrés, rayon en mètres, tableau pour recevoir les MMSI, taille du tableau
+Sorties : le nombre de navires à moins de radius mètres du centre (seuls les maxOutput premiers sont écrits)
+Les cellules parcourues sont celles du rectangle englobant le cercle.
+*/
+int queryRadius(struct spatialIndex* index, double latitude, double longitude, double radius, unsigned int* output, int maxOutput){
+    struct spatialQuery query = {-90.0, 90.0, -180.0, 180.0, latitude, longitude, radius, output, maxOutput, 0};
+    double deltaLat = radius/EARTH_RADIUS_M*180.0/M_PI;
+    if(latitude-deltaLat > -90.0 && latitude+deltaLat < 90.0){
+        query.latMin = latitude-deltaLat;
+        query.latMax = latitude+deltaLat;
+        double deltaLon = asin(fmin(1.0,sin(radius/EARTH_RADIUS_M)/cos(latitude*M_PI/180.0)))*180.0/M_PI;
+        if(deltaLon < 180.0){
+            query.lonMin = fmod(longitude-deltaLon+540.0,360.0)-180.0;
+            query.lonMax = fmod(longitude+deltaLon+540.0,360.0)-180.0;
+        }
+    } else if(latitude-deltaLat > -90.0){
+        query.latMin = latitude-deltaLat;
+    } else if(latitude+deltaLat < 90.0){
+        query.latMax = latitude+deltaLat;
+    }
+    scanQuery(index,&query);
+    return query.count;
+}
+
+/*
+Fonction : scanQuery
+Entrées : index, requête à exécuter
+Sorties :
+Parcourt les cellules recouvrant le rectangle de la requête. Une zone traversant
+l'antiméridien est découpée en deux rectangles.
+*/
+void scanQuery(struct spatialIndex* index, struct spatialQuery* query){
+    int rowMin = (int)floor((fmax(query->latMin,-90.0)+90.0)/index->cellSize);
+    int rowMax = (int)floor((fmin(query->latMax,90.0)+90.0)/index->cellSize);
+    int columnMin = (int)floor((fmax(query->lonMin,-180.0)+180.0)/index->cellSize);
+    int columnMax = (int)floor((fmin(query->lonMax,180.0)+180.0)/index->cellSize);
+    if(rowMax >= index->nbLatCells){
+        rowMax = index->nbLatCells-1;
+    }
+    if(columnMax >= index->nbLonCells){
+        columnMax = index->nbLonCells-1;
+    }
+    if(query->lonMin <= query->lonMax){
+        scanCells(index,query,rowMin,rowMax,columnMin,columnMax);
+    } else {
+        scanCells(index,query,rowMin,rowMax,columnMin,index->nbLonCells-1);
+        scanCells(index,query,rowMin,rowMax,0,columnMax);
+    }
+}
+
+void scanCells(struct spatialIndex* index, struct spatialQuery* query, int rowMin, int rowMax, int columnMin, int columnMax){
+    int wrapped = query->lonMin > query->lonMax;
+    for(int row=rowMin; row<=rowMax; row++){
+        for(int column=columnMin; column<=columnMax; column++){
+            int node = *(index->cells+row*index->nbLonCells+column);
+            while(node != NO_NODE){
+                struct spatialNode* current = index->nodes+node;
+                node = current->next;
+                if(current->latitude < query->latMin || current->latitude > query->latMax){
+                    continue;
+                }
+                if(wrapped ? (current->longitude < query->lonMin && current->longitude > query->lonMax)
+                    : (current->longitude < query->lonMin || current->longitude > query->lonMax)){
+                    continue;
+                }
+                if(query->radius >= 0 && haversineDistance(query->latitude,query->longitude,current->latitude,current->longitude) > query->radius){
+                    continue;
+                }
+                if(query->count < query->maxOutput){
+                    *(query->output+query->count) = current->mmsi;
+                }
+                query->count += 1;
+            }
+        }
+    }
+}
+
+double haversineDistance(double lat1, double lon1, double lat2, double lon2){
+    double dLat = (lat2-lat1)*M_PI/180.0;
+    double dLon = (lon2-lon1)*M_PI/180.0;
+    double a = pow(sin(dLat/2),2) + cos(lat1*M_PI/180.0)*cos(lat2*M_PI/180.0)*pow(sin(dLon/2),2);
+    return 2*EARTH_RADIUS_M*asin(fmin(1.0,sqrt(a)));
+}
+
+int cellOf(struct spatialIndex* index, double latitude, double longitude){
+    int row = (int)((latitude+90.0)/index->cellSize);
+    int column = (int)((longitude+180.0)/index->cellSize);
+    if(row >= index->nbLatCells){
+        row = index->nbLatCells-1;
+    }
+    if(column >= index->nbLonCells){
+        column = index->nbLonCells-1;
+    }
+    return row*index->nbLonCells+column;
+}
+
+void linkNode(struct spatialIndex* index, int node, int cell){
+    struct spatialNode* current = index->nodes+node;
+    int head = *(index->cells+cell);
+    current->cell = cell;
+    current->previous = NO_NODE;
+    current->next = head;
+    if(head != NO_NODE){
+        (index->nodes+head)->previous = node;
+    }
+    *(index->cells+cell) = node;
+}
+
+void unlinkNode(struct spatialIndex* index, int node){
+    struct spatialNode* current = index->nodes+node;
+    if(current->previous != NO_NODE){
+        (index->nodes+current->previous)->next = current->next;
+    } else {
+        *(index->cells+current->cell) = current->next;
+    }
+    if(current->next != NO_NODE){
+        (index->nodes+current->next)->previous = current->previous;
+    }
+}
+
+/*
+Fonction : findNode
+Entrées : index, MMSI, case de la table de hachage pour recevoir la sortie
+Sorties : le noeud du navire, NO_NODE s'il est absent (slot est alors la case où l'insérer)
+*/
+int findNode(struct spatialIndex* index, unsigned int mmsi, int* slot){
+    unsigned int position = (mmsi*2654435761u) & index->hashMask;
+    while(*(index->hashTable+position) != NO_NODE){
+        int node = *(index->hashTable+position);
+        if((index->nodes+node)->mmsi == mmsi){
+            *slot = position;
+            return node;
+        }
+        position = (position+1) & index->hashMask;
+    }
+    *slot = position;
+    return NO_NODE;
+}
+
+/*
+Fonction : removeHashSlot
+Entrées : index, case de la table de hachage à vider
+Sorties :
+Suppression par décalage arrière : les entrées suivantes de la chaîne sont remontées
+pour ne pas laisser de trou, ce qui évite les pierres tombales.
+*/
+void removeHashSlot(struct spatialIndex* index, int slot){
+    int hole = slot;
+    int position = (slot+1) & index->hashMask;
+    while(*(index->hashTable+position) != NO_NODE){
+        int node = *(index->hashTable+position);
+        int home = ((index->nodes+node)->mmsi*2654435761u) & index->hashMask;
+        if(((position-home) & index->hashMask) >= ((position-hole) & index->hashMask)){
+            *(index->hashTable+hole) = node;
+            hole = position;
+        }
+        position = (position+1) & index->hashMask;
+    }
+    *(index->hashTable+hole) = NO_NODE;
+}
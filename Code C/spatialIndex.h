@@ -0,0 +1,40 @@
+#ifndef HEADER_SPATIALINDEX
+#define HEADER_SPATIALINDEX
+
+#include <math.h>
+#include <stdlib.h>
+
+#define EARTH_RADIUS_M 6371000.0
+
+struct spatialNode
+{
+    unsigned int mmsi;
+    double latitude, longitude;
+    double timestamp;
+    int cell;
+    int previous, next;
+};
+
+struct spatialIndex
+{
+    double cellSize;
+    int nbLatCells, nbLonCells;
+    int* cells;
+    struct spatialNode* nodes;
+    int maxVessels;
+    int freeNode;
+    int* hashTable;
+    int hashMask;
+    int nbVessels;
+    int nbRejected;
+};
+
+struct spatialIndex* createSpatialIndex(double cellSize, int maxVessels);
+void freeSpatialIndex(struct spatialIndex* index);
+int updateVesselPosition(struct spatialIndex* index, unsigned int mmsi, double latitude, double longitude, double timestamp);
+int removeVesselPosition(struct spatialIndex* index, unsigned int mmsi);
+int expireVesselPositions(struct spatialIndex* index, double minTimestamp);
+int queryBoundingBox(struct spatialIndex* index, double latMin, double latMax, double lonMin, double lonMax, unsigned int* output, int maxOutput);
+int queryRadius(struct spatialIndex* index, double latitude, double longitude, double radius, unsigned int* output, int maxOutput);
+
+#endif
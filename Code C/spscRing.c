@@ -0,0 +1,108 @@
+#include "spscRing.h"
+#include <sched.h>
+
+/*
+Fonction : createSpscRing
+Entrées : nombre d'éléments (arrondi à la puissance de deux supérieure)
+Sorties : la file allouée, NULL en cas d'erreur
+File sans verrou entre un seul producteur et un seul consommateur. Les indices de
+tête (écrit par le consommateur) et de queue (écrit par le producteur) sont sur des
+lignes de cache différentes pour que les deux fils ne se gênent pas.
+*/
+struct spscRing* createSpscRing(size_t capacity){
+    struct spscRing* ring = (struct spscRing*) aligned_alloc(CACHE_LINE_SIZE,sizeof(struct spscRing));
+    if(ring == NULL){
+        return NULL;
+    }
+    size_t size = 2;
+    while(size < capacity){
+        size *= 2;
+    }
+    ring->items = (void**) calloc(size,sizeof(void*));
+    if(ring->items == NULL){
+        free(ring);
+        return NULL;
+    }
+    atomic_init(&ring->head,0);
+    atomic_init(&ring->tail,0);
+    ring->mask = size-1;
+    return ring;
+}
+
+void freeSpscRing(struct spscRing* ring){
+    if(ring == NULL){
+        return;
+    }
+    free(ring->items);
+    free(ring);
+}
+
+/*
+Fonction : spscPush
+Entrées : file, élément
+Sorties : 0 en cas de succès, -1 si la file est pleine
+Appelée uniquement par le producteur.
+*/
+int spscPush(struct spscRing* ring, void* item){
+    size_t tail = atomic_load_explicit(&ring->tail,memory_order_relaxed);
+    if(tail-atomic_load_explicit(&ring->head,memory_order_acquire) > ring->mask){
+        return -1;
+    }
+    *(ring->items+(tail & ring->mask)) = item;
+    atomic_store_explicit(&ring->tail,tail+1,memory_order_release);
+    return 0;
+}
+
+/*
+Fonction : spscPop
+Entrées : file
+Sorties : le plus ancien élément, NULL si la file est vide
+Appelée uniquement par le consommateur.
+*/
+void* spscPop(struct spscRing* ring){
+    size_t head = atomic_load_explicit(&ring->head,memory_order_relaxed);
+    if(head == atomic_load_explicit(&ring->tail,memory_order_acquire)){
+        return NULL;
+    }
+    void* item = *(ring->items+(head & ring->mask));
+    atomic_store_explicit(&ring->head,head+1,memory_order_release);
+    return item;
+}
+
+/*
+Fonction : spscPushWait
+Entrées : file, élément, indicateur d'arrêt (peut être NULL)
+Sorties : 0 en cas de succès, -1 si l'arrêt a été demandé avant que la place se libère
+L'attente tourne d'abord quelques tours puis cède le processeur.
+*/
+int spscPushWait(struct spscRing* ring, void* item, atomic_int* stop){
+    int spin = 0;
+    while(spscPush(ring,item) < 0){
+        if(stop != NULL && atomic_load_explicit(stop,memory_order_relaxed)){
+            return -1;
+        }
+        if(++spin > SPSC_SPIN){
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+/*
+Fonction : spscPopWait
+Entrées : file, indicateur d'arrêt (peut être NULL)
+Sorties : le plus ancien élément, NULL si l'arrêt a été demandé alors que la file était vide
+*/
+void* spscPopWait(struct spscRing* ring, atomic_int* stop){
+    int spin = 0;
+    void* item;
+    while((item = spscPop(ring)) == NULL){
+        if(stop != NULL && atomic_load_explicit(stop,memory_order_relaxed)){
+            return NULL;
+        }
+        if(++spin > SPSC_SPIN){
+            sched_yield();
+        }
+    }
+    return item;
+}
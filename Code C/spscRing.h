@@ -0,0 +1,28 @@
+#ifndef HEADER_SPSCRING
+#define HEADER_SPSCRING
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+#define SPSC_SPIN 256
+
+struct spscRing
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t head;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail;
+    _Alignas(CACHE_LINE_SIZE) size_t mask;
+    void** items;
+};
+
+struct spscRing* createSpscRing(size_t capacity);
+void freeSpscRing(struct spscRing* ring);
+int spscPush(struct spscRing* ring, void* item);
+void* spscPop(struct spscRing* ring);
+int spscPushWait(struct spscRing* ring, void* item, atomic_int* stop);
+void* spscPopWait(struct spscRing* ring, atomic_int* stop);
+
+#endif
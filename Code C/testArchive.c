@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include "testCheck.h"
+#include "archive.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define TEST_ARCHIVE_PATH "testArchive.aisarch"
+#define TEST_START 1700000000.0
+#define TEST_MESSAGES 10000
+#define TEST_VESSELS 50
+
+struct queryResult
+{
+   int count;
+   int mismatches;
+};
+
+void buildMessage(struct aisMessage* message, int i);
+void compareMessage(struct aisMessage* message, void* context);
+void appendTornBlock(const char* path);
+
+/*
+Aller-retour par une archive : des rapports datés en UTC sont écrits en deux
+exécutions (la seconde ouvre l'archive en ajout) séparées par un bloc interrompu,
+comme après un arrêt brutal, puis relus par intervalle de dates et par MMSI. Chaque
+message relu doit être celui qui a été écrit, aux pas de quantification près, les
+blocs hors de l'intervalle doivent être sautés et le bloc interrompu ne doit pas
+cacher les suivants. Rend 1 si une vérification échoue.
+*/
+int main()
+{
+   struct aisMessage message;
+   struct queryResult result;
+   unlink(TEST_ARCHIVE_PATH);
+
+   struct archiveWriter *writer = openArchiveWriter(TEST_ARCHIVE_PATH);
+   check(writer != NULL, "a new archive is created");
+   if(writer == NULL){
+      return(1);
+   }
+   for(int i = 0; i < TEST_MESSAGES/2; i++){
+      buildMessage(&message, i);
+      appendToArchive(writer, &message);
+   }
+   check(closeArchiveWriter(writer) == 0, "the first run is written");
+   appendTornBlock(TEST_ARCHIVE_PATH);
+   writer = openArchiveWriter(TEST_ARCHIVE_PATH);
+   check(writer != NULL, "the archive is reopened for append");
+   if(writer == NULL){
+      return(1);
+   }
+   for(int i = TEST_MESSAGES/2; i < TEST_MESSAGES; i++){
+      buildMessage(&message, i);
+      appendToArchive(writer, &message);
+   }
+   check(closeArchiveWriter(writer) == 0, "the second run is appended");
+
+   struct archiveReader *reader = openArchiveReader(TEST_ARCHIVE_PATH);
+   check(reader != NULL, "the archive is opened for reading");
+   if(reader == NULL){
+      return(1);
+   }
+   memset(&result, 0, sizeof(result));
+   check(queryArchive(reader, 0, 1e12, 0, compareMessage, &result) == TEST_MESSAGES && result.count == TEST_MESSAGES,
+      "every message of both runs is read back");
+   check(result.mismatches == 0, "every message read back matches the one written");
+   check(reader->corruptedRanges == 1 && reader->corruptedBytes == sizeof(struct archiveBlockHeader)+100,
+      "the torn block is skipped and the blocks appended after it are read");
+
+   // Les messages 6000 à 6999, au milieu du second bloc de la seconde exécution
+   memset(&result, 0, sizeof(result));
+   reader->blocksRead = 0;
+   reader->blocksSkipped = 0;
+   check(queryArchive(reader, TEST_START+6000, TEST_START+7000, 0, compareMessage, &result) == 1000 && result.mismatches == 0,
+      "a date range returns exactly its messages");
+   check(reader->blocksRead == 1 && reader->blocksSkipped == 3, "blocks outside the date range are skipped");
+
+   memset(&result, 0, sizeof(result));
+   check(queryArchive(reader, 0, 1e12, 227000007, compareMessage, &result) == TEST_MESSAGES/TEST_VESSELS && result.mismatches == 0,
+      "an MMSI query returns every message of that vessel");
+   check(queryArchive(reader, 0, 1e12, 999999999, compareMessage, &result) == 0, "an unknown MMSI returns nothing");
+   closeArchiveReader(reader);
+
+   unlink(TEST_ARCHIVE_PATH);
+
+   return(reportChecks("testArchive"));
+}
+
+/*
+Fonction : buildMessage
+Entrées : message à remplir, numéro du message
+Sorties :
+Un message par seconde à partir de TEST_START, les navires à tour de rôle.
+*/
+void buildMessage(struct aisMessage* message, int i)
+{
+   message->timestamp = TEST_START+i+0.125;
+   message->messageType = 1+i%3;
+   message->mmsi = 227000000+i%TEST_VESSELS;
+   message->latitude = 47.0+0.0001*i;
+   message->longitude = -6.0-0.00005*i;
+   message->course = (i*7)%3600/10.0;
+}
+
+void compareMessage(struct aisMessage* message, void* context)
+{
+   struct queryResult *result = (struct queryResult*)context;
+   struct aisMessage expected;
+   int i = (int)floor(message->timestamp-TEST_START);
+   buildMessage(&expected, i);
+   if(fabs(message->timestamp-expected.timestamp) > 0.0005 || message->mmsi != expected.mmsi
+      || message->messageType != expected.messageType || fabs(message->latitude-expected.latitude) > 1e-6
+      || fabs(message->longitude-expected.longitude) > 1e-6 || fabs(message->course-expected.course) > 0.05){
+      result->mismatches += 1;
+   }
+   result->count += 1;
+}
+
+/*
+Fonction : appendTornBlock
+Entrées : chemin de l'archive
+Sorties :
+Recopie en fin d'archive l'en-tête du premier bloc suivi de 100 octets de ses
+données : un bloc dont l'écriture a été interrompue.
+*/
+void appendTornBlock(const char* path)
+{
+   uint8_t block[sizeof(struct archiveBlockHeader)+100];
+   FILE *file = fopen(path, "r+b");
+   if(file == NULL){
+      return;
+   }
+   fseek(file, 8, SEEK_SET);
+   if(fread(block, 1, sizeof(block), file) == sizeof(block)){
+      fseek(file, 0, SEEK_END);
+      fwrite(block, 1, sizeof(block), file);
+   }
+   fclose(file);
+}
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include "testCheck.h"
+#include "capture.h"
+#include "complexLib.h"
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+
+#define TEST_CAPTURE_PATH "testCapture.aisiq"
+#define TEST_START 1700000000.0
+#define TEST_RATE 1000000.0
+#define TEST_SAMPLES (5*CAPTURE_CHUNK_SAMPLES/2)
+#define TEST_READ 4096
+
+uint8_t patternValue(long long sample, int channel);
+int compareSamples(struct iqInput* input, long long first, int nbSamples);
+
+/*
+Aller-retour par un enregistrement .aisiq de plusieurs morceaux : des échantillons
+cu8 connus sont écrits à partir d'une date, puis relus après un positionnement par
+date. Le morceau trouvé et les échantillons relus doivent être ceux de la date
+demandée, et une date hors de l'enregistrement doit être refusée. Rend 1 si une
+vérification échoue.
+*/
+int main()
+{
+   unlink(TEST_CAPTURE_PATH);
+   struct captureWriter *writer = createCaptureWriter(TEST_CAPTURE_PATH,TEST_RATE,TEST_START);
+   check(writer != NULL, "a new capture is created");
+   if(writer == NULL){
+      return(reportChecks("testCapture"));
+   }
+   uint8_t *samples = (uint8_t*) malloc(2*TEST_SAMPLES);
+   for(long long i=0; i<TEST_SAMPLES; i++){
+      *(samples+2*i) = patternValue(i,0);
+      *(samples+2*i+1) = patternValue(i,1);
+   }
+   check(appendCaptureSamples(writer,samples,TEST_SAMPLES) == 0, "samples are appended");
+   check(closeCaptureWriter(writer) == 0, "the capture is closed");
+   free(samples);
+
+   struct captureReader *reader = openCaptureReader(TEST_CAPTURE_PATH);
+   check(reader != NULL && reader->nbChunks == 3, "the capture is split into three chunks");
+   if(reader != NULL){
+      double chunkDuration = CAPTURE_CHUNK_SAMPLES/TEST_RATE;
+      check(findCaptureChunk(reader,TEST_START) == 0, "the start date falls in the first chunk");
+      check(findCaptureChunk(reader,TEST_START+chunkDuration-0.001) == 0, "a date just before the second chunk falls in the first one");
+      check(findCaptureChunk(reader,TEST_START+chunkDuration) == 1, "the date of the second chunk falls in it");
+      check(findCaptureChunk(reader,TEST_START+1000) == 2, "a date after the capture falls in the last chunk");
+      closeCaptureReader(reader);
+   }
+
+   struct iqInput *input = openCaptureInput(TEST_CAPTURE_PATH);
+   check(input != NULL, "the capture is opened as an input");
+   if(input != NULL){
+      check(seekCaptureTime(input,TEST_START+1.5) == 0, "a date in the middle of the capture is reached");
+      check(compareSamples(input,1500000,TEST_READ), "samples read after the seek match the date");
+      check(seekCaptureTime(input,TEST_START) == 0, "the start date is reached");
+      check(compareSamples(input,0,TEST_READ), "samples read from the start match");
+      check(seekCaptureTime(input,TEST_START+CAPTURE_CHUNK_SAMPLES/TEST_RATE-TEST_READ/(2*TEST_RATE)) == 0, "a date just before a chunk boundary is reached");
+      check(compareSamples(input,CAPTURE_CHUNK_SAMPLES-TEST_READ/2,TEST_READ), "samples read across the chunk boundary match");
+      check(seekCaptureTime(input,TEST_START-1) == -1, "a date before the capture is refused");
+      check(seekCaptureTime(input,TEST_START+1000) == -1, "a date after the capture is refused");
+      closeIqInput(input);
+   }
+   unlink(TEST_CAPTURE_PATH);
+   return(reportChecks("testCapture"));
+}
+
+/*
+Fonction : patternValue
+Entrées : numéro de l'échantillon, voie (0 pour I, 1 pour Q)
+Sorties : la valeur cu8 écrite pour cet échantillon
+Motif lentement variable, comme un vrai signal, pour que le codage par différences
+soit exercé, mais qui ne se répète pas d'un morceau à l'autre.
+*/
+uint8_t patternValue(long long sample, int channel){
+   if(channel == 0){
+      return (uint8_t)(128+100*sin(sample*0.001)+(sample/CAPTURE_CHUNK_SAMPLES)*7);
+   }
+   return (uint8_t)((sample/16+sample/CAPTURE_CHUNK_SAMPLES) & 0xff);
+}
+
+/*
+Fonction : compareSamples
+Entrées : entrée positionnée, numéro du premier échantillon attendu, nombre d'échantillons
+Sorties : 1 si les échantillons lus sont ceux du motif, 0 sinon
+*/
+int compareSamples(struct iqInput* input, long long first, int nbSamples){
+   struct complex output[TEST_READ];
+   // Une lecture s'arrête à la fin d'un morceau
+   int nbRead = 0;
+   while(nbRead < nbSamples){
+      int count = readIqSamples(input,output+nbRead,nbSamples-nbRead);
+      if(count <= 0){
+         return(0);
+      }
+      nbRead += count;
+   }
+   for(int i=0; i<nbSamples; i++){
+      if(output[i].real != patternValue(first+i,0)-127.5f || output[i].imag != patternValue(first+i,1)-127.5f){
+         return(0);
+      }
+   }
+   return(1);
+}
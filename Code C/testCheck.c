@@ -0,0 +1,28 @@
+#include "testCheck.h"
+
+int nbChecks = 0;
+int nbFailed = 0;
+
+/*
+Fonction : check
+Entrées : résultat de la vérification, description de ce qui est attendu
+Sorties : 
+Compte la vérification ; un échec est décrit sur la sortie d'erreur.
+*/
+void check(int condition, const char* description){
+    nbChecks += 1;
+    if(!condition){
+        nbFailed += 1;
+        fprintf(stderr, "FAILED : %s\n", description);
+    }
+}
+
+/*
+Fonction : reportChecks
+Entrées : nom du test
+Sorties : le code de sortie du test, 1 si une vérification a échoué
+*/
+int reportChecks(const char* name){
+    printf("%s : %d checks, %d failed\n", name, nbChecks, nbFailed);
+    return nbFailed > 0;
+}
@@ -0,0 +1,12 @@
+#ifndef HEADER_TESTCHECK
+#define HEADER_TESTCHECK
+
+#include <stdio.h>
+
+extern int nbChecks;
+extern int nbFailed;
+
+void check(int condition, const char* description);
+int reportChecks(const char* name);
+
+#endif
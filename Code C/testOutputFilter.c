@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include "testCheck.h"
+#include "outputFilter.h"
+#include <stdlib.h>
+#include <math.h>
+
+#define METERS_PER_DEGREE (6371000.0*M_PI/180.0)
+#define VESSEL_A 227000001u
+#define VESSEL_B 227000002u
+#define VESSEL_C 227000003u
+#define VESSEL_D 227000004u
+
+struct filterStep
+{
+   unsigned int mmsi;
+   double timestamp;
+   double latitude, longitude;
+   double course;
+   int expected;
+   const char* description;
+};
+
+void runSteps(struct throttleThresholds thresholds, const struct filterStep* steps, int nbSteps);
+
+/*
+Filtre de sortie par navire, piloté par des tables : chaque ligne est un rapport
+de position et la décision attendue, par rapport au dernier rapport émis pour ce
+MMSI. Les seuils de distance, de cap et d'intervalle sont vérifiés de part et
+d'autre de leur valeur (l'égalité suffit à émettre), à travers l'antiméridien et le
+nord, puis chacun seul. Rend 1 si une vérification échoue.
+*/
+int main()
+{
+   struct throttleThresholds all = {100.0, 10.0, 60.0};
+   const struct filterStep boundaries[] = {
+      {VESSEL_A, 0, 48.0, -5.0, 90.0, 1, "an unknown vessel is emitted"},
+      {VESSEL_A, 1, 48.0, -5.0, 90.0, 0, "an identical report is dropped"},
+      {VESSEL_A, 2, 48.0+99.0/METERS_PER_DEGREE, -5.0, 90.0, 0, "a 99 m move is dropped"},
+      {VESSEL_A, 3, 48.0+101.0/METERS_PER_DEGREE, -5.0, 90.0, 1, "a 101 m move is emitted"},
+      {VESSEL_A, 4, 48.0+101.0/METERS_PER_DEGREE, -5.0, 99.5, 0, "a 9.5 degree turn is dropped"},
+      {VESSEL_A, 5, 48.0+101.0/METERS_PER_DEGREE, -5.0, 100.0, 1, "a 10 degree turn is emitted"},
+      {VESSEL_A, 64, 48.0+101.0/METERS_PER_DEGREE, -5.0, 100.0, 0, "a report 59 s after the last emitted one is dropped"},
+      {VESSEL_A, 65, 48.0+101.0/METERS_PER_DEGREE, -5.0, 100.0, 1, "a report 60 s after the last emitted one is emitted"},
+      {VESSEL_B, 66, 48.0+101.0/METERS_PER_DEGREE, -5.0, 100.0, 1, "another vessel at the same place has its own state"},
+      {VESSEL_B, 67, 48.0+101.0/METERS_PER_DEGREE, -5.0, 100.0, 0, "the other vessel is then throttled"},
+      {VESSEL_A, 10, 48.0+101.0/METERS_PER_DEGREE, -5.0, 100.0, 1, "a report older than the last emitted one is emitted"},
+      {VESSEL_C, 100, 0.0, 179.9998, 350.0, 1, "a vessel near the antimeridian is emitted"},
+      {VESSEL_C, 101, 0.0, -179.9998, 350.0, 0, "crossing the antimeridian by 44 m is dropped"},
+      {VESSEL_C, 102, 0.0, -179.999, 350.0, 1, "crossing the antimeridian by 133 m is emitted"},
+      {VESSEL_C, 103, 0.0, -179.999, 355.0, 0, "a 5 degree turn is dropped"},
+      {VESSEL_C, 104, 0.0, -179.999, 0.0, 1, "a 10 degree turn across north is emitted"},
+      {VESSEL_C, 105, 0.0, -179.999, 360.0, 0, "an unavailable course is not a turn"},
+      {VESSEL_D, 200, 80.0, 10.0, 0.0, 1, "a vessel at 80 degrees north is emitted"},
+      {VESSEL_D, 201, 80.0, 10.005, 0.0, 0, "a 0.005 degree longitude move at 80 degrees north (97 m) is dropped"},
+      {VESSEL_D, 202, 80.0, 10.0055, 0.0, 1, "a 0.0055 degree longitude move at 80 degrees north (106 m) is emitted"},
+   };
+   runSteps(all, boundaries, sizeof(boundaries)/sizeof(*boundaries));
+
+   struct throttleThresholds distanceOnly = {100.0, 0.0, 0.0};
+   const struct filterStep distanceSteps[] = {
+      {VESSEL_A, 0, 48.0, -5.0, 90.0, 1, "an unknown vessel is emitted"},
+      {VESSEL_A, 1000, 48.0, -5.0, 270.0, 0, "without turn and interval thresholds, a half turn an hour later is dropped"},
+      {VESSEL_A, 1001, 48.0, -5.0+101.0/METERS_PER_DEGREE/cos(48.0*M_PI/180.0), 270.0, 1, "a 101 m move east is emitted"},
+   };
+   runSteps(distanceOnly, distanceSteps, sizeof(distanceSteps)/sizeof(*distanceSteps));
+
+   struct throttleThresholds intervalOnly = {0.0, 0.0, 30.0};
+   const struct filterStep intervalSteps[] = {
+      {VESSEL_A, 0, 48.0, -5.0, 90.0, 1, "an unknown vessel is emitted"},
+      {VESSEL_A, 29.5, 49.0, -4.0, 270.0, 0, "without distance and turn thresholds, a large move is dropped"},
+      {VESSEL_A, 30, 49.0, -4.0, 270.0, 1, "the interval reached exactly emits"},
+   };
+   runSteps(intervalOnly, intervalSteps, sizeof(intervalSteps)/sizeof(*intervalSteps));
+
+   struct throttleThresholds none = {0.0, -1.0, 0.0};
+   const struct filterStep noneSteps[] = {
+      {VESSEL_A, 0, 48.0, -5.0, 90.0, 1, "an unknown vessel is emitted"},
+      {VESSEL_A, 0, 48.0, -5.0, 90.0, 1, "without any threshold, an identical report is emitted"},
+   };
+   runSteps(none, noneSteps, sizeof(noneSteps)/sizeof(*noneSteps));
+
+   // Table pleine : un navire évincé est émis de nouveau
+   struct outputFilter *filter = createOutputFilter(all, 1);
+   struct aisMessage message = {0};
+   check(filter != NULL && filter->capacity == FILTER_MAX_PROBE, "the table is rounded up to the probe length");
+   if(filter != NULL){
+      int nbEmitted = 0;
+      for(int v=0; v<=FILTER_MAX_PROBE; v++){
+         message.mmsi = VESSEL_A+v;
+         message.timestamp = v;
+         nbEmitted += shouldEmitMessage(filter, &message);
+      }
+      message.mmsi = VESSEL_A;
+      message.timestamp = FILTER_MAX_PROBE+1;
+      check(nbEmitted == FILTER_MAX_PROBE+1 && shouldEmitMessage(filter, &message) == 1, "the oldest vessel of a full table is evicted and emitted again");
+      check(filter->nbEmitted == FILTER_MAX_PROBE+2 && filter->nbDropped == 0, "emitted and dropped reports are counted");
+      freeOutputFilter(filter);
+   }
+   return(reportChecks("testOutputFilter"));
+}
+
+/*
+Fonction : runSteps
+Entrées : seuils, table des rapports et des décisions attendues, nombre de lignes
+Sorties :
+Une vérification par ligne, sur un filtre neuf, puis une sur les compteurs du filtre.
+*/
+void runSteps(struct throttleThresholds thresholds, const struct filterStep* steps, int nbSteps)
+{
+   struct aisMessage message = {0};
+   struct outputFilter *filter = createOutputFilter(thresholds, 64);
+   int nbEmitted = 0;
+   check(filter != NULL, "a filter is created");
+   if(filter == NULL){
+      return;
+   }
+   for(int s=0; s<nbSteps; s++){
+      message.messageType = 1;
+      message.mmsi = (steps+s)->mmsi;
+      message.timestamp = (steps+s)->timestamp;
+      message.latitude = (steps+s)->latitude;
+      message.longitude = (steps+s)->longitude;
+      message.course = (steps+s)->course;
+      int emitted = shouldEmitMessage(filter, &message);
+      nbEmitted += emitted;
+      check(emitted == (steps+s)->expected, (steps+s)->description);
+   }
+   check(filter->nbEmitted == nbEmitted && filter->nbDropped == nbSteps-nbEmitted, "emitted and dropped reports are counted");
+   freeOutputFilter(filter);
+}
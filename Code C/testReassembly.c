@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include "testCheck.h"
+#include "reassembly.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_TIMEOUT 360.0
+#define TEST_MMSI 227006760u
+#define TEST_PART_SIZE 168
+
+void setUnsigned(int* bits, int start, int end, unsigned int value);
+void setString(int* bits, int start, int end, const char* text);
+void buildType5(int* bits, unsigned int mmsi, const char* name);
+void buildType24(int* bits, unsigned int mmsi, int part, const char* text);
+int addType5(struct reassemblyCache* cache, int sequence, int* bits, int fragmentNumber, double timestamp, struct staticRecord* record);
+
+/*
+Réassemblage des messages statiques : un message de type 5 en deux fragments et un
+message de type 24 en parties A et B sont reçus dans l'ordre, dans le désordre, en
+double et après expiration. Les identifiants de séquence NMEA (0 à 9) sont réutilisés
+au-delà de 9 : un nouveau message sous un identifiant déjà vu doit être réassemblé
+seul, sans reprendre les fragments du précédent. Rend 1 si une vérification échoue.
+*/
+int main()
+{
+   struct staticRecord record;
+   int message[TYPE5_SIZE], other[TYPE5_SIZE];
+   int partA[TEST_PART_SIZE], partB[TEST_PART_SIZE];
+   char name[32];
+   struct reassemblyCache *cache = createReassemblyCache(64, TEST_TIMEOUT);
+   check(cache != NULL && cache->capacity == 64, "a cache of 64 entries is created");
+   if(cache == NULL){
+      return(reportChecks("testReassembly"));
+   }
+
+   // Type 5 dans l'ordre
+   buildType5(message, TEST_MMSI, "NORMANDIE");
+   check(addType5(cache, 1, message, 1, 0, &record) == 0, "the first fragment alone is not a message");
+   memset(&record, 0, sizeof(record));
+   check(addType5(cache, 1, message, 2, 1, &record) == 1, "fragments in order complete the message");
+   check(record.messageType == 5 && record.mmsi == TEST_MMSI && strcmp(record.name, "NORMANDIE") == 0
+         && strcmp(record.callSign, "FNRM") == 0 && strcmp(record.destination, "LE HAVRE") == 0 && record.imo == 9074729
+         && record.shipType == 70 && record.toBow == 120 && record.toStern == 30 && record.toPort == 12 && record.toStarboard == 13,
+         "the reassembled type 5 fields are decoded");
+
+   // Répétitions du message complet
+   check(addType5(cache, 1, message, 1, 2, &record) == 0 && addType5(cache, 1, message, 2, 3, &record) == 0,
+         "a repeated message is returned only once");
+
+   // Type 5 dans le désordre et en double
+   buildType5(other, TEST_MMSI+1, "BRETAGNE");
+   check(addType5(cache, 2, other, 2, 10, &record) == 0, "the last fragment alone is not a message");
+   check(addType5(cache, 2, other, 2, 11, &record) == 0, "a duplicated fragment is ignored");
+   check(addType5(cache, 2, other, 1, 12, &record) == 1 && record.mmsi == TEST_MMSI+1 && strcmp(record.name, "BRETAGNE") == 0,
+         "fragments out of order complete the message");
+
+   // Expiration : le second fragment arrive trop tard
+   buildType5(other, TEST_MMSI+2, "ARMORIQUE");
+   check(addType5(cache, 3, other, 1, 100, &record) == 0, "a first fragment waits for the second");
+   check(addType5(cache, 3, other, 2, 101+TEST_TIMEOUT, &record) == 0, "a fragment after the timeout does not complete an expired message");
+   check(addType5(cache, 3, other, 1, 102+TEST_TIMEOUT, &record) == 1 && record.mmsi == TEST_MMSI+2,
+         "the late fragment starts a new message that can still complete");
+
+   // Identifiants de séquence réutilisés avant l'expiration
+   int nbCompleted = 0, nbMatching = 0;
+   for(int m=0; m<25; m++){
+      snprintf(name, sizeof(name), "VESSEL %d", m);
+      buildType5(other, TEST_MMSI+100+m, name);
+      addType5(cache, m%10, other, 1, 1000+m, &record);
+      if(addType5(cache, m%10, other, 2, 1000+m, &record) == 1){
+         nbCompleted += 1;
+         nbMatching += record.mmsi == TEST_MMSI+100+m && strcmp(record.name, name) == 0;
+      }
+   }
+   check(nbCompleted == 25 && nbMatching == 25, "every message completes when sequence ids wrap around");
+   buildType5(message, TEST_MMSI+200, "SEQUENCE SEVEN");
+   buildType5(other, TEST_MMSI+201, "SEQUENCE SEVEN BIS");
+   check(addType5(cache, 7, message, 1, 1100, &record) == 0, "a message whose second fragment is lost stays pending");
+   check(addType5(cache, 7, other, 1, 1101, &record) == 0, "a new first fragment under the same id replaces it");
+   check(addType5(cache, 7, other, 2, 1102, &record) == 1 && record.mmsi == TEST_MMSI+201 && strcmp(record.name, "SEQUENCE SEVEN BIS") == 0,
+         "the new message is reassembled without the fragments of the lost one");
+
+   // Message reçu en une trame, clé par MMSI
+   buildType5(message, TEST_MMSI+300, "SINGLE");
+   check(addType5Fragment(cache, TEST_MMSI+300, 0, 1, 1, message, TYPE5_SIZE-2, 2000, &record) == 1 && strcmp(record.name, "SINGLE") == 0,
+         "a single frame missing its two spare bits is a complete message");
+   check(addType5Fragment(cache, TEST_MMSI+300, 0, 1, 1, message, TYPE5_SIZE-2, 2001, &record) == 0, "its repetition is ignored");
+   check(addType5Fragment(cache, TEST_MMSI+300, 0, 1, 2, message, FRAGMENT_SIZE-1, 2002, &record) == 0, "a short non-final fragment is refused");
+
+   // Type 24 : parties A et B dans l'ordre, dans le désordre et en double
+   buildType24(partA, TEST_MMSI, 0, "PEN AR BED");
+   buildType24(partB, TEST_MMSI, 1, "FPAB");
+   check(addType24Part(cache, partA, TEST_PART_SIZE, 3000, &record) == 0, "part A alone is not a message");
+   check(addType24Part(cache, partA, TEST_PART_SIZE, 3001, &record) == 0, "a duplicated part A is ignored");
+   memset(&record, 0, sizeof(record));
+   check(addType24Part(cache, partB, TEST_PART_SIZE, 3002, &record) == 1 && record.messageType == 24 && record.mmsi == TEST_MMSI
+         && strcmp(record.name, "PEN AR BED") == 0 && strcmp(record.callSign, "FPAB") == 0 && record.shipType == 60
+         && record.toBow == 40 && record.toStern == 10 && record.toPort == 5 && record.toStarboard == 6,
+         "parts A then B complete the type 24 record");
+   check(addType24Part(cache, partA, TEST_PART_SIZE, 3003, &record) == 0 && addType24Part(cache, partB, TEST_PART_SIZE, 3004, &record) == 0,
+         "a repeated type 24 record is returned only once");
+   buildType24(partA, TEST_MMSI+1, 0, "ENEZ EUSA");
+   buildType24(partB, TEST_MMSI+1, 1, "FENZ");
+   check(addType24Part(cache, partB, TEST_PART_SIZE, 3010, &record) == 0, "part B alone is not a message");
+   check(addType24Part(cache, partA, TEST_PART_SIZE, 3011, &record) == 1 && strcmp(record.name, "ENEZ EUSA") == 0 && strcmp(record.callSign, "FENZ") == 0,
+         "parts B then A complete the type 24 record");
+   check(addType24Part(cache, partB, 161, 3012, &record) == 0, "a truncated part B is refused");
+   buildType24(partA, TEST_MMSI+2, 0, "OUESSANT");
+   buildType24(partB, TEST_MMSI+2, 1, "FOUS");
+   addType24Part(cache, partA, TEST_PART_SIZE, 3020, &record);
+   check(addType24Part(cache, partB, TEST_PART_SIZE, 3021+TEST_TIMEOUT, &record) == 0, "a type 24 part after the timeout does not complete an expired record");
+
+   // Parties orphelines : la mémoire reste celle du départ
+   int nbEvicted = cache->nbEvicted;
+   for(int m=0; m<10000; m++){
+      buildType24(partA, 300000000u+m, 0, "ORPHAN");
+      addType24Part(cache, partA, TEST_PART_SIZE, 4000, &record);
+   }
+   check(cache->capacity == 64 && cache->nbEvicted > nbEvicted, "orphaned parts evict old entries instead of growing the cache");
+   buildType5(message, TEST_MMSI+400, "AFTER FLOOD");
+   addType5(cache, 4, message, 1, 4001, &record);
+   check(addType5(cache, 4, message, 2, 4002, &record) == 1 && strcmp(record.name, "AFTER FLOOD") == 0, "messages still complete after a flood of orphans");
+
+   freeReassemblyCache(cache);
+   return(reportChecks("testReassembly"));
+}
+
+/*
+Fonction : setUnsigned
+Entrées : vecteur de bits, position de départ, position de fin, valeur
+Sorties :
+*/
+void setUnsigned(int* bits, int start, int end, unsigned int value)
+{
+   for(int i=end-1; i>=start; i--){
+      *(bits+i) = value & 1;
+      value >>= 1;
+   }
+}
+
+/*
+Fonction : setString
+Entrées : vecteur de bits, position de départ, position de fin, texte en majuscules
+Sorties :
+Code le texte en ASCII 6 bits AIS, complété par des '@'.
+*/
+void setString(int* bits, int start, int end, const char* text)
+{
+   for(int i=start; i+6<=end; i+=6){
+      int c = *text != '\0' ? *text++ : '@';
+      setUnsigned(bits, i, i+6, c >= 64 ? c-64 : c);
+   }
+}
+
+/*
+Fonction : buildType5
+Entrées : vecteur de TYPE5_SIZE bits, MMSI, nom du navire
+Sorties :
+*/
+void buildType5(int* bits, unsigned int mmsi, const char* name)
+{
+   memset(bits, 0, TYPE5_SIZE*sizeof(int));
+   setUnsigned(bits, 0, 6, 5);
+   setUnsigned(bits, 8, 38, mmsi);
+   setUnsigned(bits, 40, 70, 9074729);
+   setString(bits, 70, 112, "FNRM");
+   setString(bits, 112, 232, name);
+   setUnsigned(bits, 232, 240, 70);
+   setUnsigned(bits, 240, 249, 120);
+   setUnsigned(bits, 249, 258, 30);
+   setUnsigned(bits, 258, 264, 12);
+   setUnsigned(bits, 264, 270, 13);
+   setString(bits, 302, 422, "LE HAVRE");
+}
+
+/*
+Fonction : buildType24
+Entrées : vecteur de TEST_PART_SIZE bits, MMSI, partie (0 pour A, 1 pour B), nom (A) ou indicatif (B)
+Sorties :
+*/
+void buildType24(int* bits, unsigned int mmsi, int part, const char* text)
+{
+   memset(bits, 0, TEST_PART_SIZE*sizeof(int));
+   setUnsigned(bits, 0, 6, 24);
+   setUnsigned(bits, 8, 38, mmsi);
+   setUnsigned(bits, 38, 40, part);
+   if(part == 0){
+      setString(bits, 40, 160, text);
+      return;
+   }
+   setUnsigned(bits, 40, 48, 60);
+   setString(bits, 90, 132, text);
+   setUnsigned(bits, 132, 141, 40);
+   setUnsigned(bits, 141, 150, 10);
+   setUnsigned(bits, 150, 156, 5);
+   setUnsigned(bits, 156, 162, 6);
+}
+
+/*
+Fonction : addType5
+Entrées : cache, identifiant de séquence, message complet, numéro du fragment (1 ou 2), date, enregistrement
+Sorties : la sortie de addType5Fragment pour ce fragment, la source n'étant pas connue
+*/
+int addType5(struct reassemblyCache* cache, int sequence, int* bits, int fragmentNumber, double timestamp, struct staticRecord* record)
+{
+   int offset = (fragmentNumber-1)*FRAGMENT_SIZE;
+   int size = fragmentNumber == 1 ? FRAGMENT_SIZE : TYPE5_SIZE-FRAGMENT_SIZE;
+   return(addType5Fragment(cache, 0, sequence, fragmentNumber, 2, bits+offset, size, timestamp, record));
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include "testCheck.h"
+#include "spatialIndex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_RESULTS 16
+
+int contains(unsigned int* output, int count, unsigned int mmsi);
+
+/*
+Vérifie l'index spatial : déplacement d'un navire d'une cellule à l'autre, requêtes
+par rectangle (y compris à travers l'antiméridien) et par rayon, position non
+disponible, index plein puis libéré par expireVesselPositions. Rend 1 si une
+vérification échoue.
+*/
+int main()
+{
+   struct spatialIndex *index = createSpatialIndex(0.25, 4);
+   unsigned int output[MAX_RESULTS];
+   int count;
+   if(index == NULL){
+      fprintf(stderr, "Cannot create spatial index\n");
+      return(1);
+   }
+
+   // Brest, Ouessant, et deux navires de part et d'autre de l'antiméridien
+   check(updateVesselPosition(index, 1, 48.38, -4.49, 10) == 0, "a vessel is added");
+   check(updateVesselPosition(index, 2, 48.46, -5.10, 10) == 0, "a second vessel is added");
+   check(updateVesselPosition(index, 3, -17.0, 179.9, 10) == 0, "a vessel east of the antimeridian is added");
+   check(updateVesselPosition(index, 4, -17.0, -179.9, 10) == 0, "a vessel west of the antimeridian is added");
+   check(index->nbVessels == 4, "every vessel is counted");
+
+   count = queryBoundingBox(index, 48.0, 49.0, -5.0, -4.0, output, MAX_RESULTS);
+   check(count == 1 && output[0] == 1, "the bounding box only holds the vessels inside it");
+   count = queryBoundingBox(index, -18.0, -16.0, 179.0, -179.0, output, MAX_RESULTS);
+   check(count == 2 && contains(output, count, 3) && contains(output, count, 4), "a bounding box crosses the antimeridian");
+   count = queryBoundingBox(index, -90.0, 90.0, -180.0, 180.0, output, 2);
+   check(count == 4, "the count includes vessels beyond the output size");
+
+   // Environ 46 km entre Brest et Ouessant
+   count = queryRadius(index, 48.38, -4.49, 40000, output, MAX_RESULTS);
+   check(count == 1 && output[0] == 1, "the radius query excludes the farther vessel");
+   count = queryRadius(index, 48.38, -4.49, 50000, output, MAX_RESULTS);
+   check(count == 2, "the radius query includes both vessels");
+   count = queryRadius(index, -17.0, 179.95, 20000, output, MAX_RESULTS);
+   check(count == 2, "a radius query crosses the antimeridian");
+
+   check(updateVesselPosition(index, 1, 43.30, 5.37, 20) == 0, "a vessel moves to another cell");
+   count = queryBoundingBox(index, 48.0, 49.0, -5.0, -4.0, output, MAX_RESULTS);
+   check(count == 0, "the moved vessel has left its old cell");
+   count = queryRadius(index, 43.30, 5.37, 1000, output, MAX_RESULTS);
+   check(count == 1 && output[0] == 1, "the moved vessel is found in its new cell");
+
+   check(updateVesselPosition(index, 5, 0.0, 0.0, 20) == -1 && index->nbRejected == 1, "a full index rejects a new vessel");
+   check(expireVesselPositions(index, 15) == 3 && index->nbVessels == 1, "expireVesselPositions removes the stale vessels");
+   check(updateVesselPosition(index, 5, 0.0, 0.0, 20) == 0, "a freed place is reused");
+   count = queryBoundingBox(index, -90.0, 90.0, -180.0, 180.0, output, MAX_RESULTS);
+   check(count == 2 && contains(output, count, 1) && contains(output, count, 5), "only the remaining vessels are found");
+
+   check(updateVesselPosition(index, 5, 91.0, 181.0, 30) == 0 && index->nbVessels == 1, "an unavailable position removes the vessel");
+   freeSpatialIndex(index);
+
+   return(reportChecks("testSpatialIndex"));
+}
+
+int contains(unsigned int* output, int count, unsigned int mmsi)
+{
+   for(int i = 0; i < count && i < MAX_RESULTS; i++){
+      if(output[i] == mmsi){
+         return 1;
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include "testCheck.h"
+#include "udpOutput.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#define TEST_LOOPBACK "127.0.0.1"
+#define TEST_FRAMES 3
+
+int openReceiver(char* spec, const char* types);
+void buildFrame(int* bits, int nbBits, int type, int seed);
+int receiveAll(int fd, char expected[][UDP_MESSAGE_SIZE], const int* selected, int nbExpected);
+
+/*
+Sortie UDP sur la boucle locale : deux récepteurs sont ouverts sur 127.0.0.1, l'un
+ne recevant que les types 1 à 3, l'autre tous les types. Des trames de types 1, 5
+(sur deux phrases) et 18 sont envoyées sans atteindre le lot ni l'attente maximale :
+rien ne doit partir avant la fermeture, qui doit tout envoyer. Chaque récepteur doit
+alors recevoir un datagramme par message accepté, identique aux phrases NMEA du
+message. Un lot plein doit partir sans attendre. Rend 1 si une vérification échoue.
+*/
+int main()
+{
+   int frameTypes[TEST_FRAMES] = {1, 5, 18};
+   int frameSizes[TEST_FRAMES] = {168, 424, 168};
+   int sequences[TEST_FRAMES] = {0, 1, 1};
+   int filtered[TEST_FRAMES] = {1, 0, 0};
+   int all[TEST_FRAMES] = {1, 1, 1};
+   int bits[TEST_FRAMES][424];
+   char expected[TEST_FRAMES][UDP_MESSAGE_SIZE];
+   char filteredSpec[UDP_NAME_SIZE], allSpec[UDP_NAME_SIZE];
+
+   for(int f=0; f<TEST_FRAMES; f++){
+      buildFrame(bits[f], frameSizes[f], frameTypes[f], f);
+      int length = 0;
+      for(int s=0; s<nmeaSentenceCount(frameSizes[f]); s++){
+         length += encodeNmeaSentence(bits[f], frameSizes[f], s, sequences[f], 'A', expected[f]+length);
+      }
+   }
+
+   int filteredFd = openReceiver(filteredSpec, "/1-3");
+   int allFd = openReceiver(allSpec, "");
+   check(filteredFd >= 0 && allFd >= 0, "two receivers are bound on the loopback");
+   if(filteredFd < 0 || allFd < 0){
+      return(reportChecks("testUdpOutput"));
+   }
+
+   // Lot de 16 messages et une minute d'attente : seule la fermeture envoie
+   struct udpOutput *udp = createUdpOutput(16, 60, 'A');
+   check(udp != NULL, "the UDP output is created");
+   if(udp == NULL){
+      return(reportChecks("testUdpOutput"));
+   }
+   check(addUdpDestination(udp, filteredSpec) == 0, "a destination with a type list is added");
+   check(addUdpDestination(udp, allSpec) == 0, "a destination without a type list is added");
+   check(addUdpDestination(udp, TEST_LOOPBACK ":10110/64") == -1, "a type above 63 is refused");
+   check(addUdpDestination(udp, TEST_LOOPBACK) == -1, "a destination without a port is refused");
+   int nbMatches[TEST_FRAMES];
+   for(int f=0; f<TEST_FRAMES; f++){
+      nbMatches[f] = sendUdpFrame(udp, bits[f], frameSizes[f]);
+   }
+   check(nbMatches[0] == 2 && nbMatches[1] == 1 && nbMatches[2] == 1, "each frame goes to the destinations accepting its type");
+   check(receiveAll(allFd, expected, all, 0) == 0, "nothing is sent before the batch is full or the delay is over");
+   check(closeUdpOutput(udp) == 0, "the output is closed without errors");
+   check(receiveAll(filteredFd, expected, filtered, 1) == 1, "the filtered receiver gets its message at close");
+   check(receiveAll(allFd, expected, all, TEST_FRAMES) == TEST_FRAMES, "the other receiver gets every message at close, in order");
+
+   // Lot de 2 messages : le second envoie le lot
+   udp = createUdpOutput(2, 60, 'A');
+   check(udp != NULL && addUdpDestination(udp, allSpec) == 0, "a second output is created");
+   if(udp != NULL){
+      sendUdpFrame(udp, bits[0], frameSizes[0]);
+      check(receiveAll(allFd, expected, all, 0) == 0, "a message waits for the batch");
+      sendUdpFrame(udp, bits[1], frameSizes[1]);
+      check(receiveAll(allFd, expected, all, 2) == 2, "a full batch is sent at once");
+      check(udp->nbBatches == 1 && udp->nbSyscalls == 1, "a batch is sent by a single call");
+      check(closeUdpOutput(udp) == 0 && receiveAll(allFd, expected, all, 0) == 0, "closing with nothing pending sends nothing");
+   }
+   close(filteredFd);
+   close(allFd);
+   return(reportChecks("testUdpOutput"));
+}
+
+/*
+Fonction : openReceiver
+Entrées : chaîne pour recevoir la destination (adresse:port[/types]), liste de types à ajouter
+Sorties : la socket liée à un port libre de la boucle locale, -1 en cas d'erreur
+*/
+int openReceiver(char* spec, const char* types)
+{
+   struct sockaddr_in address;
+   socklen_t length = sizeof(address);
+   int fd = socket(AF_INET, SOCK_DGRAM, 0);
+   if(fd < 0){
+      return(-1);
+   }
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   if(bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || getsockname(fd, (struct sockaddr*)&address, &length) < 0){
+      close(fd);
+      return(-1);
+   }
+   snprintf(spec, UDP_NAME_SIZE, "%s:%d%s", TEST_LOOPBACK, ntohs(address.sin_port), types);
+   return(fd);
+}
+
+/*
+Fonction : buildFrame
+Entrées : vecteur de bits, nombre de bits, type du message, graine
+Sorties :
+Le type occupe les 6 premiers bits, le reste est un motif propre à chaque trame.
+*/
+void buildFrame(int* bits, int nbBits, int type, int seed)
+{
+   for(int i=0; i<nbBits; i++){
+      *(bits+i) = i < 6 ? (type >> (5-i)) & 1 : ((i*7+seed*13) % 11) < 5;
+   }
+}
+
+/*
+Fonction : receiveAll
+Entrées : socket, messages attendus, indicateurs des messages destinés à cette socket, nombre de datagrammes attendus
+Sorties : nombre de datagrammes reçus conformes, dans l'ordre, aux messages attendus
+Attend chaque datagramme attendu au plus une seconde, puis vérifie qu'aucun autre
+n'est arrivé. Un datagramme inattendu ou différent arrête la lecture.
+*/
+int receiveAll(int fd, char expected[][UDP_MESSAGE_SIZE], const int* selected, int nbExpected)
+{
+   char datagram[UDP_MESSAGE_SIZE+1];
+   struct timeval timeout = {1, 0};
+   int nbReceived = 0;
+   int f = 0;
+   while(1){
+      if(nbReceived == nbExpected){
+         // Les datagrammes sur la boucle locale arrivent aussitôt : une courte attente suffit
+         timeout.tv_sec = 0;
+         timeout.tv_usec = 50000;
+      }
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      ssize_t length = recv(fd, datagram, UDP_MESSAGE_SIZE, 0);
+      if(length < 0){
+         return(nbReceived);
+      }
+      datagram[length] = '\0';
+      while(f < TEST_FRAMES && !selected[f]){
+         f++;
+      }
+      if(nbReceived == nbExpected || f == TEST_FRAMES || strcmp(datagram, expected[f]) != 0){
+         return(-1);
+      }
+      nbReceived++;
+      f++;
+   }
+}
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include "testCheck.h"
+#include "vesselTable.h"
+#include <stdlib.h>
+#include <string.h>
+
+void reportPosition(struct aisMessage* message, unsigned int mmsi, double timestamp, double latitude);
+void countVessel(struct vesselState* state, void* context);
+
+/*
+Vérifie la table des navires : mise à jour et relecture, rapports hors d'ordre,
+âge maximal dans lookupVessel, retrait des navires trop vieux par expireVessels (le
+nombre de navires diminue, les chaînes de sondage restent intactes et les cases sont
+réutilisées) et parcours par forEachVessel. Rend 1 si une vérification échoue.
+*/
+int main()
+{
+   struct vesselTable *table = createVesselTable(64*1024, 600.0);
+   struct vesselState state;
+   struct aisMessage message;
+   int count;
+   if(table == NULL){
+      fprintf(stderr, "Cannot create vessel table\n");
+      return(1);
+   }
+
+   reportPosition(&message, 227000001, 10, 47.0);
+   check(updateVessel(table, &message) == 0, "a new vessel is added");
+   reportPosition(&message, 227000001, 20, 47.5);
+   check(updateVessel(table, &message) == 1, "a known vessel is updated");
+   reportPosition(&message, 227000001, 15, 46.0);
+   updateVessel(table, &message);
+   check(lookupVessel(table, 227000001, 20, &state) == 1 && state.latitude == 47.5 && state.nbReports == 2,
+      "an older report does not overwrite the vessel");
+   check(lookupVessel(table, 227000002, 20, &state) == 0, "an unknown vessel is absent");
+   check(lookupVessel(table, 227000001, 700, &state) == 0, "a vessel older than maxAge is absent");
+
+   // Assez de navires pour que des chaînes de sondage se forment
+   for(int i = 0; i < 200; i++){
+      reportPosition(&message, 228000000+i, i < 100 ? 100 : 500, 48.0);
+      updateVessel(table, &message);
+   }
+   check(atomic_load(&table->nbVessels) == 201, "every vessel is counted");
+   count = 0;
+   check(forEachVessel(table, 400, countVessel, &count) == 100 && count == 100, "forEachVessel skips older vessels");
+
+   count = 0;
+   check(expireVessels(table, 1000, countVessel, &count) == 101 && count == 101, "expireVessels removes vessels older than maxAge");
+   check(atomic_load(&table->nbVessels) == 100, "expired vessels are no longer counted");
+   check(lookupVessel(table, 228000000, 1000, &state) == 0, "an expired vessel is absent");
+   int found = 1;
+   for(int i = 100; i < 200; i++){
+      found &= lookupVessel(table, 228000000+i, 1000, &state) && state.mmsi == 228000000u+i;
+   }
+   check(found, "vessels behind an expired one are still found");
+   count = 0;
+   forEachVessel(table, 0, countVessel, &count);
+   check(count == 100, "forEachVessel skips expired vessels");
+
+   reportPosition(&message, 228000000, 1000, 49.0);
+   check(updateVessel(table, &message) == 0 && atomic_load(&table->nbVessels) == 101, "an expired vessel comes back as a new one");
+   check(lookupVessel(table, 228000000, 1000, &state) == 1 && state.latitude == 49.0 && state.nbReports == 1,
+      "the returning vessel starts a new history");
+   freeVesselTable(table);
+
+   return(reportChecks("testVesselTable"));
+}
+
+void reportPosition(struct aisMessage* message, unsigned int mmsi, double timestamp, double latitude)
+{
+   memset(message, 0, sizeof(struct aisMessage));
+   message->messageType = 1;
+   message->mmsi = mmsi;
+   message->timestamp = timestamp;
+   message->latitude = latitude;
+   message->longitude = -5.0;
+}
+
+void countVessel(struct vesselState* state, void* context)
+{
+   (void)state;
+   *(int*)context += 1;
+}
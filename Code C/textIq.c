@@ -0,0 +1,243 @@
+#include "textIq.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/*
+Fonction : parseTextFloat
+Entrées : début et fin du texte, flottant pour recevoir la valeur
+Sorties : la position après le nombre lu, NULL si aucun nombre n'est lisible
+Lecture d'un nombre décimal (signe, partie entière, partie fractionnaire, exposant)
+sans passer par scanf ni strtod. Les séparateurs (espaces, tabulations, virgules,
+fins de ligne) précédant le nombre sont sautés.
+*/
+const char* parseTextFloat(const char* input, const char* end, float* value){
+    while(input < end && (*input == ' ' || *input == '\t' || *input == ',' || *input == '\r' || *input == '\n')){
+        input += 1;
+    }
+    int negative = 0;
+    if(input < end && (*input == '-' || *input == '+')){
+        negative = *input == '-';
+        input += 1;
+    }
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    int nbDigits = 0;
+    while(input < end && *input >= '0' && *input <= '9'){
+        if(mantissa < 100000000000000000ULL){
+            mantissa = mantissa*10 + (*input-'0');
+        } else {
+            exponent += 1;
+        }
+        nbDigits += 1;
+        input += 1;
+    }
+    if(input < end && *input == '.'){
+        input += 1;
+        while(input < end && *input >= '0' && *input <= '9'){
+            if(mantissa < 100000000000000000ULL){
+                mantissa = mantissa*10 + (*input-'0');
+                exponent -= 1;
+            }
+            nbDigits += 1;
+            input += 1;
+        }
+    }
+    if(nbDigits == 0){
+        return NULL;
+    }
+    if(input < end && (*input == 'e' || *input == 'E')){
+        int negativeExponent = 0;
+        int power = 0;
+        input += 1;
+        if(input < end && (*input == '-' || *input == '+')){
+            negativeExponent = *input == '-';
+            input += 1;
+        }
+        if(input >= end || *input < '0' || *input > '9'){
+            return NULL;
+        }
+        while(input < end && *input >= '0' && *input <= '9'){
+            if(power < 1000){
+                power = power*10 + (*input-'0');
+            }
+            input += 1;
+        }
+        exponent += negativeExponent ? -power : power;
+    }
+
+    double result = (double)mantissa;
+    while(exponent > 22){
+        result *= 1e22;
+        exponent -= 22;
+    }
+    while(exponent < -22){
+        result /= 1e22;
+        exponent += 22;
+    }
+    result = exponent >= 0 ? result*powersOfTen[exponent] : result/powersOfTen[-exponent];
+    *value = negative ? -result : result;
+    return input;
+}
+
+/*
+Fonction : parseTextIq
+Entrées : début et fin du texte, vecteur complexe pour recevoir les échantillons, nombre maximal d'échantillons,
+position pour recevoir l'endroit où la lecture s'est arrêtée
+Sorties : le nombre d'échantillons lus, -1 si le texte contient autre chose que des nombres
+Chaque échantillon est une paire de nombres I et Q (deux colonnes séparées par des espaces).
+*/
+long long parseTextIq(const char* input, const char* end, struct complex* output, long long nbSamples, const char** stop){
+    long long count = 0;
+    while(count < nbSamples){
+        const char* next = parseTextFloat(input,end,&(output+count)->real);
+        if(next == NULL){
+            break;
+        }
+        next = parseTextFloat(next,end,&(output+count)->imag);
+        if(next == NULL){
+            return -1;
+        }
+        input = next;
+        count += 1;
+    }
+    while(count < nbSamples && input < end && (*input == ' ' || *input == '\t' || *input == ',' || *input == '\r' || *input == '\n')){
+        input += 1;
+    }
+    if(count < nbSamples && input < end){
+        return -1;
+    }
+    *stop = input;
+    return count;
+}
+
+/*
+Fonction : convertTextIq
+Entrées : chemin de la capture texte, chemin du fichier binaire cf32 à créer
+Sorties : le nombre d'échantillons convertis, -1 en cas d'erreur
+La capture est projetée en mémoire et convertie par morceaux de TEXT_IQ_CHUNK échantillons.
+*/
+long long convertTextIq(const char* textPath, const char* binaryPath){
+    int fd = open(textPath,O_RDONLY);
+    if(fd < 0){
+        return -1;
+    }
+    struct stat status;
+    if(fstat(fd,&status) < 0 || status.st_size == 0){
+        close(fd);
+        return -1;
+    }
+    const char* map = (const char*) mmap(NULL,status.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(map == MAP_FAILED){
+        return -1;
+    }
+    madvise((void*)map,status.st_size,MADV_SEQUENTIAL);
+
+    FILE* output = fopen(binaryPath,"wb");
+    struct complex* samples = (struct complex*) malloc(TEXT_IQ_CHUNK*sizeof(struct complex));
+    long long total = 0;
+    const char* input = map;
+    const char* end = map+status.st_size;
+    while(output != NULL && samples != NULL){
+        long long count = parseTextIq(input,end,samples,TEXT_IQ_CHUNK,&input);
+        if(count < 0 || fwrite(samples,sizeof(struct complex),count,output) != (size_t)count){
+            total = -1;
+            break;
+        }
+        total += count;
+        if(count < TEXT_IQ_CHUNK){
+            break;
+        }
+    }
+    if(output == NULL || samples == NULL){
+        total = -1;
+    }
+    if(output != NULL && fclose(output) != 0){
+        total = -1;
+    }
+    if(total < 0){
+        remove(binaryPath);
+    }
+    free(samples);
+    munmap((void*)map,status.st_size);
+    return total;
+}
+
+/*
+Fonction : openTextIqInput
+Entrées : chemin de la capture texte
+Sorties : l'entrée ouverte sur le fichier binaire associé, NULL en cas d'erreur
+La capture est convertie une seule fois en un fichier <capture>.cf32 placé à côté ;
+les exécutions suivantes projettent directement ce fichier, tant qu'il est plus
+récent que la capture. Si le dossier de la capture n'est pas accessible en écriture,
+le fichier converti va dans le cache (voir textIqCachePath).
+*/
+struct iqInput* openTextIqInput(const char* path){
+    char sidecar[TEXT_IQ_PATH_SIZE];
+    char cached[TEXT_IQ_PATH_SIZE];
+    struct stat textStatus;
+    struct stat binaryStatus;
+    if(stat(path,&textStatus) < 0 || snprintf(sidecar,sizeof(sidecar),"%s.cf32",path) >= (int)sizeof(sidecar)){
+        return NULL;
+    }
+    int hasCache = textIqCachePath(path,&textStatus,cached,sizeof(cached)) == 0;
+    // Un fichier converti à jour, à côté de la capture ou dans le cache
+    if(stat(sidecar,&binaryStatus) == 0 && binaryStatus.st_mtime >= textStatus.st_mtime){
+        return openIqInput(sidecar,IQ_CF32);
+    }
+    if(hasCache && stat(cached,&binaryStatus) == 0 && binaryStatus.st_mtime >= textStatus.st_mtime){
+        return openIqInput(cached,IQ_CF32);
+    }
+    if(convertTextIq(path,sidecar) > 0){
+        return openIqInput(sidecar,IQ_CF32);
+    }
+    if(hasCache && convertTextIq(path,cached) > 0){
+        fprintf(stderr, "Cannot write %s, converted capture cached in %s\n",sidecar,cached);
+        return openIqInput(cached,IQ_CF32);
+    }
+    return NULL;
+}
+
+/*
+Fonction : textIqCachePath
+Entrées : chemin de la capture texte, son état (stat), chemin à remplir, taille du chemin
+Sorties : 0 en cas de succès, -1 si le dossier du cache ne peut pas être créé
+Le cache est le premier dossier qui peut être créé parmi
+$XDG_CACHE_HOME/aisReceiver, ~/.cache/aisReceiver et /tmp/aisReceiver. Le nom du fichier reprend celui de la capture suivi de son
+périphérique et de son numéro d'inode, pour que deux captures de même nom ne se
+confondent pas.
+*/
+int textIqCachePath(const char* path, struct stat* textStatus, char* output, size_t size){
+    char directory[TEXT_IQ_PATH_SIZE];
+    const char* base = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    int found = 0;
+    if(base != NULL && *base != '\0'){
+        snprintf(directory,sizeof(directory),"%s/aisReceiver",base);
+        found = mkdir(directory,0755) == 0 || errno == EEXIST;
+    }
+    if(!found && home != NULL && *home != '\0'){
+        snprintf(directory,sizeof(directory),"%s/.cache",home);
+        mkdir(directory,0755);
+        snprintf(directory,sizeof(directory),"%s/.cache/aisReceiver",home);
+        found = mkdir(directory,0755) == 0 || errno == EEXIST;
+    }
+    if(!found){
+        snprintf(directory,sizeof(directory),"/tmp/aisReceiver");
+        found = mkdir(directory,0755) == 0 || errno == EEXIST;
+    }
+    if(!found){
+        return -1;
+    }
+    const char* name = strrchr(path,'/') != NULL ? strrchr(path,'/')+1 : path;
+    int length = snprintf(output,size,"%s/%s.%llx-%llx.cf32",directory,name,
+        (unsigned long long)textStatus->st_dev,(unsigned long long)textStatus->st_ino);
+    return length < (int)size ? 0 : -1;
+}
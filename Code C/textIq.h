@@ -0,0 +1,20 @@
+#ifndef HEADER_TEXTIQ
+#define HEADER_TEXTIQ
+
+#include "complexLib.h"
+#include "iqInput.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#define TEXT_IQ_CHUNK 65536
+#define TEXT_IQ_SAMPLE_RATE 31250
+#define TEXT_IQ_PATH_SIZE 1024
+
+const char* parseTextFloat(const char* input, const char* end, float* value);
+long long parseTextIq(const char* input, const char* end, struct complex* output, long long nbSamples, const char** stop);
+long long convertTextIq(const char* textPath, const char* binaryPath);
+struct iqInput* openTextIqInput(const char* path);
+int textIqCachePath(const char* path, struct stat* textStatus, char* output, size_t size);
+
+#endif
@@ -0,0 +1,218 @@
+#include "traffic.h"
+
+int scheduleReport(struct trafficGenerator* traffic, struct trafficVessel* vessel);
+void retireBurst(struct trafficGenerator* traffic, int index);
+
+/*
+Fonction : createTrafficGenerator
+Entrées : nombre de navires, fréquence d'échantillonnage (multiple de 9600 Hz, centrée sur 162 MHz),
+rapports signal sur bruit minimal et maximal (dB, dans une bande de 9600 Hz), décalage de
+fréquence maximal des émetteurs (Hz), graine
+Sorties : le générateur alloué, NULL en cas d'erreur
+Navires de classe A répartis autour du récepteur, à quai ou en route à vitesse et cap
+aléatoires. Chaque navire a son propre rapport signal sur bruit, son
+décalage de fréquence et son retard de propagation.
+*/
+struct trafficGenerator* createTrafficGenerator(int nbVessels, double sampleRate, double minSnr, double maxSnr, double maxOffset, uint64_t seed){
+    int samplesPerBit = (int)llround(sampleRate/bitRate);
+    if(nbVessels < 1 || samplesPerBit*bitRate != sampleRate || fabs(CHANNEL_B_FREQUENCY-TRAFFIC_CENTER_FREQUENCY)+CHANNEL_CUTOFF+maxOffset >= sampleRate/2){
+        return NULL;
+    }
+    struct trafficGenerator* traffic = (struct trafficGenerator*) calloc(1,sizeof(struct trafficGenerator));
+    if(traffic == NULL){
+        return NULL;
+    }
+    traffic->sampleRate = sampleRate;
+    traffic->nbVessels = nbVessels;
+    traffic->maxBursts = 64;
+    traffic->modulator = createGmskModulator(samplesPerBit,0.4);
+    traffic->vessels = (struct trafficVessel*) calloc(nbVessels,sizeof(struct trafficVessel));
+    traffic->bursts = (struct trafficBurst*) calloc(traffic->maxBursts,sizeof(struct trafficBurst));
+    if(traffic->modulator == NULL || traffic->vessels == NULL || traffic->bursts == NULL){
+        freeTrafficGenerator(traffic);
+        return NULL;
+    }
+    seedRandom(&traffic->random,seed,0);
+    struct randomState* random = &traffic->random;
+    for(int v=0; v<nbVessels; v++){
+        struct trafficVessel* vessel = traffic->vessels+v;
+        vessel->mmsi = 200000000+(unsigned int)(randomNext(random)%575000000);
+        double distance = TRAFFIC_RADIUS_NM*sqrt(randomUniform(random));
+        double bearing = 2*M_PI*randomUniform(random);
+        vessel->latitude = TRAFFIC_CENTER_LATITUDE+distance*cos(bearing)/60;
+        vessel->longitude = TRAFFIC_CENTER_LONGITUDE+distance*sin(bearing)/60/cos(TRAFFIC_CENTER_LATITUDE*M_PI/180);
+        vessel->course = floor(randomUniform(random)*3600)/10;
+        // Intervalles de compte rendu de la classe A (UIT-R M.1371) selon la vitesse :
+        // la moitié des navires est à quai, la plupart des autres à moins de 20 noeuds
+        double kind = randomUniform(random);
+        if(kind < 0.5){
+            vessel->speed = 0;
+            vessel->interval = 180;
+        } else {
+            double u = randomUniform(random);
+            vessel->speed = kind < 0.95 ? 2+18*u*u : 23+7*u;
+            vessel->interval = vessel->speed < 14 ? 10 : vessel->speed < 23 ? 6 : 2;
+        }
+        vessel->nextReport = vessel->interval*randomUniform(random);
+        vessel->channel = randomNext(random) >> 63;
+        vessel->snr = minSnr+(maxSnr-minSnr)*randomUniform(random);
+        vessel->frequencyOffset = maxOffset*(2*randomUniform(random)-1);
+        // 1852 m par mille nautique
+        vessel->delay = distance*1852/299792458.0;
+    }
+    return traffic;
+}
+
+void freeTrafficGenerator(struct trafficGenerator* traffic){
+    if(traffic == NULL){
+        return;
+    }
+    for(int b=0; b<traffic->nbBursts; b++){
+        free((traffic->bursts+b)->samples);
+    }
+    freeGmskModulator(traffic->modulator);
+    free(traffic->vessels);
+    free(traffic->bursts);
+    free(traffic);
+}
+
+/*
+Fonction : generateTraffic
+Entrées : générateur, vecteur recevant les échantillons, nombre d'échantillons
+Sorties : le nombre d'échantillons écrits, -1 en cas d'erreur
+Bruit blanc gaussien auquel s'ajoutent les salves commencées dans le bloc ou avant :
+les comptes rendus dont l'heure tombe dans le bloc sont modulés à l'avance, puis
+chaque salve est retirée quand elle est entièrement écrite. Des salves d'une même voie
+qui se recouvrent sont comptées comme collisions.
+*/
+int generateTraffic(struct trafficGenerator* traffic, struct complex* output, int nbSamples){
+    double end = (traffic->position+nbSamples)/traffic->sampleRate;
+    for(int v=0; v<traffic->nbVessels; v++){
+        struct trafficVessel* vessel = traffic->vessels+v;
+        while(vessel->nextReport < end){
+            if(scheduleReport(traffic,vessel) < 0){
+                return -1;
+            }
+        }
+    }
+
+    memset(output,0,nbSamples*sizeof(struct complex));
+    addNoise(&traffic->random,output,nbSamples,TRAFFIC_NOISE_POWER);
+    for(int b=0; b<traffic->nbBursts; b++){
+        struct trafficBurst* burst = traffic->bursts+b;
+        long long first = burst->start > traffic->position ? burst->start : traffic->position;
+        long long last = burst->start+burst->nbSamples < traffic->position+nbSamples ? burst->start+burst->nbSamples : traffic->position+nbSamples;
+        for(long long i=first; i<last; i++){
+            struct complex* sample = burst->samples+(i-burst->start);
+            (output+i-traffic->position)->real += burst->amplitude*sample->real;
+            (output+i-traffic->position)->imag += burst->amplitude*sample->imag;
+        }
+    }
+    traffic->position += nbSamples;
+
+    for(int b=traffic->nbBursts-1; b>=0; b--){
+        if((traffic->bursts+b)->start+(traffic->bursts+b)->nbSamples <= traffic->position){
+            retireBurst(traffic,b);
+        }
+    }
+    return nbSamples;
+}
+
+/*
+Fonction : scheduleReport
+Entrées : générateur, navire dont le compte rendu est dû
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+Le navire avance à l'estime depuis son dernier compte rendu, puis émet un rapport de
+position dans un créneau SOTDMA choisi après l'heure nominale, sur la voie suivante
+(les voies A et B alternent).
+*/
+int scheduleReport(struct trafficGenerator* traffic, struct trafficVessel* vessel){
+    struct randomState* random = &traffic->random;
+    double time = vessel->nextReport;
+    long long slot = (long long)ceil(time/TRAFFIC_SLOT_DURATION)+(long long)(randomUniform(random)*0.2*vessel->interval/TRAFFIC_SLOT_DURATION);
+    double start = slot*TRAFFIC_SLOT_DURATION+vessel->delay;
+
+    if(traffic->nbBursts == traffic->maxBursts){
+        struct trafficBurst* bursts = (struct trafficBurst*) realloc(traffic->bursts,2*traffic->maxBursts*sizeof(struct trafficBurst));
+        if(bursts == NULL){
+            return -1;
+        }
+        traffic->bursts = bursts;
+        traffic->maxBursts *= 2;
+    }
+
+    struct aisMessage message;
+    message.messageType = 1;
+    message.mmsi = vessel->mmsi;
+    message.latitude = round(vessel->latitude*600000)/600000;
+    message.longitude = round(vessel->longitude*600000)/600000;
+    message.course = vessel->course;
+    memset(traffic->payload,0,sizeof(traffic->payload));
+    encodePositionReport(&message,traffic->payload);
+    // État de navigation (5 à quai), vitesse de rotation non disponible, vitesse, cap vrai, seconde UTC
+    setMessageField(traffic->payload,38,42,vessel->speed == 0 ? 5 : 0);
+    setMessageField(traffic->payload,42,50,-128);
+    setMessageField(traffic->payload,50,60,llround(vessel->speed*10));
+    setMessageField(traffic->payload,128,137,llround(vessel->course)%360);
+    setMessageField(traffic->payload,137,143,(long long)start%60);
+    setMessageField(traffic->payload,149,168,randomNext(random) >> 45);
+    // Le tampon de fin du créneau n'est pas émis
+    int length = buildAisPacket(traffic->payload,POSITION_REPORT_BITS,traffic->packet)-PACKET_BUFFER_BITS;
+
+    struct trafficBurst* burst = traffic->bursts+traffic->nbBursts;
+    burst->nbSamples = gmskLength(traffic->modulator,length);
+    burst->samples = (struct complex*) malloc(burst->nbSamples*sizeof(struct complex));
+    if(burst->samples == NULL){
+        return -1;
+    }
+    modulateGmsk(traffic->modulator,traffic->packet,length,burst->samples);
+    double frequency = (vessel->channel ? CHANNEL_B_FREQUENCY : CHANNEL_A_FREQUENCY)-TRAFFIC_CENTER_FREQUENCY+vessel->frequencyOffset;
+    rotateSignal(burst->samples,burst->nbSamples,2*M_PI*randomUniform(random),2*M_PI*frequency/traffic->sampleRate);
+    burst->start = llround(start*traffic->sampleRate);
+    burst->channel = vessel->channel;
+    burst->collided = 0;
+    burst->amplitude = sqrt(pow(10.0,vessel->snr/10)*TRAFFIC_NOISE_POWER*bitRate/traffic->sampleRate);
+    burst->time = start;
+    burst->mmsi = message.mmsi;
+    burst->latitude = message.latitude;
+    burst->longitude = message.longitude;
+    burst->course = message.course;
+    burst->snr = vessel->snr;
+    burst->frequencyOffset = vessel->frequencyOffset;
+    for(int b=0; b<traffic->nbBursts; b++){
+        struct trafficBurst* other = traffic->bursts+b;
+        if(other->channel == burst->channel && other->start < burst->start+burst->nbSamples && burst->start < other->start+other->nbSamples){
+            other->collided = 1;
+            burst->collided = 1;
+        }
+    }
+    traffic->nbBursts += 1;
+
+    // Navigation à l'estime jusqu'au prochain compte rendu
+    double distance = vessel->speed*vessel->interval/3600;
+    vessel->latitude += distance*cos(vessel->course*M_PI/180)/60;
+    vessel->longitude += distance*sin(vessel->course*M_PI/180)/60/cos(vessel->latitude*M_PI/180);
+    vessel->nextReport += vessel->interval;
+    vessel->channel = !vessel->channel;
+    return 0;
+}
+
+/*
+Fonction : retireBurst
+Entrées : générateur, indice d'une salve entièrement écrite
+Sorties :
+Compte la salve et l'écrit dans le journal (date, voie, MMSI, position, cap, rapport
+signal sur bruit, décalage de fréquence, collision).
+*/
+void retireBurst(struct trafficGenerator* traffic, int index){
+    struct trafficBurst* burst = traffic->bursts+index;
+    traffic->nbReports[burst->channel] += 1;
+    traffic->nbCollided[burst->channel] += burst->collided;
+    if(traffic->log != NULL){
+        fprintf(traffic->log,"%.6f,%c,%u,%.6f,%.6f,%.1f,%.1f,%.1f,%d\n",burst->time,burst->channel ? 'B' : 'A',burst->mmsi,
+            burst->latitude,burst->longitude,burst->course,burst->snr,burst->frequencyOffset,burst->collided);
+    }
+    free(burst->samples);
+    *burst = *(traffic->bursts+traffic->nbBursts-1);
+    traffic->nbBursts -= 1;
+}
@@ -0,0 +1,67 @@
+#ifndef HEADER_TRAFFIC
+#define HEADER_TRAFFIC
+
+#include "modulator.h"
+#include "channelModel.h"
+#include "channelizer.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRAFFIC_CENTER_FREQUENCY 162000000.0
+#define TRAFFIC_SLOT_DURATION (60.0/2250)
+#define TRAFFIC_NOISE_POWER 18.0
+#define TRAFFIC_RADIUS_NM 40.0
+#define TRAFFIC_CENTER_LATITUDE 48.38
+#define TRAFFIC_CENTER_LONGITUDE -4.49
+
+struct trafficVessel
+{
+    unsigned int mmsi;
+    double latitude, longitude;
+    double speed, course;
+    double interval;
+    double nextReport;
+    int channel;
+    double snr;
+    double frequencyOffset;
+    double delay;
+};
+
+struct trafficBurst
+{
+    long long start;
+    int nbSamples;
+    int channel;
+    int collided;
+    double amplitude;
+    struct complex* samples;
+    double time;
+    unsigned int mmsi;
+    double latitude, longitude, course;
+    double snr, frequencyOffset;
+};
+
+struct trafficGenerator
+{
+    struct gmskModulator* modulator;
+    struct randomState random;
+    double sampleRate;
+    struct trafficVessel* vessels;
+    int nbVessels;
+    struct trafficBurst* bursts;
+    int nbBursts, maxBursts;
+    long long position;
+    FILE* log;
+    long long nbReports[2];
+    long long nbCollided[2];
+    int payload[POSITION_REPORT_BITS];
+    int packet[MAX_PACKET_BITS];
+};
+
+struct trafficGenerator* createTrafficGenerator(int nbVessels, double sampleRate, double minSnr, double maxSnr, double maxOffset, uint64_t seed);
+void freeTrafficGenerator(struct trafficGenerator* traffic);
+int generateTraffic(struct trafficGenerator* traffic, struct complex* output, int nbSamples);
+
+#endif
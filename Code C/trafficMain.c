@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include "traffic.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+
+#define TRAFFIC_BLOCK_SAMPLES 65536
+
+int writeSigmfMeta(const char* path, const char* datatype, double sampleRate);
+void writeSamples(struct complex* samples, int nbSamples, int cu8, void* buffer, FILE* file);
+double realTime();
+
+/*
+Générateur de trafic AIS : des navires de classe A envoient leurs rapports de position
+sur les voies A et B, au rythme fixé par leur vitesse. Les salves modulées en GMSK,
+décalées en fréquence et éventuellement en collision sont ajoutées à un bruit blanc,
+et le signal centré sur 162 MHz est écrit en cu8 ou cf32 (- pour la sortie standard).
+Un fichier .sigmf-data est accompagné de ses métadonnées, que main sait lire.
+*/
+int main(int argc, char** argv)
+{
+   int option;
+   int nbVessels = 1000;
+   double duration = 60;
+   double sampleRate = 288000;
+   double minSnr = 0, maxSnr = 30;
+   double maxOffset = 500;
+   unsigned long long seed = 1;
+   int cu8 = -1;
+   const char *logPath = NULL;
+   const char *path = "traffic.cu8";
+   while((option = getopt(argc, argv, "d:F:f:l:n:r:s:S:")) != -1){
+      switch(option){
+      case 'd':
+         duration = atof(optarg);
+         break;
+      case 'F':
+         // décalage de fréquence maximal des émetteurs en Hz
+         maxOffset = atof(optarg);
+         break;
+      case 'f':
+         if(strcmp(optarg, "cu8") != 0 && strcmp(optarg, "cf32") != 0){
+            fprintf(stderr, "Unknown IQ format %s (cu8 or cf32)\n", optarg);
+            return(1);
+         }
+         cu8 = strcmp(optarg, "cu8") == 0;
+         break;
+      case 'l':
+         logPath = optarg;
+         break;
+      case 'n':
+         nbVessels = atoi(optarg);
+         break;
+      case 'r':
+         seed = strtoull(optarg, NULL, 10);
+         break;
+      case 's':
+         sampleRate = atof(optarg);
+         break;
+      case 'S':
+         // min:max en dB, dans une bande de 9600 Hz
+         if(sscanf(optarg, "%lf:%lf", &minSnr, &maxSnr) == 1){
+            maxSnr = minSnr;
+         }
+         break;
+      default:
+         fprintf(stderr, "Usage : %s [-n vessels] [-d duration] [-s sample rate] [-f cu8|cf32] [-S min:max snr] [-F max offset] [-r seed] [-l log.csv] [file]\n", argv[0]);
+         return(1);
+      }
+   }
+   if(optind < argc){
+      path = argv[optind];
+   }
+   size_t length = strlen(path);
+   if(cu8 < 0){
+      cu8 = !(length > 5 && strcmp(path+length-5, ".cf32") == 0);
+   }
+   struct trafficGenerator *traffic = createTrafficGenerator(nbVessels, sampleRate, minSnr, maxSnr, maxOffset, seed);
+   if(traffic == NULL){
+      fprintf(stderr, "Cannot create the generator (the sample rate must be a multiple of 9600 Hz and cover both channels)\n");
+      return(1);
+   }
+   FILE *file = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+   if(file == NULL){
+      fprintf(stderr, "Cannot open %s\n", path);
+      freeTrafficGenerator(traffic);
+      return(1);
+   }
+   if(length > 11 && strcmp(path+length-11, ".sigmf-data") == 0 && writeSigmfMeta(path, cu8 ? "cu8" : "cf32_le", sampleRate) < 0){
+      fprintf(stderr, "Cannot write the metadata of %s\n", path);
+   }
+   if(logPath != NULL){
+      traffic->log = fopen(logPath, "w");
+      if(traffic->log == NULL){
+         fprintf(stderr, "Cannot open %s\n", logPath);
+         return(1);
+      }
+      fprintf(traffic->log, "time,channel,mmsi,latitude,longitude,course,snr_db,frequency_offset,collided\n");
+   }
+
+   struct complex *samples = (struct complex*) malloc(TRAFFIC_BLOCK_SAMPLES*sizeof(struct complex));
+   void *buffer = malloc(TRAFFIC_BLOCK_SAMPLES*2*sizeof(float));
+   if(samples == NULL || buffer == NULL){
+      return(1);
+   }
+   long long nbSamples = llround(duration*sampleRate);
+   double start = realTime();
+   for(long long written = 0; written < nbSamples; written += TRAFFIC_BLOCK_SAMPLES){
+      int size = nbSamples-written < TRAFFIC_BLOCK_SAMPLES ? nbSamples-written : TRAFFIC_BLOCK_SAMPLES;
+      if(generateTraffic(traffic, samples, size) < 0){
+         fprintf(stderr, "Out of memory\n");
+         return(1);
+      }
+      writeSamples(samples, size, cu8, buffer, file);
+      if(ferror(file)){
+         fprintf(stderr, "Cannot write %s\n", path);
+         return(1);
+      }
+   }
+   double elapsed = realTime()-start;
+   fflush(file);
+   if(file != stdout){
+      fclose(file);
+   }
+   if(traffic->log != NULL){
+      fclose(traffic->log);
+   }
+   fprintf(stderr, "%d vessels, %.1f s: %lld reports on A (%lld collided), %lld on B (%lld collided), generated in %.2f s (%.1f x real time)\n",
+      nbVessels, nbSamples/sampleRate, traffic->nbReports[0], traffic->nbCollided[0], traffic->nbReports[1], traffic->nbCollided[1],
+      elapsed, elapsed > 0 ? nbSamples/sampleRate/elapsed : 0);
+   freeTrafficGenerator(traffic);
+   free(samples);
+   free(buffer);
+   return(0);
+}
+
+/*
+Fonction : writeSamples
+Entrées : échantillons, nombre d'échantillons, 1 pour cu8 et 0 pour cf32, tampon de conversion, fichier
+Sorties :
+Le signal est à l'échelle de la sortie cu8 de rtl_sdr (centré sur 127,5 et écrêté) ;
+en cf32 il est ramené dans [-1, 1].
+*/
+void writeSamples(struct complex* samples, int nbSamples, int cu8, void* buffer, FILE* file)
+{
+   if(cu8){
+      uint8_t *bytes = (uint8_t*) buffer;
+      for(int i = 0; i < 2*nbSamples; i++){
+         float value = (i%2 == 0 ? (samples+i/2)->real : (samples+i/2)->imag)+127.5f;
+         *(bytes+i) = value <= 0 ? 0 : value >= 255 ? 255 : (uint8_t)(value+0.5f);
+      }
+      fwrite(bytes, 2, nbSamples, file);
+   } else {
+      float *floats = (float*) buffer;
+      for(int i = 0; i < nbSamples; i++){
+         *(floats+2*i) = (samples+i)->real/127.5f;
+         *(floats+2*i+1) = (samples+i)->imag/127.5f;
+      }
+      fwrite(floats, 2*sizeof(float), nbSamples, file);
+   }
+}
+
+/*
+Fonction : writeSigmfMeta
+Entrées : chemin du fichier .sigmf-data, type des échantillons, fréquence d'échantillonnage
+Sorties : 0 en cas de succès, -1 en cas d'erreur
+*/
+int writeSigmfMeta(const char* path, const char* datatype, double sampleRate)
+{
+   char metaPath[1024];
+   size_t length = strlen(path)-strlen(".sigmf-data");
+   if(length+strlen(".sigmf-meta") >= sizeof(metaPath)){
+      return -1;
+   }
+   memcpy(metaPath, path, length);
+   strcpy(metaPath+length, ".sigmf-meta");
+   FILE *meta = fopen(metaPath, "w");
+   if(meta == NULL){
+      return -1;
+   }
+   fprintf(meta, "{\n  \"global\": {\"core:datatype\": \"%s\", \"core:sample_rate\": %.0f, \"core:version\": \"1.0.0\", \"core:description\": \"synthetic AIS traffic\"},\n", datatype, sampleRate);
+   // L'enregistrement est daté du moment où il est généré
+   char datetime[32];
+   time_t now = time(NULL);
+   strftime(datetime, sizeof(datetime), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+   fprintf(meta, "  \"captures\": [{\"core:sample_start\": 0, \"core:frequency\": %.0f, \"core:datetime\": \"%s\"}],\n  \"annotations\": []\n}\n", TRAFFIC_CENTER_FREQUENCY, datetime);
+   return fclose(meta) == 0 ? 0 : -1;
+}
+
+double realTime()
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return now.tv_sec+now.tv_nsec*1e-9;
+}
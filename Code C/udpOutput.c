@@ -0,0 +1,311 @@
+#define _GNU_SOURCE
+#include "udpOutput.h"
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+
+void* runUdpFlusher(void* argument);
+void flushUdpOutput(struct udpOutput* udp);
+int parseUdpTypes(const char* list, uint64_t* types);
+
+/*
+Fonction : createUdpOutput
+Entrées : nombre maximal de messages par envoi, attente maximale d'un message avant envoi (s, 0 pour envoyer
+chaque message aussitôt), voie AIS des phrases
+Sorties : la sortie allouée, NULL en cas d'erreur
+Sortie NMEA par UDP : les phrases !AIVDM sont accumulées puis envoyées par un seul
+appel à sendmmsg, un datagramme par message et par destination. Un fil se charge
+d'envoyer les messages en attente lorsque l'attente maximale est écoulée.
+*/
+struct udpOutput* createUdpOutput(int maxMessages, double maxDelay, char channel){
+    struct udpOutput* udp = (struct udpOutput*) calloc(1,sizeof(struct udpOutput));
+    if(udp == NULL){
+        return NULL;
+    }
+    udp->maxMessages = maxMessages < 1 ? 1 : maxMessages > UDP_MAX_BATCH ? UDP_MAX_BATCH : maxMessages;
+    udp->maxDelay = maxDelay;
+    udp->channel = channel;
+    udp->messages = (char*) malloc((size_t)udp->maxMessages*UDP_MESSAGE_SIZE);
+    udp->vectors = (struct iovec*) calloc((size_t)udp->maxMessages*UDP_MAX_DESTINATIONS,sizeof(struct iovec));
+    udp->datagrams = (struct mmsghdr*) calloc((size_t)udp->maxMessages*UDP_MAX_DESTINATIONS,sizeof(struct mmsghdr));
+    udp->fd = socket(AF_INET,SOCK_DGRAM|SOCK_CLOEXEC,0);
+    if(udp->messages == NULL || udp->vectors == NULL || udp->datagrams == NULL || udp->fd < 0){
+        if(udp->fd >= 0){
+            close(udp->fd);
+        }
+        free(udp->messages);
+        free(udp->vectors);
+        free(udp->datagrams);
+        free(udp);
+        return NULL;
+    }
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes,CLOCK_MONOTONIC);
+    pthread_cond_init(&udp->wake,&attributes);
+    pthread_condattr_destroy(&attributes);
+    pthread_mutex_init(&udp->lock,NULL);
+    if(maxDelay > 0 && pthread_create(&udp->thread,NULL,runUdpFlusher,udp) == 0){
+        udp->started = 1;
+    } else {
+        udp->maxDelay = 0;
+    }
+    return udp;
+}
+
+/*
+Fonction : addUdpDestination
+Entrées : sortie, destination sous la forme adresse:port[/types] (par exemple 239.192.0.1:10110/1-3,18,19)
+Sorties : 0 en cas de succès, -1 si la destination est invalide ou s'il y en a trop
+Sans liste de types, tous les messages sont envoyés à la destination. Pour une
+adresse de multidiffusion, les datagrammes restent sur le lien local et sont aussi
+reçus par la machine elle-même.
+*/
+int addUdpDestination(struct udpOutput* udp, const char* spec){
+    char host[UDP_NAME_SIZE];
+    if(udp->nbDestinations == UDP_MAX_DESTINATIONS || strlen(spec) >= UDP_NAME_SIZE){
+        return -1;
+    }
+    strcpy(host,spec);
+    char* types = strchr(host,'/');
+    if(types != NULL){
+        *types++ = '\0';
+    }
+    char* port = strrchr(host,':');
+    if(port == NULL){
+        return -1;
+    }
+    *port++ = '\0';
+
+    struct udpDestination* destination = udp->destinations+udp->nbDestinations;
+    memset(destination,0,sizeof(struct udpDestination));
+    destination->types = UINT64_MAX;
+    if(types != NULL && parseUdpTypes(types,&destination->types) < 0){
+        return -1;
+    }
+    struct addrinfo hints, *result;
+    memset(&hints,0,sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if(getaddrinfo(host,port,&hints,&result) != 0){
+        return -1;
+    }
+    memcpy(&destination->address,result->ai_addr,sizeof(struct sockaddr_in));
+    freeaddrinfo(result);
+    strcpy(destination->name,spec);
+    if(IN_MULTICAST(ntohl(destination->address.sin_addr.s_addr))){
+        unsigned char ttl = 1, loop = 1;
+        setsockopt(udp->fd,IPPROTO_IP,IP_MULTICAST_TTL,&ttl,sizeof(ttl));
+        setsockopt(udp->fd,IPPROTO_IP,IP_MULTICAST_LOOP,&loop,sizeof(loop));
+    }
+    pthread_mutex_lock(&udp->lock);
+    udp->nbDestinations += 1;
+    pthread_mutex_unlock(&udp->lock);
+    return 0;
+}
+
+/*
+Fonction : sendUdpFrame
+Entrées : sortie, bits de la trame (sans fanions, bourrage ni somme de contrôle), nombre de bits
+Sorties : nombre de destinations auxquelles le message sera envoyé
+Le message est codé une seule fois ; chaque destination dont le filtre accepte son
+type reçoit un datagramme qui pointe sur le même texte. Le lot est envoyé dès qu'il
+est plein.
+*/
+int sendUdpFrame(struct udpOutput* udp, int* bits, int nbBits){
+    int nbSentences = nmeaSentenceCount(nbBits);
+    if(nbSentences == 0){
+        return 0;
+    }
+    int type = 0;
+    for(int i=0; i<6 && i<nbBits; i++){
+        type = (type << 1) | *(bits+i);
+    }
+    pthread_mutex_lock(&udp->lock);
+    char* text = udp->messages+(size_t)udp->nbMessages*UDP_MESSAGE_SIZE;
+    int length = 0;
+    if(nbSentences > 1){
+        udp->sequence = (udp->sequence+1)%10;
+    }
+    for(int s=0; s<nbSentences; s++){
+        length += encodeNmeaSentence(bits,nbBits,s,udp->sequence,udp->channel,text+length);
+    }
+    int nbMatches = 0;
+    for(int d=0; d<udp->nbDestinations; d++){
+        struct udpDestination* destination = udp->destinations+d;
+        // Le type tient sur 6 bits : le masque en a 64, même pour les types non définis
+        if(!(destination->types & (1ull << type))){
+            continue;
+        }
+        struct iovec* vector = udp->vectors+udp->nbDatagrams;
+        struct mmsghdr* datagram = udp->datagrams+udp->nbDatagrams;
+        vector->iov_base = text;
+        vector->iov_len = length;
+        memset(datagram,0,sizeof(struct mmsghdr));
+        datagram->msg_hdr.msg_name = &destination->address;
+        datagram->msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        datagram->msg_hdr.msg_iov = vector;
+        datagram->msg_hdr.msg_iovlen = 1;
+        udp->nbDatagrams += 1;
+        nbMatches += 1;
+    }
+    if(nbMatches > 0){
+        udp->nbMessages += 1;
+        if(udp->nbMessages == 1){
+            udp->firstPending = monotonicTime();
+            pthread_cond_signal(&udp->wake);
+        }
+        if(udp->nbMessages == udp->maxMessages || udp->maxDelay <= 0){
+            flushUdpOutput(udp);
+        }
+    }
+    pthread_mutex_unlock(&udp->lock);
+    return nbMatches;
+}
+
+/*
+Fonction : stopUdpOutput
+Entrées : sortie
+Sorties : 
+Arrête le fil d'envoi et envoie les messages en attente ; les compteurs sont alors
+définitifs.
+*/
+void stopUdpOutput(struct udpOutput* udp){
+    pthread_mutex_lock(&udp->lock);
+    udp->stop = 1;
+    pthread_cond_signal(&udp->wake);
+    pthread_mutex_unlock(&udp->lock);
+    if(udp->started){
+        pthread_join(udp->thread,NULL);
+        udp->started = 0;
+    }
+    flushUdpOutput(udp);
+}
+
+/*
+Fonction : closeUdpOutput
+Entrées : sortie
+Sorties : 0 si tous les datagrammes ont été envoyés, -1 sinon
+*/
+int closeUdpOutput(struct udpOutput* udp){
+    if(udp == NULL){
+        return 0;
+    }
+    stopUdpOutput(udp);
+    int status = 0;
+    for(int d=0; d<udp->nbDestinations; d++){
+        status = (udp->destinations+d)->nbErrors > 0 ? -1 : status;
+    }
+    close(udp->fd);
+    pthread_mutex_destroy(&udp->lock);
+    pthread_cond_destroy(&udp->wake);
+    free(udp->messages);
+    free(udp->vectors);
+    free(udp->datagrams);
+    free(udp);
+    return status;
+}
+
+/*
+Fonction : runUdpFlusher
+Entrées : sortie
+Sorties : NULL
+Dort jusqu'à ce qu'un message soit en attente, puis jusqu'à l'échéance du plus
+ancien ; l'envoi peut entre-temps avoir été fait parce que le lot était plein.
+*/
+void* runUdpFlusher(void* argument){
+    struct udpOutput* udp = (struct udpOutput*) argument;
+    pthread_mutex_lock(&udp->lock);
+    while(!udp->stop){
+        if(udp->nbMessages == 0){
+            pthread_cond_wait(&udp->wake,&udp->lock);
+            continue;
+        }
+        double deadline = udp->firstPending+udp->maxDelay;
+        if(monotonicTime() >= deadline){
+            flushUdpOutput(udp);
+            continue;
+        }
+        struct timespec until;
+        until.tv_sec = (time_t)deadline;
+        until.tv_nsec = (long)((deadline-until.tv_sec)*1e9);
+        pthread_cond_timedwait(&udp->wake,&udp->lock,&until);
+    }
+    pthread_mutex_unlock(&udp->lock);
+    return NULL;
+}
+
+/*
+Fonction : flushUdpOutput
+Entrées : sortie (verrou tenu)
+Sorties :
+sendmmsg s'arrête au premier datagramme refusé : celui-ci est compté en erreur pour
+sa destination et l'envoi reprend au suivant.
+*/
+void flushUdpOutput(struct udpOutput* udp){
+    int sent = 0;
+    while(sent < udp->nbDatagrams){
+        int count = sendmmsg(udp->fd,udp->datagrams+sent,udp->nbDatagrams-sent,0);
+        udp->nbSyscalls += 1;
+        if(count < 0 && errno == EINTR){
+            continue;
+        }
+        int failed = count < 0;
+        count = count < 0 ? 1 : count;
+        for(int i=sent; i<sent+count; i++){
+            struct udpDestination* destination = (struct udpDestination*) ((char*)(udp->datagrams+i)->msg_hdr.msg_name-offsetof(struct udpDestination,address));
+            if(failed){
+                destination->nbErrors += 1;
+            } else {
+                destination->nbMessages += 1;
+            }
+        }
+        sent += count;
+    }
+    if(udp->nbMessages > 0){
+        udp->nbBatches += 1;
+    }
+    udp->nbMessages = 0;
+    udp->nbDatagrams = 0;
+}
+
+/*
+Fonction : parseUdpTypes
+Entrées : liste de types de messages séparés par des virgules, intervalles a-b acceptés, masque à remplir
+Sorties : 0 en cas de succès, -1 si la liste est invalide (types de 0 à 63, comme le champ de 6 bits)
+*/
+int parseUdpTypes(const char* list, uint64_t* types){
+    *types = 0;
+    while(*list != '\0'){
+        char* end;
+        long first = strtol(list,&end,10);
+        long last = first;
+        if(end == list){
+            return -1;
+        }
+        if(*end == '-'){
+            list = end+1;
+            last = strtol(list,&end,10);
+            if(end == list){
+                return -1;
+            }
+        }
+        if(first < 0 || last > 63 || first > last){
+            return -1;
+        }
+        for(long t=first; t<=last; t++){
+            *types |= 1ull << t;
+        }
+        if(*end == ','){
+            end++;
+        } else if(*end != '\0'){
+            return -1;
+        }
+        list = end;
+    }
+    return *types != 0 ? 0 : -1;
+}
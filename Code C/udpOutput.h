@@ -0,0 +1,56 @@
+#ifndef HEADER_UDPOUTPUT
+#define HEADER_UDPOUTPUT
+
+#include "outputWriter.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#define UDP_MAX_DESTINATIONS 8
+#define UDP_MAX_BATCH 1024
+#define UDP_MESSAGE_SIZE (9*NMEA_MAX_SENTENCE)
+#define UDP_NAME_SIZE 64
+
+struct udpDestination
+{
+    char name[UDP_NAME_SIZE];
+    struct sockaddr_in address;
+    uint64_t types;
+    long long nbMessages;
+    long long nbErrors;
+};
+
+struct udpOutput
+{
+    int fd;
+    char channel;
+    int sequence;
+    struct udpDestination destinations[UDP_MAX_DESTINATIONS];
+    int nbDestinations;
+    char* messages;
+    struct iovec* vectors;
+    struct mmsghdr* datagrams;
+    int nbMessages;
+    int nbDatagrams;
+    int maxMessages;
+    double maxDelay;
+    double firstPending;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t thread;
+    int started;
+    int stop;
+    long long nbBatches;
+    long long nbSyscalls;
+};
+
+struct udpOutput* createUdpOutput(int maxMessages, double maxDelay, char channel);
+int addUdpDestination(struct udpOutput* udp, const char* spec);
+int sendUdpFrame(struct udpOutput* udp, int* bits, int nbBits);
+void stopUdpOutput(struct udpOutput* udp);
+int closeUdpOutput(struct udpOutput* udp);
+
+#endif
@@ -0,0 +1,208 @@
+#include "vesselTable.h"
+
+void readBucket(struct vesselBucket* bucket, struct vesselState* output);
+void writeBucket(struct vesselBucket* bucket, struct vesselState* state);
+
+_Static_assert(sizeof(struct vesselBucket) == CACHE_LINE_SIZE, "un navire par ligne de cache");
+
+/*
+Fonction : createVesselTable
+Entrées : budget mémoire en octets, âge maximal d'un navire en secondes
+Sorties : la table allouée, NULL en cas d'erreur
+Le nombre de cases est la plus grande puissance de 2 tenant dans le budget. Chaque
+case occupe exactement une ligne de cache.
+*/
+struct vesselTable* createVesselTable(size_t memoryBudget, double maxAge){
+    struct vesselTable* table = (struct vesselTable*) malloc(sizeof(struct vesselTable));
+    if(table == NULL){
+        return NULL;
+    }
+    table->capacity = VESSEL_MAX_PROBE;
+    while((size_t)table->capacity*2*sizeof(struct vesselBucket) <= memoryBudget){
+        table->capacity *= 2;
+    }
+    table->buckets = (struct vesselBucket*) aligned_alloc(CACHE_LINE_SIZE,table->capacity*sizeof(struct vesselBucket));
+    if(table->buckets == NULL){
+        free(table);
+        return NULL;
+    }
+    memset(table->buckets,0,table->capacity*sizeof(struct vesselBucket));
+    table->maxAge = maxAge;
+    atomic_init(&table->nbVessels,0);
+    atomic_init(&table->nbEvicted,0);
+    return table;
+}
+
+void freeVesselTable(struct vesselTable* table){
+    if(table == NULL){
+        return;
+    }
+    free(table->buckets);
+    free(table);
+}
+
+/*
+Fonction : readBucket
+Entrées : case à lire, état pour recevoir la copie
+Sorties :
+Lecture sans verrou (seqlock) : la copie est recommencée si l'écrivain a modifié
+la case pendant la lecture.
+*/
+void readBucket(struct vesselBucket* bucket, struct vesselState* output){
+    unsigned int before, after;
+    do {
+        before = atomic_load_explicit(&bucket->sequence,memory_order_acquire);
+        memcpy(output,&bucket->state,sizeof(struct vesselState));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&bucket->sequence,memory_order_relaxed);
+    } while((before & 1) || before != after);
+}
+
+/*
+Fonction : writeBucket
+Entrées : case à écrire, nouvel état
+Sorties :
+Le compteur de séquence est impair pendant l'écriture. Un seul écrivain est autorisé.
+*/
+void writeBucket(struct vesselBucket* bucket, struct vesselState* state){
+    unsigned int sequence = atomic_load_explicit(&bucket->sequence,memory_order_relaxed);
+    atomic_store_explicit(&bucket->sequence,sequence+1,memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&bucket->state,state,sizeof(struct vesselState));
+    atomic_store_explicit(&bucket->sequence,sequence+2,memory_order_release);
+}
+
+/*
+Fonction : updateVessel
+Entrées : table, rapport de position décodé
+Sorties : 1 si le navire était déjà connu, 0 s'il vient d'être ajouté
+À n'appeler que depuis le thread du décodeur. Une case libérée par expireVessels ou
+un navire plus vieux que maxAge peut être réutilisé ; si le voisinage de sondage est
+plein, le navire le moins récemment mis à jour est évincé.
+*/
+int updateVessel(struct vesselTable* table, struct aisMessage* message){
+    unsigned int hash = message->mmsi*2654435761u;
+    int mask = table->capacity-1;
+    int candidate = -1;
+    int oldest = -1;
+    struct vesselState state;
+
+    for(int p=0; p<VESSEL_MAX_PROBE; p++){
+        int index = (hash+p) & mask;
+        struct vesselState* current = &(table->buckets+index)->state;
+        if(current->mmsi == 0){
+            if(candidate < 0){
+                candidate = index;
+            }
+            break;
+        }
+        if(current->mmsi == message->mmsi){
+            if(message->timestamp < current->timestamp){
+                return 1;
+            }
+            state = *current;
+            state.messageType = message->messageType;
+            state.timestamp = message->timestamp;
+            state.latitude = message->latitude;
+            state.longitude = message->longitude;
+            state.course = message->course;
+            state.nbReports += 1;
+            writeBucket(table->buckets+index,&state);
+            return 1;
+        }
+        if(current->mmsi == VESSEL_EXPIRED || message->timestamp-current->timestamp > table->maxAge){
+            if(candidate < 0){
+                candidate = index;
+            }
+            continue;
+        }
+        if(oldest < 0 || current->timestamp < (table->buckets+oldest)->state.timestamp){
+            oldest = index;
+        }
+    }
+
+    if(candidate < 0){
+        candidate = oldest;
+        atomic_fetch_add_explicit(&table->nbEvicted,1,memory_order_relaxed);
+    } else if((table->buckets+candidate)->state.mmsi == 0 || (table->buckets+candidate)->state.mmsi == VESSEL_EXPIRED){
+        atomic_fetch_add_explicit(&table->nbVessels,1,memory_order_relaxed);
+    }
+    state.mmsi = message->mmsi;
+    state.messageType = message->messageType;
+    state.timestamp = message->timestamp;
+    state.latitude = message->latitude;
+    state.longitude = message->longitude;
+    state.course = message->course;
+    state.nbReports = 1;
+    writeBucket(table->buckets+candidate,&state);
+    return 0;
+}
+
+/*
+Fonction : lookupVessel
+Entrées : table, MMSI recherché, date courante, état pour recevoir la sortie
+Sorties : 1 si le navire est présent, 0 sinon
+Utilisable depuis n'importe quel thread, sans verrou. Un navire sans nouvelles depuis
+plus de maxAge secondes est considéré comme absent.
+*/
+int lookupVessel(struct vesselTable* table, unsigned int mmsi, double now, struct vesselState* output){
+    unsigned int hash = mmsi*2654435761u;
+    int mask = table->capacity-1;
+    for(int p=0; p<VESSEL_MAX_PROBE; p++){
+        readBucket(table->buckets+((hash+p) & mask),output);
+        if(output->mmsi == 0){
+            return 0;
+        }
+        if(output->mmsi == mmsi){
+            return now-output->timestamp <= table->maxAge;
+        }
+    }
+    return 0;
+}
+
+/*
+Fonction : expireVessels
+Entrées : table, date courante, fonction appelée pour chaque navire retiré (peut être NULL), contexte passé à la fonction
+Sorties : le nombre de navires retirés
+À n'appeler que depuis le thread du décodeur. Les navires plus vieux que maxAge sont
+marqués VESSEL_EXPIRED plutôt que vidés : les chaînes de sondage des autres navires
+restent intactes, et la case est réutilisée par updateVessel.
+*/
+int expireVessels(struct vesselTable* table, double now, void (*callback)(struct vesselState*, void*), void* context){
+    int count = 0;
+    for(int i=0; i<table->capacity; i++){
+        struct vesselState state = (table->buckets+i)->state;
+        if(state.mmsi == 0 || state.mmsi == VESSEL_EXPIRED || now-state.timestamp <= table->maxAge){
+            continue;
+        }
+        if(callback != NULL){
+            callback(&state,context);
+        }
+        state.mmsi = VESSEL_EXPIRED;
+        writeBucket(table->buckets+i,&state);
+        count += 1;
+    }
+    atomic_fetch_sub_explicit(&table->nbVessels,count,memory_order_relaxed);
+    return count;
+}
+
+/*
+Fonction : forEachVessel
+Entrées : table, date minimale de dernière mise à jour, fonction appelée pour chaque navire, contexte passé à la fonction
+Sorties : le nombre de navires parcourus
+Utilisable depuis n'importe quel thread, sans verrou. Chaque navire est une copie
+cohérente, mais l'ensemble n'est pas un instantané global de la table.
+*/
+int forEachVessel(struct vesselTable* table, double minTimestamp, void (*callback)(struct vesselState*, void*), void* context){
+    int count = 0;
+    struct vesselState state;
+    for(int i=0; i<table->capacity; i++){
+        readBucket(table->buckets+i,&state);
+        if(state.mmsi == 0 || state.mmsi == VESSEL_EXPIRED || state.timestamp < minTimestamp){
+            continue;
+        }
+        callback(&state,context);
+        count += 1;
+    }
+    return count;
+}
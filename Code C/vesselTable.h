@@ -0,0 +1,45 @@
+#ifndef HEADER_VESSELTABLE
+#define HEADER_VESSELTABLE
+
+#include "aisdecode.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LINE_SIZE 64
+#define VESSEL_MAX_PROBE 32
+#define VESSEL_EXPIRED 0xFFFFFFFFu
+
+struct vesselState
+{
+    unsigned int mmsi;
+    int messageType;
+    double timestamp;
+    double latitude, longitude;
+    float course;
+    unsigned int nbReports;
+};
+
+struct vesselBucket
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_uint sequence;
+    struct vesselState state;
+};
+
+struct vesselTable
+{
+    struct vesselBucket* buckets;
+    int capacity;
+    double maxAge;
+    atomic_int nbVessels;
+    atomic_int nbEvicted;
+};
+
+struct vesselTable* createVesselTable(size_t memoryBudget, double maxAge);
+void freeVesselTable(struct vesselTable* table);
+int updateVessel(struct vesselTable* table, struct aisMessage* message);
+int lookupVessel(struct vesselTable* table, unsigned int mmsi, double now, struct vesselState* output);
+int expireVessels(struct vesselTable* table, double now, void (*callback)(struct vesselState*, void*), void* context);
+int forEachVessel(struct vesselTable* table, double minTimestamp, void (*callback)(struct vesselState*, void*), void* context);
+
+#endif